@@ -0,0 +1,412 @@
+#include "profiling.hpp"
+
+//--------------------------------------------------------------------------------
+// End to end benchmark of Grid::next_iteration() on a set of standard workloads. Every workload runs with every
+// thread count of the sweep (strong scaling) and random soups additionally grow with the thread count, so that the
+// work per thread stays the same (weak scaling). We report generations/s, cells/s, the time spent in each phase of an
+// iteration and the parallel efficiency, as a table and as JSON and CSV files. Every workload also runs with every
+// temporal block size of the sweep, so the temporally blocked engine can be compared with the exchange per generation.
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cmath>
+#include <cstdlib>
+
+#include "grid.hpp"
+#include "patterns.hpp"
+
+int main(int argc, char** argv);
+
+//--------------------------------------------------------------------------------
+struct Benchmark_Options {
+	std::vector<std::string> patterns = { "default", "r-pentomino", "acorn", "gosper-gun" };
+	std::vector<int> soup_sizes = { 256, 1024, 4096, 16384 };
+	std::vector<unsigned int> thread_counts = {};
+	std::vector<int> temporal_block_sizes = { 1 };
+	// side length of the weak scaling soup for the smallest thread count, 0 disables the weak scaling sweep.
+	int weak_scaling_base_size = 1024;
+	std::size_t pattern_generations = 2000;
+	std::size_t soup_generations = 100;
+	// every run gets repeated this many times, we keep the fastest one.
+	int number_of_repetitions = 1;
+	bool should_update_coordinates = false;
+	std::string json_path = "benchmark.json";
+	std::string csv_path = "benchmark.csv";
+};
+
+struct Benchmark_Workload {
+	std::string name;
+	// "strong" or "weak"
+	std::string scaling;
+	// side length of random soups in cells, 0 for patterns.
+	int soup_size;
+	std::size_t number_of_generations;
+	// generations per Grid::next_iteration() call, see Grid::temporal_block_size.
+	int temporal_block_size;
+};
+
+struct Benchmark_Result {
+	Benchmark_Workload workload;
+	unsigned int number_of_threads;
+	double seconds;
+	double generations_per_second;
+	double cells_per_second;
+	std::size_t population;
+	std::size_t number_of_chunks;
+	// summed over all generations of the run.
+	Grid_Phase_Timings phase_timings;
+	double speedup;
+	double efficiency;
+};
+
+void print_usage();
+bool parse_options(int argc, char** argv, Benchmark_Options& options);
+std::vector<std::string> split(const std::string& text, char separator);
+std::unique_ptr<Grid> create_grid_for_workload(const Benchmark_Workload& workload, std::shared_ptr<OpenCLContext> opencl_context);
+Benchmark_Result run_workload(const Benchmark_Workload& workload, unsigned int number_of_threads, const Benchmark_Options& options, std::shared_ptr<OpenCLContext> opencl_context);
+void set_scaling_metrics(std::vector<Benchmark_Result>& results_of_workload);
+void write_json(const std::vector<Benchmark_Result>& results, const std::string& path);
+void write_csv(const std::vector<Benchmark_Result>& results, const std::string& path);
+
+//--------------------------------------------------------------------------------
+void print_usage() {
+	std::cout << "Usage: grid_of_life_benchmark [options]\n"
+		<< "  --patterns LIST          comma separated list of default, none or the built in patterns (r-pentomino, acorn, gosper-gun, ...)\n"
+		<< "  --soup-sizes LIST        comma separated side lengths of 50% random soups, none for no soups\n"
+		<< "                           (default 256,1024,4096,16384, the largest one needs about 3 GB of memory)\n"
+		<< "  --threads LIST           comma separated thread counts (default 1,2,4,... up to the hardware threads)\n"
+		<< "  --temporal-blocks LIST   comma separated temporal block sizes from 1 to 16 (default 1)\n"
+		<< "  --weak-base N            weak scaling soup size for the smallest thread count, 0 disables it (default 1024)\n"
+		<< "  --pattern-generations N  generations per pattern run (default 2000)\n"
+		<< "  --soup-generations N     generations per soup run (default 100)\n"
+		<< "  --repetitions N          runs per workload and thread count, the fastest is reported (default 1)\n"
+		<< "  --with-coordinates       also extract the coordinates of the alive cells, like the renderer needs\n"
+		<< "  --json PATH              where to write the JSON results (default benchmark.json)\n"
+		<< "  --csv PATH               where to write the CSV results (default benchmark.csv)\n";
+}
+
+std::vector<std::string> split(const std::string& text, char separator) {
+	std::vector<std::string> parts;
+	std::stringstream stream(text);
+	std::string part;
+	while (std::getline(stream, part, separator)) {
+		if (!part.empty()) {
+			parts.push_back(part);
+		}
+	}
+	return parts;
+}
+
+bool parse_options(int argc, char** argv, Benchmark_Options& options) {
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		if (argument == "--help" || argument == "-h") {
+			return false;
+		}
+		if (argument == "--with-coordinates") {
+			options.should_update_coordinates = true;
+			continue;
+		}
+		if (i + 1 >= argc) {
+			std::cout << "Missing value for option " << argument << std::endl;
+			return false;
+		}
+		std::string value = argv[++i];
+		if (argument == "--patterns") {
+			options.patterns.clear();
+			for (const std::string& pattern: split(value, ',')) {
+				if (pattern == "none") {
+					continue;
+				}
+				if (pattern != "default" && get_pattern_cells(pattern).empty()) {
+					std::cout << "Unknown pattern " << pattern << std::endl;
+					return false;
+				}
+				options.patterns.push_back(pattern);
+			}
+		} else if (argument == "--soup-sizes") {
+			options.soup_sizes.clear();
+			for (const std::string& size: split(value, ',')) {
+				if (size != "none") {
+					options.soup_sizes.push_back(std::atoi(size.c_str()));
+				}
+			}
+		} else if (argument == "--threads") {
+			options.thread_counts.clear();
+			for (const std::string& number_of_threads: split(value, ',')) {
+				options.thread_counts.push_back(static_cast<unsigned int>(std::max(1, std::atoi(number_of_threads.c_str()))));
+			}
+		} else if (argument == "--temporal-blocks") {
+			options.temporal_block_sizes.clear();
+			for (const std::string& temporal_block_size: split(value, ',')) {
+				options.temporal_block_sizes.push_back(std::clamp(std::atoi(temporal_block_size.c_str()), 1, MAXIMUM_TEMPORAL_BLOCK_SIZE));
+			}
+		} else if (argument == "--weak-base") {
+			options.weak_scaling_base_size = std::atoi(value.c_str());
+		} else if (argument == "--pattern-generations") {
+			options.pattern_generations = std::strtoull(value.c_str(), nullptr, 10);
+		} else if (argument == "--soup-generations") {
+			options.soup_generations = std::strtoull(value.c_str(), nullptr, 10);
+		} else if (argument == "--repetitions") {
+			options.number_of_repetitions = std::max(1, std::atoi(value.c_str()));
+		} else if (argument == "--json") {
+			options.json_path = value;
+		} else if (argument == "--csv") {
+			options.csv_path = value;
+		} else {
+			std::cout << "Unknown option " << argument << std::endl;
+			return false;
+		}
+	}
+
+	if (options.thread_counts.empty()) {
+		unsigned int hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+		for (unsigned int number_of_threads = 1; number_of_threads < hardware_threads; number_of_threads *= 2) {
+			options.thread_counts.push_back(number_of_threads);
+		}
+		options.thread_counts.push_back(hardware_threads);
+	}
+	std::sort(options.thread_counts.begin(), options.thread_counts.end());
+	options.thread_counts.erase(std::unique(options.thread_counts.begin(), options.thread_counts.end()), options.thread_counts.end());
+	return true;
+}
+
+//--------------------------------------------------------------------------------
+std::unique_ptr<Grid> create_grid_for_workload(const Benchmark_Workload& workload, std::shared_ptr<OpenCLContext> opencl_context) {
+	ZoneScopedFrame;
+
+	bool is_default_pattern = workload.name == "default";
+	std::unique_ptr<Grid> grid = std::make_unique < Grid > (opencl_context, is_default_pattern);
+	if (workload.soup_size > 0) {
+		grid->create_random_soup(workload.soup_size, 0.5f, 1);
+	} else if (!is_default_pattern) {
+		for (auto [row, column]: get_pattern_cells(workload.name)) {
+			grid->set_cell_alive(row, column);
+		}
+		grid->finish_pattern_creation();
+	}
+	return grid;
+}
+
+Benchmark_Result run_workload(const Benchmark_Workload& workload, unsigned int number_of_threads, const Benchmark_Options& options, std::shared_ptr<OpenCLContext> opencl_context) {
+	ZoneScopedFrame;
+
+	Benchmark_Result best_result = {};
+	for (int repetition = 0; repetition < options.number_of_repetitions; repetition++) {
+		std::unique_ptr<Grid> grid = create_grid_for_workload(workload, opencl_context);
+		grid->set_number_of_threads(number_of_threads);
+		grid->should_update_coordinates_of_alive_cells = options.should_update_coordinates;
+
+		Benchmark_Result result = {};
+		result.workload = workload;
+		result.number_of_threads = number_of_threads;
+
+		double number_of_simulated_cells = 0.0;
+		// next_iteration() does not advance the iteration of an empty grid, so a workload which dies ends early.
+		std::size_t generation = 0;
+		std::size_t start_iteration = grid->iteration;
+		auto start_time = std::chrono::steady_clock::now();
+		while (generation < workload.number_of_generations && !grid->chunks.empty()) {
+			// the last block shrinks to end on number_of_generations.
+			std::size_t number_of_generations = std::min<std::size_t>(workload.temporal_block_size, workload.number_of_generations - generation);
+			grid->temporal_block_size = static_cast<int>(number_of_generations);
+			number_of_simulated_cells += static_cast<double>(grid->chunks.size()) * Chunk::rows * Chunk::columns * number_of_generations;
+			grid->next_iteration();
+			generation += number_of_generations;
+
+			const Grid_Phase_Timings& timings = grid->phase_timings;
+			result.phase_timings.update_neighbour_count_and_set_info += timings.update_neighbour_count_and_set_info;
+			result.phase_timings.create_needed_chunks += timings.create_needed_chunks;
+			result.phase_timings.update_neighbours += timings.update_neighbours;
+			result.phase_timings.update_cells += timings.update_cells;
+			result.phase_timings.remove_empty_chunks += timings.remove_empty_chunks;
+			result.phase_timings.sort_chunks += timings.sort_chunks;
+			result.phase_timings.update_coordinates_of_alive_cells += timings.update_coordinates_of_alive_cells;
+		}
+		auto end_time = std::chrono::steady_clock::now();
+
+		result.seconds = std::chrono::duration<double>(end_time - start_time).count();
+		result.generations_per_second = result.seconds > 0.0 ? (grid->iteration - start_iteration) / result.seconds : 0.0;
+		result.cells_per_second = result.seconds > 0.0 ? number_of_simulated_cells / result.seconds : 0.0;
+		result.population = grid->generation_statistics.population;
+		result.number_of_chunks = grid->chunks.size();
+
+		if (repetition == 0 || result.seconds < best_result.seconds) {
+			best_result = result;
+		}
+	}
+	return best_result;
+}
+
+// results_of_workload holds the runs of a single workload, sorted by the number of threads. The run with the fewest
+// threads is the baseline.
+void set_scaling_metrics(std::vector<Benchmark_Result>& results_of_workload) {
+	ZoneScopedFrame;
+
+	if (results_of_workload.empty()) {
+		return;
+	}
+	const Benchmark_Result& baseline = results_of_workload.front();
+	for (Benchmark_Result& result: results_of_workload) {
+		double thread_ratio = static_cast<double>(result.number_of_threads) / baseline.number_of_threads;
+		if (result.workload.scaling == "strong") {
+			// same work with more threads, ideally the time goes down linearly.
+			result.speedup = result.seconds > 0.0 ? baseline.seconds / result.seconds : 0.0;
+		} else {
+			// the work grows with the number of threads, ideally the throughput goes up linearly.
+			result.speedup = baseline.cells_per_second > 0.0 ? result.cells_per_second / baseline.cells_per_second : 0.0;
+		}
+		result.efficiency = result.speedup / thread_ratio;
+	}
+}
+
+//--------------------------------------------------------------------------------
+void write_json(const std::vector<Benchmark_Result>& results, const std::string& path) {
+	ZoneScopedFrame;
+
+	std::ofstream file(path);
+	if (!file) {
+		std::cout << "Failed to open " << path << " for writing." << std::endl;
+		return;
+	}
+	file << std::setprecision(6);
+	file << "{\n";
+	file << "  \"benchmark\": \"grid_next_iteration\",\n";
+	file << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+	file << "  \"results\": [\n";
+	for (std::size_t i = 0; i < results.size(); i++) {
+		const Benchmark_Result& result = results[i];
+		const Grid_Phase_Timings& timings = result.phase_timings;
+		file << "    { \"workload\": \"" << result.workload.name << "\""
+			<< ", \"scaling\": \"" << result.workload.scaling << "\""
+			<< ", \"soup_size\": " << result.workload.soup_size
+			<< ", \"generations\": " << result.workload.number_of_generations
+			<< ", \"temporal_block_size\": " << result.workload.temporal_block_size
+			<< ", \"threads\": " << result.number_of_threads
+			<< ", \"seconds\": " << result.seconds
+			<< ", \"generations_per_second\": " << result.generations_per_second
+			<< ", \"cells_per_second\": " << result.cells_per_second
+			<< ", \"population\": " << result.population
+			<< ", \"chunks\": " << result.number_of_chunks
+			<< ", \"speedup\": " << result.speedup
+			<< ", \"efficiency\": " << result.efficiency
+			<< ", \"phase_seconds\": {"
+			<< " \"update_neighbour_count_and_set_info\": " << timings.update_neighbour_count_and_set_info
+			<< ", \"create_needed_chunks\": " << timings.create_needed_chunks
+			<< ", \"update_neighbours\": " << timings.update_neighbours
+			<< ", \"update_cells\": " << timings.update_cells
+			<< ", \"remove_empty_chunks\": " << timings.remove_empty_chunks
+			<< ", \"sort_chunks\": " << timings.sort_chunks
+			<< ", \"update_coordinates_of_alive_cells\": " << timings.update_coordinates_of_alive_cells
+			<< " } }" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	file << "  ]\n";
+	file << "}\n";
+}
+
+void write_csv(const std::vector<Benchmark_Result>& results, const std::string& path) {
+	ZoneScopedFrame;
+
+	std::ofstream file(path);
+	if (!file) {
+		std::cout << "Failed to open " << path << " for writing." << std::endl;
+		return;
+	}
+	file << std::setprecision(6);
+	file << "workload,scaling,soup_size,generations,temporal_block_size,threads,seconds,generations_per_second,cells_per_second,population,chunks,speedup,efficiency,"
+		<< "update_neighbour_count_and_set_info_seconds,create_needed_chunks_seconds,update_neighbours_seconds,update_cells_seconds,"
+		<< "remove_empty_chunks_seconds,sort_chunks_seconds,update_coordinates_of_alive_cells_seconds\n";
+	for (const Benchmark_Result& result: results) {
+		const Grid_Phase_Timings& timings = result.phase_timings;
+		file << result.workload.name << "," << result.workload.scaling << "," << result.workload.soup_size << ","
+			<< result.workload.number_of_generations << "," << result.workload.temporal_block_size << "," << result.number_of_threads << "," << result.seconds << ","
+			<< result.generations_per_second << "," << result.cells_per_second << "," << result.population << ","
+			<< result.number_of_chunks << "," << result.speedup << "," << result.efficiency << ","
+			<< timings.update_neighbour_count_and_set_info << "," << timings.create_needed_chunks << ","
+			<< timings.update_neighbours << "," << timings.update_cells << "," << timings.remove_empty_chunks << ","
+			<< timings.sort_chunks << "," << timings.update_coordinates_of_alive_cells << "\n";
+	}
+}
+
+//--------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+	Benchmark_Options options;
+	if (!parse_options(argc, argv, options)) {
+		print_usage();
+		return -1;
+	}
+
+	// the benchmark has no OpenCL support, the context stays invalid.
+	std::shared_ptr<OpenCLContext> opencl_context = std::make_shared < OpenCLContext > ();
+
+	// every strong scaling workload runs unchanged with every thread count.
+	std::vector<Benchmark_Workload> strong_scaling_workloads;
+	for (const std::string& pattern: options.patterns) {
+		for (int temporal_block_size: options.temporal_block_sizes) {
+			strong_scaling_workloads.push_back({ pattern, "strong", 0, options.pattern_generations, temporal_block_size });
+		}
+	}
+	for (int soup_size: options.soup_sizes) {
+		for (int temporal_block_size: options.temporal_block_sizes) {
+			strong_scaling_workloads.push_back({ "soup", "strong", soup_size, options.soup_generations, temporal_block_size });
+		}
+	}
+
+	std::cout << std::left << std::setw(14) << "workload" << std::setw(8) << "scaling" << std::right << std::setw(8) << "size"
+		<< std::setw(7) << "block" << std::setw(9) << "threads" << std::setw(12) << "seconds" << std::setw(14) << "generations/s" << std::setw(12) << "cells/s"
+		<< std::setw(10) << "speedup" << std::setw(12) << "efficiency" << std::endl;
+
+	auto print_result = [](const Benchmark_Result& result) {
+		std::cout << std::left << std::setw(14) << result.workload.name << std::setw(8) << result.workload.scaling
+			<< std::right << std::setw(8) << result.workload.soup_size << std::setw(7) << result.workload.temporal_block_size << std::setw(9) << result.number_of_threads
+			<< std::fixed << std::setprecision(3) << std::setw(12) << result.seconds
+			<< std::setprecision(1) << std::setw(14) << result.generations_per_second
+			<< std::scientific << std::setprecision(2) << std::setw(12) << result.cells_per_second
+			<< std::fixed << std::setprecision(2) << std::setw(10) << result.speedup << std::setw(12) << result.efficiency
+			<< std::defaultfloat << std::endl;
+	};
+
+	std::vector<Benchmark_Result> results;
+	for (const Benchmark_Workload& workload: strong_scaling_workloads) {
+		std::vector<Benchmark_Result> results_of_workload;
+		for (unsigned int number_of_threads: options.thread_counts) {
+			results_of_workload.push_back(run_workload(workload, number_of_threads, options, opencl_context));
+		}
+		set_scaling_metrics(results_of_workload);
+		for (const Benchmark_Result& result: results_of_workload) {
+			print_result(result);
+			results.push_back(result);
+		}
+	}
+
+	for (int temporal_block_size: options.temporal_block_sizes) {
+		if (options.weak_scaling_base_size <= 0) {
+			break;
+		}
+		// the area of the soup grows linearly with the number of threads.
+		std::vector<Benchmark_Result> results_of_workload;
+		for (unsigned int number_of_threads: options.thread_counts) {
+			double area_factor = static_cast<double>(number_of_threads) / options.thread_counts.front();
+			int soup_size = static_cast<int>(std::lround(options.weak_scaling_base_size * std::sqrt(area_factor)));
+			Benchmark_Workload workload = { "soup", "weak", soup_size, options.soup_generations, temporal_block_size };
+			results_of_workload.push_back(run_workload(workload, number_of_threads, options, opencl_context));
+		}
+		set_scaling_metrics(results_of_workload);
+		for (const Benchmark_Result& result: results_of_workload) {
+			print_result(result);
+			results.push_back(result);
+		}
+	}
+
+	write_json(results, options.json_path);
+	write_csv(results, options.csv_path);
+	std::cout << "wrote " << options.json_path << " and " << options.csv_path << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+//--------------------------------------------------------------------------------
+// Index of the lowest and of the highest set bit, bits must not be 0. _bit_scan_forward/_bit_scan_reverse only exist
+// with GCC and Clang, MSVC has _BitScanForward/_BitScanReverse instead.
+inline int find_lowest_set_bit(std::uint32_t bits) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, bits);
+	return static_cast<int>(index);
+#else
+	return __builtin_ctz(bits);
+#endif
+}
+
+inline int find_highest_set_bit(std::uint32_t bits) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanReverse(&index, bits);
+	return static_cast<int>(index);
+#else
+	return 31 - __builtin_clz(bits);
+#endif
+}
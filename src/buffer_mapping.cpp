@@ -0,0 +1,29 @@
+#include "buffer_mapping.hpp"
+
+#include <algorithm>
+
+
+//--------------------------------------------------------------------------------
+void* map_orphaned_buffer(GLenum target, GLuint buffer, std::size_t size) {
+	ZoneScopedFrame;
+
+	glBindBuffer(target, buffer);
+	GLsizeiptr buffer_size = static_cast<GLsizeiptr>(std::max<std::size_t>(size, 1));
+	glBufferData(target, buffer_size, nullptr, GL_STREAM_DRAW);
+	void* data = glMapBufferRange(target, 0, buffer_size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	glBindBuffer(target, 0);
+	return data;
+}
+
+bool unmap_buffer(GLenum target, GLuint buffer) {
+	ZoneScopedFrame;
+
+	glBindBuffer(target, buffer);
+	bool is_valid = glUnmapBuffer(target) == GL_TRUE;
+	glBindBuffer(target, 0);
+	return is_valid;
+}
+
+bool has_current_opengl_context() {
+	return glfwGetCurrentContext() != nullptr;
+}
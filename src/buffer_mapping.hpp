@@ -0,0 +1,21 @@
+#pragma once
+
+#include "profiling.hpp"
+#include "opengl.hpp"
+
+#include <cstddef>
+
+
+//--------------------------------------------------------------------------------
+// Orphans the storage of the buffer bound to target with glBufferData and maps the fresh storage for writing, so the
+// driver hands us new memory while the draws of the previous frames still read the old one. Returns nullptr if the
+// storage can not be mapped. Leaves nothing bound to target.
+void* map_orphaned_buffer(GLenum target, GLuint buffer, std::size_t size);
+
+// Returns false if the contents got lost while the buffer was mapped (eg the screen mode changed), the caller skips a
+// frame then. Leaves nothing bound to target.
+bool unmap_buffer(GLenum target, GLuint buffer);
+
+// The context may already be gone when the renderer gets destroyed after the window, the destructors of the GL objects
+// only delete them while it still exists.
+bool has_current_opengl_context();
@@ -3,7 +3,7 @@
 
 //--------------------------------------------------------------------------------
 float clip(float value, float lower, float higher) {
-	ZoneScoped;
+	ZoneScopedFrame;
 	assert(lower <= higher); 
 
 	// dont do anything if lower > higher.
@@ -35,7 +35,7 @@ Camera::Camera() :
 
 //--------------------------------------------------------------------------------
 glm::mat4 Camera::get_view_matrix() {
-	ZoneScoped;
+	ZoneScopedFrame;
 
 	glm::vec3 front_direction = glm::normalize(target_position - position);
 	glm::vec3 up_direction = glm::vec3(0.0f, 1.0f, 0.0f);
@@ -46,7 +46,7 @@ glm::mat4 Camera::get_view_matrix() {
 
 //--------------------------------------------------------------------------------
 glm::mat4 Camera::get_projection_matrix(int viewport_width, int viewport_height) {
-	ZoneScoped;
+	ZoneScopedFrame;
 
 	return glm::perspective(glm::radians(fov), static_cast<float>(viewport_width) / static_cast<float>(viewport_height), 0.3f, 10000.0f);
 }
@@ -72,7 +72,7 @@ void Camera::rotate_around_y_axis(double dt) {
 
 //--------------------------------------------------------------------------------
 void Camera::move_in_current_direction(double dt) {
-	ZoneScoped;
+	ZoneScopedFrame;
 
 	float movement_speed = 100.0f * static_cast<float>(dt);
 	glm::vec3 dposition = glm::vec3(0.0f);
@@ -1,7 +1,7 @@
 #pragma once
 
 //--------------------------------------------------------------------------------
-#include <tracy/Tracy.hpp>
+#include "profiling.hpp"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -0,0 +1,200 @@
+#include "checkpoint.hpp"
+
+#include "grid.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+
+
+//--------------------------------------------------------------------------------
+Grid_Checkpointer::Grid_Checkpointer() :
+	busy_capture_memory(0),
+should_stop(false),
+reference_iteration(0),
+has_reference_iteration(false)
+{
+	ZoneScopedFrame;
+
+	free_captures.push_back(std::make_shared < Grid_Snapshot_Capture > ());
+	free_captures.push_back(std::make_shared < Grid_Snapshot_Capture > ());
+	writer_thread = std::thread(&Grid_Checkpointer::run_writer, this);
+}
+
+Grid_Checkpointer::~Grid_Checkpointer() {
+	ZoneScopedFrame;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		should_stop = true;
+	}
+	condition.notify_all();
+	writer_thread.join();
+}
+
+bool Grid_Checkpointer::update(Grid& grid, const Grid_Checkpoint_Settings& settings) {
+	ZoneScopedFrame;
+
+	// the capture of the previous checkpoint got completed by the generation which just ran.
+	submit_complete_capture();
+
+	if (settings.interval == 0) {
+		return false;
+	}
+	if (!has_reference_iteration || grid.iteration < reference_iteration) {
+		// the first update or a replaced grid, count from here. The checkpoints land on multiples of the interval.
+		reference_iteration = grid.iteration;
+		has_reference_iteration = true;
+		return false;
+	}
+	if (grid.iteration / settings.interval <= reference_iteration / settings.interval) {
+		return false;
+	}
+
+	std::size_t maximum_capture_memory = settings.maximum_capture_memory_mb == 0 ? SIZE_MAX : settings.maximum_capture_memory_mb << 20;
+	std::size_t capture_memory = grid.chunks.size() * (sizeof(Snapshot_Chunk_Entry) + sizeof(Snapshot_Bitmap));
+	std::unique_ptr<Checkpoint_Job> job = std::make_unique < Checkpoint_Job > ();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (capture_memory > maximum_capture_memory) {
+			status.error_message = "checkpoint skipped, capturing " + std::to_string(grid.chunks.size()) + " chunks needs " + std::to_string(capture_memory >> 20)
+				+ " MB but the captures may only use " + std::to_string(settings.maximum_capture_memory_mb) + " MB";
+			reference_iteration = grid.iteration;
+			return false;
+		}
+		if (capturing_job || pending_job || free_captures.empty() || busy_capture_memory + capture_memory > maximum_capture_memory) {
+			// both buffers are busy or the capture does not fit next to the one being written, try again after the next
+			// generation.
+			return false;
+		}
+		job->capture = std::move(free_captures.back());
+		free_captures.pop_back();
+
+		// the free buffers keep the capacity of earlier, bigger grids, give it back where it would exceed the bound.
+		std::size_t available_memory = maximum_capture_memory - busy_capture_memory;
+		if (get_grid_snapshot_capture_memory(*job->capture) > available_memory) {
+			*job->capture = Grid_Snapshot_Capture();
+		}
+		for (std::shared_ptr<Grid_Snapshot_Capture>& free_capture: free_captures) {
+			if (std::max(capture_memory, get_grid_snapshot_capture_memory(*job->capture)) + get_grid_snapshot_capture_memory(*free_capture) > available_memory) {
+				*free_capture = Grid_Snapshot_Capture();
+			}
+		}
+	}
+
+	// only marks the chunks, the next generation copies them.
+	job->capture_start_time = std::chrono::steady_clock::now();
+	grid.begin_snapshot_capture(job->capture);
+	double capture_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - job->capture_start_time).count();
+
+	char file_name[64];
+	std::snprintf(file_name, sizeof(file_name), "checkpoint_%012llu.snap", static_cast<unsigned long long>(grid.iteration));
+	job->path = settings.directory.empty() ? std::string(file_name) : (std::filesystem::path(settings.directory) / file_name).string();
+	job->retention = settings.retention;
+	reference_iteration = grid.iteration;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		status.last_capture_seconds = capture_seconds;
+		busy_capture_memory += get_grid_snapshot_capture_memory(*job->capture);
+	}
+	capturing_job = std::move(job);
+	// a grid without chunks is captured right away.
+	submit_complete_capture();
+	return true;
+}
+
+void Grid_Checkpointer::finish_capture(Grid& grid) {
+	ZoneScopedFrame;
+
+	grid.finish_snapshot_capture();
+	submit_complete_capture();
+}
+
+void Grid_Checkpointer::wait_until_idle() {
+	ZoneScopedFrame;
+
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		condition.wait(lock, [this]() { return !pending_job && !status.is_writing; });
+		if (!capturing_job || !capturing_job->capture->is_complete) {
+			return;
+		}
+		// the writer was still busy with the previous checkpoint when the capture got complete.
+		pending_job = std::move(capturing_job);
+		condition.notify_all();
+	}
+}
+
+void Grid_Checkpointer::submit_complete_capture() {
+	if (!capturing_job || !capturing_job->capture->is_complete) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (pending_job) {
+			// the writer picks the pending one up right away, try again on the next update().
+			return;
+		}
+		pending_job = std::move(capturing_job);
+	}
+	condition.notify_all();
+}
+
+Grid_Checkpoint_Status Grid_Checkpointer::get_status() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return status;
+}
+
+void Grid_Checkpointer::run_writer() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		condition.wait(lock, [this]() { return should_stop || pending_job; });
+		if (!pending_job) {
+			return;
+		}
+		std::unique_ptr<Checkpoint_Job> job = std::move(pending_job);
+		status.is_writing = true;
+		lock.unlock();
+
+		std::string error_message;
+		std::filesystem::path directory_path = std::filesystem::path(job->path).parent_path();
+		std::error_code error_code;
+		if (!directory_path.empty()) {
+			std::filesystem::create_directories(directory_path, error_code);
+		}
+		bool is_written = write_grid_snapshot(job->path, *job->capture, true, error_message);
+		double latency_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - job->capture_start_time).count();
+
+		// rotate the files outside of the lock, deleting can take a while on some file systems.
+		std::vector<std::string> paths_to_remove;
+		lock.lock();
+		if (is_written) {
+			// a replaced grid can reach the same iteration again, the file then got overwritten in place.
+			written_paths.erase(std::remove(written_paths.begin(), written_paths.end(), job->path), written_paths.end());
+			written_paths.push_back(job->path);
+			while (written_paths.size() > std::max<std::size_t>(job->retention, 1)) {
+				paths_to_remove.push_back(written_paths.front());
+				written_paths.pop_front();
+			}
+			status.number_of_checkpoints++;
+			status.last_iteration = job->capture->iteration;
+			status.last_latency_seconds = latency_seconds;
+			status.last_path = job->path;
+			status.error_message.clear();
+		} else {
+			status.error_message = error_message;
+		}
+		lock.unlock();
+		for (const std::string& path: paths_to_remove) {
+			std::filesystem::remove(path, error_code);
+		}
+
+		lock.lock();
+		busy_capture_memory -= get_grid_snapshot_capture_memory(*job->capture);
+		free_captures.push_back(std::move(job->capture));
+		status.is_writing = false;
+		condition.notify_all();
+	}
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "profiling.hpp"
+#include "snapshot.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Grid;
+
+
+//--------------------------------------------------------------------------------
+struct Grid_Checkpoint_Settings {
+	// number of generations between two checkpoints, 0 disables checkpointing.
+	std::size_t interval = 0;
+	// number of checkpoint files which are kept, older ones get deleted.
+	std::size_t retention = 3;
+	// the checkpoints are written to <directory>/checkpoint_<iteration>.snap, the working directory if empty.
+	std::string directory = "";
+	// bound of the memory of all capture buffers together, 0 for no bound. Every capture is a full copy of the chunk
+	// bitmaps, about 1 KB per chunk, so a grid above the bound does not get checkpointed at all.
+	std::size_t maximum_capture_memory_mb = 0;
+};
+
+struct Grid_Checkpoint_Status {
+	std::size_t number_of_checkpoints = 0;
+	std::size_t last_iteration = 0;
+	// how long the simulation was blocked to start the capture of the last checkpoint, the copy of the cells happens
+	// in the update tasks of the next generation.
+	double last_capture_seconds = 0.0;
+	// from the start of the capture until the last checkpoint was synced to the disk.
+	double last_latency_seconds = 0.0;
+	bool is_writing = false;
+	std::string last_path;
+	// error of the last failed checkpoint, empty if the last one succeeded.
+	std::string error_message;
+};
+
+//--------------------------------------------------------------------------------
+// Writes periodic snapshots of a grid without stalling the simulation on the disk or on copying the cells. A due
+// checkpoint only starts a copy-on-write capture (see Grid::begin_snapshot_capture()), the update tasks of the next
+// generation copy every chunk bitmap right before they overwrite it, and a later update() hands the complete capture to
+// a background thread, which sorts, writes, syncs and rotates the files. There are two capture buffers, so one
+// checkpoint can be captured while the previous one is still being written, they hold up to two extra copies of the
+// cells together. If Grid_Checkpoint_Settings::maximum_capture_memory_mb bounds the buffers, a due checkpoint which does
+// not fit next to the one being written is postponed to the next update() instead of blocking, one which does not fit
+// at all is skipped with an error.
+class Grid_Checkpointer {
+public:
+	Grid_Checkpointer();
+
+	// finishes the checkpoints which are already handed to the writer, a capture which is still open gets dropped.
+	~Grid_Checkpointer();
+
+	Grid_Checkpointer(const Grid_Checkpointer&) = delete;
+
+	Grid_Checkpointer& operator = (const Grid_Checkpointer&) = delete;
+
+	// call after every generation, hands a complete capture to the writer and starts capturing grid if a checkpoint is
+	// due. Returns true if it started a capture. A checkpoint is due once the iteration crossed a multiple of the
+	// interval, so with Grid::temporal_block_size K > 1 it lands on the first iteration at or after the multiple.
+	bool update(Grid& grid, const Grid_Checkpoint_Settings& settings);
+
+	// completes the open capture of grid right away and hands it to the writer, for a grid which does not advance for a
+	// while (paused or at the end of a run).
+	void finish_capture(Grid& grid);
+
+	// blocks until all checkpoints which got handed to the writer are written, call finish_capture() first.
+	void wait_until_idle();
+
+	Grid_Checkpoint_Status get_status() const;
+
+private:
+	struct Checkpoint_Job {
+		std::shared_ptr<Grid_Snapshot_Capture> capture;
+		std::string path;
+		std::size_t retention = 0;
+		std::chrono::steady_clock::time_point capture_start_time;
+	};
+
+	// moves capturing_job to the writer once its capture is complete.
+	void submit_complete_capture();
+
+	void run_writer();
+	//--------------------------------------------------------------------------------
+	// data
+	mutable std::mutex mutex;
+	std::condition_variable condition;
+
+	std::vector<std::shared_ptr<Grid_Snapshot_Capture>> free_captures;
+	// of the captures which are being captured, pending or being written.
+	std::size_t busy_capture_memory;
+	// only used by the simulation thread, the capture is shared with the grid until it is complete.
+	std::unique_ptr<Checkpoint_Job> capturing_job;
+	std::unique_ptr<Checkpoint_Job> pending_job;
+	bool should_stop;
+
+	// the iteration of the last capture or of the first update, a smaller grid iteration means the grid got replaced.
+	std::size_t reference_iteration;
+	bool has_reference_iteration;
+
+	std::deque<std::string> written_paths;
+	Grid_Checkpoint_Status status;
+
+	std::thread writer_thread;
+};
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+
+
+//--------------------------------------------------------------------------------
+// The checksum of a set of alive cells is the sum (mod 2^64) of a well mixed 64 bit hash of every alive cell. The sum
+// does not depend on the order in which we visit the cells, so Grid (chunk by chunk, in any chunk order) and the
+// Reference_Grid (in hash set order) compute the same value for the same state.
+inline std::uint64_t get_alive_cell_hash(int row, int column) {
+	// splitmix64 finaliser over the packed coordinates.
+	std::uint64_t value = (static_cast<std::uint64_t>(static_cast<std::uint32_t>(row)) << 32) | static_cast<std::uint32_t>(column);
+	value += 0x9E3779B97F4A7C15ull;
+	value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+	value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+	return value ^ (value >> 31);
+}
@@ -10,9 +10,15 @@ has_alive_cells(false),
 cells_data({}),
 neighbour_count_data({}),
 coordinates_of_alive_cells({}),
-number_of_alive_cells(0)
+number_of_alive_cells(0),
+population(0),
+number_of_births(0),
+number_of_deaths(0),
+row_occupancy_mask(0),
+column_occupancy_mask(0),
+snapshot_bitmap_index(NO_SNAPSHOT_BITMAP)
 {
-	ZoneScoped;
+	ZoneScopedChunk;
 }
 
 Chunk::Chunk(const Coordinate& coord, Coordinate origin_coord, const std::vector<std::pair<int, int>>& alive_cells_coordinates) :
@@ -24,26 +30,34 @@ has_alive_cells(false),
 cells_data({}),
 neighbour_count_data({}),
 coordinates_of_alive_cells({}),
-number_of_alive_cells(0)
+number_of_alive_cells(0),
+population(0),
+number_of_births(0),
+number_of_deaths(0),
+row_occupancy_mask(0),
+column_occupancy_mask(0),
+snapshot_bitmap_index(NO_SNAPSHOT_BITMAP)
 {
-	ZoneScoped;
+	ZoneScopedChunk;
 
 	has_alive_cells = alive_cells_coordinates.size() > 0;
 	for (auto [r, c]: alive_cells_coordinates) {
 		cells_data[r*Chunk::rows + c] = 0xFF;
+		row_occupancy_mask |= 1u << r;
+		column_occupancy_mask |= 1u << c;
 	}
 }
 
 
 Coordinate Chunk::transform_to_world_coordinate(Coordinate chunk_coord) {
-	ZoneScoped;
+	ZoneScopedCell;
 
 	return Coordinate(chunk_coord.x + chunk_origin_row, chunk_coord.y + chunk_origin_column);
 }
 
 
 void Chunk::update_neighbour_count_left_side(const std::array<unsigned char, Chunk::rows>& data) {
-	ZoneScoped;
+	ZoneScopedChunk;
 
 	if (data[0]) {
 		neighbour_count_data[0]++;
@@ -66,7 +80,7 @@ void Chunk::update_neighbour_count_left_side(const std::array<unsigned char, Chu
 }
 
 void Chunk::update_neighbour_count_right_side(const std::array<unsigned char, Chunk::rows>& data) {
-	ZoneScoped;
+	ZoneScopedChunk;
 
 	if (data[0]) {
 		neighbour_count_data[0 + Chunk::columns - 1]++;
@@ -88,7 +102,7 @@ void Chunk::update_neighbour_count_right_side(const std::array<unsigned char, Ch
 }
 
 void Chunk::update_neighbour_count_top_side(const std::array<unsigned char, Chunk::columns>& data) {
-	ZoneScoped;
+	ZoneScopedChunk;
 
 	const long long value_1 = 0x0101010101010101;
 	__m256i _mm256_epi8_value_1 = _mm256_set_epi64x(value_1, value_1, value_1, value_1);
@@ -113,7 +127,7 @@ void Chunk::update_neighbour_count_top_side(const std::array<unsigned char, Chun
 }
 
 void Chunk::update_neighbour_count_bottom_side(const std::array<unsigned char, Chunk::columns>& data) {
-	ZoneScoped;
+	ZoneScopedChunk;
 
 	const long long value_1 = 0x0101010101010101;
 	__m256i _mm256_epi8_value_1 = _mm256_set_epi64x(value_1, value_1, value_1, value_1);
@@ -139,29 +153,29 @@ void Chunk::update_neighbour_count_bottom_side(const std::array<unsigned char, C
 }
 
 void Chunk::update_neighbour_count_top_left_corner() {
-	ZoneScoped;
+	ZoneScopedChunk;
 	neighbour_count_data[0]++;
 }
 
 void Chunk::update_neighbour_count_top_right_corner() {
-	ZoneScoped;
+	ZoneScopedChunk;
 	neighbour_count_data[Chunk::columns - 1]++;
 }
 
 
 void Chunk::update_neighbour_count_bottom_left_corner() {
-	ZoneScoped;
+	ZoneScopedChunk;
 	neighbour_count_data[(Chunk::rows - 1)* Chunk::rows]++;
 }
 
 
 void Chunk::update_neighbour_count_bottom_right_corner() {
-	ZoneScoped;
+	ZoneScopedChunk;
 	neighbour_count_data[(Chunk::rows - 1)* Chunk::rows + Chunk::columns - 1]++;
 }
 
 void Chunk::update_neighbour_count_inside() {
-	ZoneScoped;
+	ZoneScopedChunk;
 
 	const long long value_1 = 0x0101010101010101;
 	__m256i _mm256_epi8_value_1 = _mm256_set_epi64x(value_1, value_1, value_1, value_1);
@@ -222,7 +236,7 @@ bool _mm256_is_zero(__m256i a) {
 
 
 void Chunk::update_cells() {
-	ZoneScoped;
+	ZoneScopedChunk;
 
 	// assume that Chunk::columns = 32, so that a single row is exactly 256 bits big.
 	__m256i* cells_data_ptr = (__m256i*) &cells_data[0];
@@ -232,7 +246,12 @@ void Chunk::update_cells() {
 	__m256i _mm256_epi8_equal_to_0x02_mask = _mm256_set_epi64x(value_2, value_2, value_2, value_2);
 	const long long value_3 = 0x0303030303030303;
 	__m256i _mm256_epi8_equal_to_0x03_mask = _mm256_set_epi64x(value_3, value_3, value_3, value_3);
-	has_alive_cells = false;
+	// the cells are 0x00 or 0xFF, ie 0 or -1, so subtracting a row counts its alive cells per column. A column can count
+	// at most Chunk::rows = 32 cells, which fits into a byte, so we only have to sum up the bytes once at the end.
+	__m256i population_per_column = _mm256_setzero_si256();
+	__m256i births_per_column = _mm256_setzero_si256();
+	__m256i deaths_per_column = _mm256_setzero_si256();
+	row_occupancy_mask = 0;
 	for (int r = 0; r < Chunk::rows; r++) {
 		__m256i neighbour_count_row = _mm256_load_si256(&neighbour_count_data_ptr[r]);
 		__m256i cells_data_row = _mm256_load_si256(&cells_data_ptr[r]);
@@ -248,13 +267,28 @@ void Chunk::update_cells() {
 
 		_mm256_store_si256(&cells_data_ptr[r], new_row);
 
-		has_alive_cells |= !_mm256_is_zero(new_row);
+		population_per_column = _mm256_sub_epi8(population_per_column, new_row);
+		births_per_column = _mm256_sub_epi8(births_per_column, _mm256_andnot_si256(cells_data_row, new_row));
+		deaths_per_column = _mm256_sub_epi8(deaths_per_column, _mm256_andnot_si256(new_row, cells_data_row));
+		row_occupancy_mask |= static_cast<std::uint32_t>(!_mm256_is_zero(new_row)) << r;
 	}
+	column_occupancy_mask = ~static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(population_per_column, _mm256_setzero_si256())));
+
+	// sums up the bytes of the four 64 bit lanes.
+	auto sum_bytes = [](__m256i values) {
+		__m256i lane_sums = _mm256_sad_epu8(values, _mm256_setzero_si256());
+		__m128i sums = _mm_add_epi64(_mm256_castsi256_si128(lane_sums), _mm256_extracti128_si256(lane_sums, 1));
+		return static_cast<unsigned int>(_mm_cvtsi128_si64(sums) + _mm_extract_epi64(sums, 1));
+	};
+	population = sum_bytes(population_per_column);
+	number_of_births = sum_bytes(births_per_column);
+	number_of_deaths = sum_bytes(deaths_per_column);
+	has_alive_cells = population != 0;
 }
 
 
 void Chunk::update_coordinates_of_alive_cells() {
-	ZoneScoped; 
+	ZoneScopedChunk; 
 	if (false) {
 		number_of_alive_cells = 0;
 		for (int r = 0; r < Chunk::rows; ++r) {
@@ -282,3 +316,50 @@ void Chunk::update_coordinates_of_alive_cells() {
 	}
 }
 
+
+void Chunk::update_population_and_occupancy() {
+	ZoneScopedChunk;
+
+	population = 0;
+	number_of_births = 0;
+	number_of_deaths = 0;
+	row_occupancy_mask = 0;
+	column_occupancy_mask = 0;
+	for (int r = 0; r < Chunk::rows; r++) {
+		__m256i row = _mm256_load_si256(reinterpret_cast<const __m256i*>(&cells_data[r * Chunk::columns]));
+		std::uint32_t row_bits = static_cast<std::uint32_t>(_mm256_movemask_epi8(row));
+		population += _mm_popcnt_u32(row_bits);
+		row_occupancy_mask |= static_cast<std::uint32_t>(row_bits != 0) << r;
+		column_occupancy_mask |= row_bits;
+	}
+	has_alive_cells = population != 0;
+}
+
+Chunk::Row_Bits Chunk::get_row_bits() const {
+	ZoneScopedChunk;
+
+	Row_Bits row_bits;
+	for (int r = 0; r < Chunk::rows; r++) {
+		__m256i row = _mm256_load_si256(reinterpret_cast<const __m256i*>(&cells_data[r * Chunk::columns]));
+		row_bits[r] = static_cast<std::uint32_t>(_mm256_movemask_epi8(row));
+	}
+	return row_bits;
+}
+
+void Chunk::set_cells_from_row_bits(const Row_Bits& row_bits) {
+	ZoneScopedChunk;
+
+	// every byte picks the byte of the row bits which contains its bit, then tests its bit in there.
+	const __m256i byte_of_bit = _mm256_setr_epi8(
+		0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+		2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+	const __m256i bit_in_byte = _mm256_set1_epi64x(static_cast<long long>(0x8040201008040201ull));
+	std::uint32_t any_row_bits = 0;
+	for (int r = 0; r < Chunk::rows; r++) {
+		__m256i row = _mm256_shuffle_epi8(_mm256_set1_epi32(static_cast<int>(row_bits[r])), byte_of_bit);
+		row = _mm256_cmpeq_epi8(_mm256_and_si256(row, bit_in_byte), bit_in_byte);
+		_mm256_store_si256(reinterpret_cast<__m256i*>(&cells_data[r * Chunk::columns]), row);
+		any_row_bits |= row_bits[r];
+	}
+	has_alive_cells = any_row_bits != 0;
+}
@@ -1,11 +1,12 @@
 #pragma once
 
-#include <tracy/Tracy.hpp>
+#include "profiling.hpp"
 #include <immintrin.h>
 
 #include <iostream>
 #include <array>
 #include <vector>
+#include <cstdint>
 #include <unordered_set>
 
 #include <boost/unordered/unordered_flat_map.hpp>
@@ -24,6 +25,12 @@ public:
 	constexpr static int rows = 32;
 	constexpr static int columns = 32;
 
+	// one bit per cell, bit c of row r is the cell at (r, c). Assumes Chunk::columns == 32.
+	using Row_Bits = std::array<std::uint32_t, rows>;
+
+	// snapshot_bitmap_index of a chunk which is not part of an open snapshot capture.
+	constexpr static std::uint32_t NO_SNAPSHOT_BITMAP = UINT32_MAX;
+
 	Chunk();
 
 	Chunk(const Coordinate& coord, Coordinate origin_coord, const std::vector<std::pair<int, int>>& alive_cells_coordinates);
@@ -51,6 +58,16 @@ public:
 	Coordinate transform_to_world_coordinate(Coordinate chunk_coord);
 
 	void update_coordinates_of_alive_cells();
+
+	// one movemask per row, the cells are either 0x00 or 0xFF.
+	Row_Bits get_row_bits() const;
+
+	// the inverse of get_row_bits(), also sets has_alive_cells.
+	void set_cells_from_row_bits(const Row_Bits& row_bits);
+
+	// sets the population and the occupancy masks from cells_data and clears the births and deaths, for cells which
+	// were not set by update_cells().
+	void update_population_and_occupancy();
 	
 	int grid_coordinate_row;
 	int grid_coordinate_column;
@@ -67,6 +84,18 @@ public:
 
 	alignas(32) std::array<std::pair<int, int>, Chunk::rows*Chunk::columns> coordinates_of_alive_cells;
 	unsigned int number_of_alive_cells;
+
+	// set by update_cells(): the alive cells after the update and how many of them got born or died in it.
+	unsigned int population;
+	unsigned int number_of_births;
+	unsigned int number_of_deaths;
+	// bit r is set if row r has alive cells, bit c if column c has. They give the tight bounds of the alive cells.
+	std::uint32_t row_occupancy_mask;
+	std::uint32_t column_occupancy_mask;
+
+	// the bitmap of the open snapshot capture of the grid which still waits for the cells of this chunk, they have to
+	// be copied there before they change, see Grid::begin_snapshot_capture().
+	std::uint32_t snapshot_bitmap_index;
 };
 
 // assume Chunk::rows == Chunk::columns!
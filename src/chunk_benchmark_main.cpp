@@ -0,0 +1,363 @@
+#include "profiling.hpp"
+
+//--------------------------------------------------------------------------------
+// Microbenchmark of the Chunk kernels. Every kernel runs over a few chunk fixtures, once with the chunks hot in the
+// caches and once after evicting them, and we report ns/chunk, cycles/cell and bytes/cell. The results also get
+// written as JSON, so that SIMD variants or chunk sizes can be compared across commits.
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <array>
+#include <functional>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <cstdint>
+#include <cstdlib>
+
+#include <immintrin.h>
+// __rdtsc() lives in intrin.h with MSVC.
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "chunk.hpp"
+
+int main(int argc, char** argv);
+
+//--------------------------------------------------------------------------------
+struct Chunk_Benchmark_Options {
+	// number of timed passes per kernel/fixture/cache combination, we report the median and the minimum.
+	int number_of_repetitions = 51;
+	// chunks per pass with warm caches, small enough for all of them to stay in L1/L2.
+	int number_of_warm_chunks = 8;
+	// chunks per pass with cold caches.
+	int number_of_cold_chunks = 256;
+	// size of the buffer we stream through before every cold pass, should be bigger than the last level cache.
+	int eviction_buffer_megabytes = 64;
+	std::string json_path = "chunk_benchmark.json";
+	// free text which gets copied into the JSON output, eg a commit hash or the name of a SIMD variant.
+	std::string label = "";
+};
+
+// cells_data of a fixture chunk plus the side data we feed into the side update kernels.
+struct Chunk_Fixture_Data {
+	std::array<unsigned char, Chunk::rows*Chunk::columns> cells_data;
+	std::array<unsigned char, Chunk::rows> column_data;
+	std::array<unsigned char, Chunk::columns> row_data;
+};
+
+struct Chunk_Kernel {
+	std::string name;
+	std::function<void(Chunk&, const Chunk_Fixture_Data&)> run;
+	// update_cells overwrites cells_data, so the fixture has to be restored before every pass.
+	bool modifies_cells;
+	// nominal number of bytes the kernel reads and writes per chunk, given the number of alive cells.
+	std::function<double(std::size_t)> bytes_per_chunk;
+};
+
+struct Chunk_Benchmark_Result {
+	std::string kernel;
+	std::string fixture;
+	std::string cache;
+	int chunks_per_repetition;
+	double median_ns_per_chunk;
+	double min_ns_per_chunk;
+	double median_cycles_per_cell;
+	double bytes_per_cell;
+	double alive_cells_per_chunk;
+};
+
+bool parse_options(int argc, char** argv, Chunk_Benchmark_Options& options);
+void print_usage();
+double estimate_tsc_ticks_per_nanosecond();
+Chunk_Fixture_Data create_fixture_data(const std::string& fixture, std::mt19937& random_engine);
+std::vector<Chunk_Kernel> create_kernels();
+void evict_caches(std::vector<unsigned char>& eviction_buffer);
+Chunk_Benchmark_Result run_benchmark(const Chunk_Kernel& kernel, const std::string& fixture, bool is_cold, const Chunk_Benchmark_Options& options, std::vector<unsigned char>& eviction_buffer);
+void write_json(const std::vector<Chunk_Benchmark_Result>& results, const Chunk_Benchmark_Options& options, double tsc_ticks_per_nanosecond);
+
+//--------------------------------------------------------------------------------
+void print_usage() {
+	std::cout << "Usage: grid_of_life_chunk_benchmark [options]\n"
+		<< "  --repetitions N      timed passes per kernel, fixture and cache state (default 51)\n"
+		<< "  --warm-chunks N      chunks per pass with warm caches (default 8)\n"
+		<< "  --cold-chunks N      chunks per pass with cold caches (default 256)\n"
+		<< "  --evict-mb N         size of the cache eviction buffer in MB (default 64)\n"
+		<< "  --json PATH          where to write the JSON results (default chunk_benchmark.json)\n"
+		<< "  --label TEXT         free text stored in the JSON results, eg a commit hash\n";
+}
+
+bool parse_options(int argc, char** argv, Chunk_Benchmark_Options& options) {
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		if (argument == "--help" || argument == "-h") {
+			return false;
+		}
+		if (i + 1 >= argc) {
+			std::cout << "Missing value for option " << argument << std::endl;
+			return false;
+		}
+		std::string value = argv[++i];
+		if (argument == "--repetitions") {
+			options.number_of_repetitions = std::max(1, std::atoi(value.c_str()));
+		} else if (argument == "--warm-chunks") {
+			options.number_of_warm_chunks = std::max(1, std::atoi(value.c_str()));
+		} else if (argument == "--cold-chunks") {
+			options.number_of_cold_chunks = std::max(1, std::atoi(value.c_str()));
+		} else if (argument == "--evict-mb") {
+			options.eviction_buffer_megabytes = std::max(1, std::atoi(value.c_str()));
+		} else if (argument == "--json") {
+			options.json_path = value;
+		} else if (argument == "--label") {
+			options.label = value;
+		} else {
+			std::cout << "Unknown option " << argument << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+//--------------------------------------------------------------------------------
+// the kernels are timed with the time stamp counter, which ticks at a constant reference frequency on every recent
+// x86 cpu. So our "cycles" are reference cycles, they only match core cycles if the cpu runs at its base clock.
+double estimate_tsc_ticks_per_nanosecond() {
+	ZoneScopedFrame;
+
+	auto start_time = std::chrono::steady_clock::now();
+	std::uint64_t start_ticks = __rdtsc();
+	while (std::chrono::steady_clock::now() - start_time < std::chrono::milliseconds(200)) {
+	}
+	std::uint64_t end_ticks = __rdtsc();
+	auto end_time = std::chrono::steady_clock::now();
+
+	double nanoseconds = std::chrono::duration<double, std::nano>(end_time - start_time).count();
+	return static_cast<double>(end_ticks - start_ticks) / nanoseconds;
+}
+
+Chunk_Fixture_Data create_fixture_data(const std::string& fixture, std::mt19937& random_engine) {
+	ZoneScopedFrame;
+
+	Chunk_Fixture_Data data;
+	data.cells_data.fill(0);
+
+	std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+	for (int r = 0; r < Chunk::rows; r++) {
+		for (int c = 0; c < Chunk::columns; c++) {
+			bool is_alive = false;
+			if (fixture == "sparse") {
+				is_alive = distribution(random_engine) < 0.02f;
+			} else if (fixture == "random") {
+				is_alive = distribution(random_engine) < 0.5f;
+			} else if (fixture == "checkerboard") {
+				is_alive = (r + c) % 2 == 0;
+			}
+			data.cells_data[r*Chunk::columns + c] = is_alive ? 0xFF : 0;
+		}
+	}
+	// the side kernels get the border of the fixture itself as the border of the neighbouring chunk.
+	for (int r = 0; r < Chunk::rows; r++) {
+		data.column_data[r] = data.cells_data[r*Chunk::columns + Chunk::columns - 1];
+	}
+	for (int c = 0; c < Chunk::columns; c++) {
+		data.row_data[c] = data.cells_data[(Chunk::rows - 1)*Chunk::columns + c];
+	}
+	return data;
+}
+
+std::vector<Chunk_Kernel> create_kernels() {
+	ZoneScopedFrame;
+
+	const double cells_per_chunk = Chunk::rows * Chunk::columns;
+	// the side kernels read the neighbour data and read+write one row or column of neighbour counts.
+	const double side_bytes = Chunk::rows + 2.0 * Chunk::rows;
+
+	std::vector<Chunk_Kernel> kernels;
+	kernels.push_back({ "update_neighbour_count_inside",
+		[](Chunk& chunk, const Chunk_Fixture_Data&) { chunk.update_neighbour_count_inside(); },
+		false,
+		[=](std::size_t) { return 2.0 * cells_per_chunk; } });
+	kernels.push_back({ "update_cells",
+		[](Chunk& chunk, const Chunk_Fixture_Data&) { chunk.update_cells(); },
+		true,
+		[=](std::size_t) { return 3.0 * cells_per_chunk; } });
+	kernels.push_back({ "update_neighbour_count_left_side",
+		[](Chunk& chunk, const Chunk_Fixture_Data& data) { chunk.update_neighbour_count_left_side(data.column_data); },
+		false,
+		[=](std::size_t) { return side_bytes; } });
+	kernels.push_back({ "update_neighbour_count_right_side",
+		[](Chunk& chunk, const Chunk_Fixture_Data& data) { chunk.update_neighbour_count_right_side(data.column_data); },
+		false,
+		[=](std::size_t) { return side_bytes; } });
+	kernels.push_back({ "update_neighbour_count_top_side",
+		[](Chunk& chunk, const Chunk_Fixture_Data& data) { chunk.update_neighbour_count_top_side(data.row_data); },
+		false,
+		[=](std::size_t) { return side_bytes; } });
+	kernels.push_back({ "update_neighbour_count_bottom_side",
+		[](Chunk& chunk, const Chunk_Fixture_Data& data) { chunk.update_neighbour_count_bottom_side(data.row_data); },
+		false,
+		[=](std::size_t) { return side_bytes; } });
+	kernels.push_back({ "update_neighbour_count_corners",
+		[](Chunk& chunk, const Chunk_Fixture_Data&) {
+			chunk.update_neighbour_count_top_left_corner();
+			chunk.update_neighbour_count_top_right_corner();
+			chunk.update_neighbour_count_bottom_left_corner();
+			chunk.update_neighbour_count_bottom_right_corner();
+		},
+		false,
+		[=](std::size_t) { return 4.0 * 2.0; } });
+	kernels.push_back({ "update_coordinates_of_alive_cells",
+		[](Chunk& chunk, const Chunk_Fixture_Data&) { chunk.update_coordinates_of_alive_cells(); },
+		false,
+		[=](std::size_t number_of_alive_cells) { return cells_per_chunk + sizeof(std::pair<int, int>) * number_of_alive_cells; } });
+	return kernels;
+}
+
+void evict_caches(std::vector<unsigned char>& eviction_buffer) {
+	ZoneScopedFrame;
+
+	// write to every cache line, so that the chunks get evicted from every level of the cache hierarchy.
+	for (std::size_t i = 0; i < eviction_buffer.size(); i += 64) {
+		eviction_buffer[i]++;
+	}
+}
+
+Chunk_Benchmark_Result run_benchmark(const Chunk_Kernel& kernel, const std::string& fixture, bool is_cold, const Chunk_Benchmark_Options& options, std::vector<unsigned char>& eviction_buffer) {
+	ZoneScopedFrame;
+
+	int number_of_chunks = is_cold ? options.number_of_cold_chunks : options.number_of_warm_chunks;
+
+	// every chunk gets its own random fixture, so that the branch predictor can not learn a single sparse pattern.
+	std::mt19937 random_engine(12345);
+	std::vector<Chunk_Fixture_Data> fixture_data;
+	std::vector<Chunk> chunks(number_of_chunks);
+	std::size_t number_of_alive_cells = 0;
+	for (int i = 0; i < number_of_chunks; i++) {
+		fixture_data.push_back(create_fixture_data(fixture, random_engine));
+		chunks[i].cells_data = fixture_data[i].cells_data;
+		number_of_alive_cells += std::count(chunks[i].cells_data.begin(), chunks[i].cells_data.end(), 0xFF);
+	}
+	double alive_cells_per_chunk = static_cast<double>(number_of_alive_cells) / number_of_chunks;
+
+	std::vector<double> nanoseconds_per_chunk;
+	std::vector<double> ticks_per_chunk;
+	// the first pass only warms up the caches and the branch predictor and is not recorded.
+	for (int repetition = 0; repetition <= options.number_of_repetitions; repetition++) {
+		if (kernel.modifies_cells) {
+			for (int i = 0; i < number_of_chunks; i++) {
+				chunks[i].cells_data = fixture_data[i].cells_data;
+			}
+		}
+		if (is_cold) {
+			evict_caches(eviction_buffer);
+		}
+
+		auto start_time = std::chrono::steady_clock::now();
+		std::uint64_t start_ticks = __rdtsc();
+		for (int i = 0; i < number_of_chunks; i++) {
+			kernel.run(chunks[i], fixture_data[i]);
+		}
+		std::uint64_t end_ticks = __rdtsc();
+		auto end_time = std::chrono::steady_clock::now();
+
+		if (repetition > 0) {
+			nanoseconds_per_chunk.push_back(std::chrono::duration<double, std::nano>(end_time - start_time).count() / number_of_chunks);
+			ticks_per_chunk.push_back(static_cast<double>(end_ticks - start_ticks) / number_of_chunks);
+		}
+	}
+
+	auto median = [](std::vector<double> values) {
+		std::sort(values.begin(), values.end());
+		return values[values.size() / 2];
+	};
+
+	const double cells_per_chunk = Chunk::rows * Chunk::columns;
+	Chunk_Benchmark_Result result;
+	result.kernel = kernel.name;
+	result.fixture = fixture;
+	result.cache = is_cold ? "cold" : "warm";
+	result.chunks_per_repetition = number_of_chunks;
+	result.median_ns_per_chunk = median(nanoseconds_per_chunk);
+	result.min_ns_per_chunk = *std::min_element(nanoseconds_per_chunk.begin(), nanoseconds_per_chunk.end());
+	result.median_cycles_per_cell = median(ticks_per_chunk) / cells_per_chunk;
+	result.bytes_per_cell = kernel.bytes_per_chunk(static_cast<std::size_t>(alive_cells_per_chunk)) / cells_per_chunk;
+	result.alive_cells_per_chunk = alive_cells_per_chunk;
+	return result;
+}
+
+//--------------------------------------------------------------------------------
+void write_json(const std::vector<Chunk_Benchmark_Result>& results, const Chunk_Benchmark_Options& options, double tsc_ticks_per_nanosecond) {
+	ZoneScopedFrame;
+
+	std::ofstream file(options.json_path);
+	if (!file) {
+		std::cout << "Failed to open " << options.json_path << " for writing." << std::endl;
+		return;
+	}
+
+	file << std::setprecision(6);
+	file << "{\n";
+	file << "  \"benchmark\": \"chunk_kernels\",\n";
+	file << "  \"label\": \"" << options.label << "\",\n";
+	file << "  \"chunk_rows\": " << Chunk::rows << ",\n";
+	file << "  \"chunk_columns\": " << Chunk::columns << ",\n";
+	file << "  \"tsc_ticks_per_nanosecond\": " << tsc_ticks_per_nanosecond << ",\n";
+	file << "  \"repetitions\": " << options.number_of_repetitions << ",\n";
+	file << "  \"results\": [\n";
+	for (std::size_t i = 0; i < results.size(); i++) {
+		const Chunk_Benchmark_Result& result = results[i];
+		file << "    { \"kernel\": \"" << result.kernel << "\""
+			<< ", \"fixture\": \"" << result.fixture << "\""
+			<< ", \"cache\": \"" << result.cache << "\""
+			<< ", \"chunks_per_repetition\": " << result.chunks_per_repetition
+			<< ", \"alive_cells_per_chunk\": " << result.alive_cells_per_chunk
+			<< ", \"ns_per_chunk\": " << result.median_ns_per_chunk
+			<< ", \"ns_per_chunk_min\": " << result.min_ns_per_chunk
+			<< ", \"cycles_per_cell\": " << result.median_cycles_per_cell
+			<< ", \"bytes_per_cell\": " << result.bytes_per_cell
+			<< " }" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	file << "  ]\n";
+	file << "}\n";
+}
+
+//--------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+	Chunk_Benchmark_Options options;
+	if (!parse_options(argc, argv, options)) {
+		print_usage();
+		return -1;
+	}
+
+	double tsc_ticks_per_nanosecond = estimate_tsc_ticks_per_nanosecond();
+	std::vector<unsigned char> eviction_buffer(static_cast<std::size_t>(options.eviction_buffer_megabytes) * 1024 * 1024, 0);
+
+	const std::vector<std::string> fixtures = { "empty", "sparse", "random", "checkerboard" };
+	std::vector<Chunk_Kernel> kernels = create_kernels();
+
+	std::cout << "tsc: " << std::fixed << std::setprecision(3) << tsc_ticks_per_nanosecond << " ticks/ns" << std::endl;
+	std::cout << std::left << std::setw(36) << "kernel" << std::setw(14) << "fixture" << std::setw(7) << "cache"
+		<< std::right << std::setw(12) << "ns/chunk" << std::setw(14) << "cycles/cell" << std::setw(12) << "bytes/cell" << std::endl;
+
+	std::vector<Chunk_Benchmark_Result> results;
+	for (const Chunk_Kernel& kernel: kernels) {
+		for (const std::string& fixture: fixtures) {
+			for (bool is_cold: { false, true }) {
+				Chunk_Benchmark_Result result = run_benchmark(kernel, fixture, is_cold, options, eviction_buffer);
+				std::cout << std::left << std::setw(36) << result.kernel << std::setw(14) << result.fixture << std::setw(7) << result.cache
+					<< std::right << std::setprecision(2) << std::setw(12) << result.median_ns_per_chunk
+					<< std::setprecision(4) << std::setw(14) << result.median_cycles_per_cell
+					<< std::setprecision(3) << std::setw(12) << result.bytes_per_cell << std::endl;
+				results.push_back(result);
+			}
+		}
+	}
+
+	write_json(results, options, tsc_ticks_per_nanosecond);
+	std::cout << "wrote " << options.json_path << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,78 @@
+#include "chunk_bitmap_buffer.hpp"
+#include "buffer_mapping.hpp"
+
+#include <algorithm>
+#include <climits>
+
+
+//--------------------------------------------------------------------------------
+Chunk_Bitmap_Buffer::Chunk_Bitmap_Buffer() :
+	buffer(0),
+texture(0),
+maximum_number_of_chunks(0),
+number_of_chunks(0),
+number_of_written_chunks(0)
+{
+
+}
+
+Chunk_Bitmap_Buffer::~Chunk_Bitmap_Buffer() {
+	ZoneScopedFrame;
+
+	if (has_current_opengl_context()) {
+		glDeleteTextures(1, &texture);
+		glDeleteBuffers(1, &buffer);
+	}
+}
+
+void Chunk_Bitmap_Buffer::initialise() {
+	ZoneScopedFrame;
+
+	GLint maximum_number_of_texels = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maximum_number_of_texels);
+	maximum_number_of_chunks = std::min<std::size_t>(static_cast<std::size_t>(maximum_number_of_texels) / TEXELS_PER_CHUNK, INT_MAX / CELLS_PER_CHUNK);
+
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+	glBufferData(GL_TEXTURE_BUFFER, TEXELS_PER_CHUNK * sizeof(std::uint32_t), nullptr, GL_STREAM_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_BUFFER, texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, buffer);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+//--------------------------------------------------------------------------------
+std::uint32_t* Chunk_Bitmap_Buffer::begin_write(std::size_t number_of_chunks_to_write) {
+	ZoneScopedFrame;
+
+	number_of_written_chunks = number_of_chunks_to_write;
+	// the texture keeps referring to the buffer object, so it sees the orphaned storage without another glTexBuffer.
+	void* data = map_orphaned_buffer(GL_TEXTURE_BUFFER, buffer, number_of_chunks_to_write * TEXELS_PER_CHUNK * sizeof(std::uint32_t));
+	if (data == nullptr) {
+		number_of_written_chunks = 0;
+	}
+	return static_cast<std::uint32_t*>(data);
+}
+
+void Chunk_Bitmap_Buffer::end_write() {
+	ZoneScopedFrame;
+
+	bool is_valid = unmap_buffer(GL_TEXTURE_BUFFER, buffer);
+	number_of_chunks = is_valid ? number_of_written_chunks : 0;
+}
+
+void Chunk_Bitmap_Buffer::bind(GLuint texture_unit) {
+	glActiveTexture(GL_TEXTURE0 + texture_unit);
+	glBindTexture(GL_TEXTURE_BUFFER, texture);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+std::size_t Chunk_Bitmap_Buffer::get_number_of_chunks() const {
+	return number_of_chunks;
+}
+
+std::size_t Chunk_Bitmap_Buffer::get_maximum_number_of_chunks() const {
+	return maximum_number_of_chunks;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "profiling.hpp"
+#include "opengl.hpp"
+#include "chunk.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+
+//--------------------------------------------------------------------------------
+// The packed cells of the chunks in a texture buffer (GL_R32UI), for expanding the cells on the GPU: the vertex shader
+// draws one instance per potential cell, finds its chunk, row and column from gl_InstanceID and drops the cube if the
+// bit is not set. That uploads 1 bit per cell instead of a 12 byte translation per alive cell, but runs the vertex
+// shader for every dead cell of a chunk as well, so it pays off for dense patterns. Texture buffers are core since GL
+// 3.1, the buffer gets orphaned and mapped for every write.
+class Chunk_Bitmap_Buffer {
+public:
+	// texels per chunk: the rows, bit c of row r is the cell at column c, followed by the origin row and column.
+	constexpr static int TEXELS_PER_CHUNK = Chunk::rows + 2;
+	constexpr static int CELLS_PER_CHUNK = Chunk::rows * Chunk::columns;
+	static_assert(Chunk::rows == 32 && Chunk::columns == 32, "shader.vertex_shader decodes chunks of 32 x 32 cells");
+
+	Chunk_Bitmap_Buffer();
+
+	~Chunk_Bitmap_Buffer();
+
+	Chunk_Bitmap_Buffer(const Chunk_Bitmap_Buffer&) = delete;
+
+	Chunk_Bitmap_Buffer& operator = (const Chunk_Bitmap_Buffer&) = delete;
+
+	// needs the current OpenGL context.
+	void initialise();
+
+	// returns the memory for the TEXELS_PER_CHUNK texels of each of number_of_chunks chunks, they are drawn after
+	// end_write(). The memory may be written from any thread until then.
+	std::uint32_t* begin_write(std::size_t number_of_chunks);
+
+	void end_write();
+
+	// binds the texture buffer to the texture unit.
+	void bind(GLuint texture_unit);
+
+	std::size_t get_number_of_chunks() const;
+
+	// GL_MAX_TEXTURE_BUFFER_SIZE allows fewer chunks on some drivers, the guaranteed minimum is only 65536 texels. Also
+	// limited so that the instance count of the draw (CELLS_PER_CHUNK per chunk) fits into a GLsizei.
+	std::size_t get_maximum_number_of_chunks() const;
+
+private:
+	//--------------------------------------------------------------------------------
+	// data
+	GLuint buffer;
+	GLuint texture;
+	std::size_t maximum_number_of_chunks;
+
+	std::size_t number_of_chunks;
+	std::size_t number_of_written_chunks;
+};
@@ -0,0 +1,114 @@
+#include "chunk_directory.hpp"
+
+//--------------------------------------------------------------------------------
+Chunk_Directory::Chunk_Directory() :
+	pages(PAGES_PER_SIDE * PAGES_PER_SIDE),
+allocated_page_indices({}),
+far_chunks_map({}),
+number_of_chunks(0)
+{
+	ZoneScopedPhase;
+}
+
+int Chunk_Directory::get_page_index(const Coordinate& coord) {
+	// arithmetic shift, so that negative coordinates end up in the pages left/above of the origin.
+	int page_x = (coord.x >> Chunk_Directory_Page::PAGE_SHIFT) + PAGES_PER_SIDE / 2;
+	int page_y = (coord.y >> Chunk_Directory_Page::PAGE_SHIFT) + PAGES_PER_SIDE / 2;
+
+	// the unsigned compare checks for negative values as well.
+	if (static_cast<unsigned int>(page_x) >= PAGES_PER_SIDE || static_cast<unsigned int>(page_y) >= PAGES_PER_SIDE) {
+		return -1;
+	}
+	return page_x * PAGES_PER_SIDE + page_y;
+}
+
+int Chunk_Directory::get_slot_index(const Coordinate& coord) {
+	return (coord.x & Chunk_Directory_Page::PAGE_MASK) * Chunk_Directory_Page::PAGE_SIZE + (coord.y & Chunk_Directory_Page::PAGE_MASK);
+}
+
+bool Chunk_Directory::contains(const Coordinate& coord) const {
+	return find(coord) != INVALID_CHUNK_INDEX;
+}
+
+std::size_t Chunk_Directory::find(const Coordinate& coord) const {
+	int page_index = get_page_index(coord);
+	if (page_index >= 0) {
+		const Chunk_Directory_Page* page = pages[page_index].get();
+		if (!page) {
+			return INVALID_CHUNK_INDEX;
+		}
+		// slots store index + 1, so an empty slot wraps around to INVALID_CHUNK_INDEX.
+		return static_cast<std::size_t>(page->slots[get_slot_index(coord)]) - 1;
+	}
+
+	auto it = far_chunks_map.find(coord);
+	if (it == far_chunks_map.end()) {
+		return INVALID_CHUNK_INDEX;
+	}
+	return it->second;
+}
+
+void Chunk_Directory::insert(const Coordinate& coord, std::size_t chunk_index) {
+	ZoneScopedChunk;
+
+	int page_index = get_page_index(coord);
+	if (page_index >= 0) {
+		std::unique_ptr<Chunk_Directory_Page>& page = pages[page_index];
+		if (!page) {
+			page = std::make_unique < Chunk_Directory_Page > ();
+			allocated_page_indices.push_back(page_index);
+		}
+		std::uint32_t& slot = page->slots[get_slot_index(coord)];
+		if (slot == 0) {
+			page->number_of_used_slots++;
+			number_of_chunks++;
+		}
+		slot = static_cast<std::uint32_t>(chunk_index + 1);
+		return;
+	}
+
+	auto [it, inserted] = far_chunks_map.insert_or_assign(coord, chunk_index);
+	if (inserted) {
+		number_of_chunks++;
+	}
+}
+
+void Chunk_Directory::erase(const Coordinate& coord) {
+	ZoneScopedChunk;
+
+	int page_index = get_page_index(coord);
+	if (page_index >= 0) {
+		Chunk_Directory_Page* page = pages[page_index].get();
+		if (!page) {
+			return;
+		}
+		std::uint32_t& slot = page->slots[get_slot_index(coord)];
+		if (slot != 0) {
+			slot = 0;
+			page->number_of_used_slots--;
+			number_of_chunks--;
+		}
+		// we keep empty pages around, patterns tend to move back and forth over the same region.
+		return;
+	}
+
+	number_of_chunks -= far_chunks_map.erase(coord);
+}
+
+void Chunk_Directory::clear() {
+	ZoneScopedPhase;
+
+	for (int page_index: allocated_page_indices) {
+		std::unique_ptr<Chunk_Directory_Page>& page = pages[page_index];
+		if (page->number_of_used_slots > 0) {
+			page->slots = {};
+			page->number_of_used_slots = 0;
+		}
+	}
+	far_chunks_map.clear();
+	number_of_chunks = 0;
+}
+
+std::size_t Chunk_Directory::size() const {
+	return number_of_chunks;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "profiling.hpp"
+
+#include <array>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include <boost/unordered/unordered_flat_map.hpp>
+
+#include "coordinate.hpp"
+
+
+//--------------------------------------------------------------------------------
+// A page of the chunk directory, holds the chunk indices of a square block of PAGE_SIZE x PAGE_SIZE chunk coordinates.
+// We store index + 1 in the slots, so that a zero initialised page is an empty page.
+struct Chunk_Directory_Page {
+	constexpr static int PAGE_SHIFT = 4;
+	constexpr static int PAGE_SIZE = 1 << PAGE_SHIFT;
+	constexpr static int PAGE_MASK = PAGE_SIZE - 1;
+
+	std::array<std::uint32_t, PAGE_SIZE * PAGE_SIZE> slots = {};
+	int number_of_used_slots = 0;
+};
+
+//--------------------------------------------------------------------------------
+// Maps chunk coordinates to chunk indices. Most patterns occupy a compact region around the origin, so we use a
+// two level page table there: a fixed size, direct mapped array of pages keyed by (x >> PAGE_SHIFT, y >> PAGE_SHIFT)
+// and a direct mapped block of chunk slots inside the page. A lookup is then two loads and no hashing. Chunks outside
+// of that region (eg escaping gliders) fall back to a hash map.
+class Chunk_Directory {
+public:
+	constexpr static std::size_t INVALID_CHUNK_INDEX = static_cast<std::size_t>(-1);
+
+	// number of pages per side of the direct mapped region, the region is centered around the origin and covers
+	// PAGES_PER_SIDE * PAGE_SIZE chunks per side.
+	constexpr static int PAGES_PER_SIDE = 128;
+
+	Chunk_Directory();
+
+	bool contains(const Coordinate& coord) const;
+
+	// returns INVALID_CHUNK_INDEX if there is no chunk at coord.
+	std::size_t find(const Coordinate& coord) const;
+
+	void insert(const Coordinate& coord, std::size_t chunk_index);
+
+	void erase(const Coordinate& coord);
+
+	void clear();
+
+	std::size_t size() const;
+	//--------------------------------------------------------------------------------
+	// data
+	std::vector<std::unique_ptr<Chunk_Directory_Page>> pages;
+
+	// indices into pages of all allocated pages, so that clear() does not have to walk the whole page table.
+	std::vector<int> allocated_page_indices;
+
+	boost::unordered_flat_map<Coordinate, std::size_t> far_chunks_map;
+
+	std::size_t number_of_chunks;
+
+private:
+	// returns -1 if coord lies outside of the direct mapped region.
+	static int get_page_index(const Coordinate& coord);
+
+	static int get_slot_index(const Coordinate& coord);
+};
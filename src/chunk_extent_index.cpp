@@ -0,0 +1,46 @@
+#include "chunk_extent_index.hpp"
+
+
+//--------------------------------------------------------------------------------
+void Chunk_Extent_Index::insert(const Coordinate& coord) {
+	ZoneScopedChunk;
+
+	columns_by_row[coord.x].insert(coord.y);
+	rows_by_column[coord.y].insert(coord.x);
+}
+
+void Chunk_Extent_Index::erase(const Coordinate& coord) {
+	ZoneScopedChunk;
+
+	auto columns = columns_by_row.find(coord.x);
+	if (columns != columns_by_row.end()) {
+		columns->second.erase(coord.y);
+		if (columns->second.empty()) {
+			columns_by_row.erase(columns);
+		}
+	}
+	auto rows = rows_by_column.find(coord.y);
+	if (rows != rows_by_column.end()) {
+		rows->second.erase(coord.x);
+		if (rows->second.empty()) {
+			rows_by_column.erase(rows);
+		}
+	}
+}
+
+void Chunk_Extent_Index::clear() {
+	columns_by_row.clear();
+	rows_by_column.clear();
+}
+
+bool Chunk_Extent_Index::is_empty() const {
+	return columns_by_row.empty();
+}
+
+const std::map<int, std::set<int>>& Chunk_Extent_Index::get_columns_by_row() const {
+	return columns_by_row;
+}
+
+const std::map<int, std::set<int>>& Chunk_Extent_Index::get_rows_by_column() const {
+	return rows_by_column;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "profiling.hpp"
+
+#include <map>
+#include <set>
+
+#include "coordinate.hpp"
+
+
+//--------------------------------------------------------------------------------
+// The chunk coordinates of a grid, ordered by row and by column. Creating or removing a chunk costs O(log n) and the
+// first and last chunk rows and columns are always at hand, so the bounding box of a grid only has to look at the
+// chunks on its border instead of at all of them, see Grid::get_bounding_box().
+class Chunk_Extent_Index {
+public:
+	void insert(const Coordinate& coord);
+
+	void erase(const Coordinate& coord);
+
+	void clear();
+
+	bool is_empty() const;
+
+	// chunk row -> the chunk columns of the chunks in that row, and the other way round.
+	const std::map<int, std::set<int>>& get_columns_by_row() const;
+
+	const std::map<int, std::set<int>>& get_rows_by_column() const;
+
+private:
+	//--------------------------------------------------------------------------------
+	// data
+	std::map<int, std::set<int>> columns_by_row;
+	std::map<int, std::set<int>> rows_by_column;
+};
@@ -0,0 +1,266 @@
+#include "chunk_instance_slots.hpp"
+#include "buffer_mapping.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+
+//--------------------------------------------------------------------------------
+// not in the GL 3.3 headers of glad.
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+//--------------------------------------------------------------------------------
+Chunk_Instance_Slots::Chunk_Instance_Slots() :
+	instance_buffer(0),
+indirect_buffer(0),
+multi_draw_arrays_indirect_function(nullptr),
+slots({}),
+free_slot_indices({}),
+slot_indices_by_chunk_origin({}),
+buffer_capacity(0),
+number_of_reserved_instances(0),
+free_range_offsets({}),
+update_counter(0),
+number_of_uploaded_chunks(0),
+number_of_uploaded_instances(0),
+number_of_uploads(0),
+draw_commands({}),
+previous_draw_commands({}),
+indirect_buffer_capacity(0),
+vertices_per_instance(0)
+{
+
+}
+
+Chunk_Instance_Slots::~Chunk_Instance_Slots() {
+	ZoneScopedFrame;
+
+	if (has_current_opengl_context()) {
+		glDeleteBuffers(1, &instance_buffer);
+		glDeleteBuffers(1, &indirect_buffer);
+	}
+}
+
+void Chunk_Instance_Slots::initialise(GLsizei a_vertices_per_instance) {
+	ZoneScopedFrame;
+
+	vertices_per_instance = a_vertices_per_instance;
+	// the base instance of the commands needs ARB_base_instance as well, both are core since GL 4.3.
+	if (glfwExtensionSupported("GL_ARB_multi_draw_indirect") && glfwExtensionSupported("GL_ARB_base_instance")) {
+		multi_draw_arrays_indirect_function = reinterpret_cast<Multi_Draw_Arrays_Indirect_Function>(glfwGetProcAddress("glMultiDrawArraysIndirect"));
+	}
+	std::cout << "Chunk instances: " << (multi_draw_arrays_indirect_function != nullptr ? "one indirect multi draw" : "one draw per chunk") << std::endl;
+
+	glGenBuffers(1, &indirect_buffer);
+	grow_buffer(1 << 16);
+}
+
+//--------------------------------------------------------------------------------
+std::size_t Chunk_Instance_Slots::find_slot(const Coordinate& chunk_origin) const {
+	auto it = slot_indices_by_chunk_origin.find(chunk_origin);
+	return it != slot_indices_by_chunk_origin.end() ? it->second : INVALID_SLOT_INDEX;
+}
+
+const Chunk_Instance_Slot& Chunk_Instance_Slots::get_slot(std::size_t slot_index) const {
+	return slots[slot_index];
+}
+
+void Chunk_Instance_Slots::begin_update() {
+	update_counter++;
+	number_of_uploaded_chunks = 0;
+	number_of_uploaded_instances = 0;
+	number_of_uploads = 0;
+}
+
+void Chunk_Instance_Slots::keep_slot(std::size_t slot_index, bool is_visible) {
+	slots[slot_index].last_update = update_counter;
+	slots[slot_index].is_visible = is_visible;
+}
+
+std::size_t Chunk_Instance_Slots::update_slot(const Coordinate& chunk_origin, std::size_t slot_index, std::size_t number_of_instances, const Chunk::Row_Bits& row_bits) {
+	ZoneScopedFrame;
+
+	if (slot_index == INVALID_SLOT_INDEX) {
+		if (free_slot_indices.empty()) {
+			slot_index = slots.size();
+			slots.emplace_back();
+		}
+		else {
+			slot_index = free_slot_indices.back();
+			free_slot_indices.pop_back();
+		}
+		slots[slot_index] = Chunk_Instance_Slot();
+		slots[slot_index].chunk_origin = chunk_origin;
+		slots[slot_index].is_used = true;
+		slot_indices_by_chunk_origin[chunk_origin] = slot_index;
+	}
+
+	Chunk_Instance_Slot& slot = slots[slot_index];
+	// a chunk keeps its range while its cells fit, so that a flickering oscillator does not move around in the buffer.
+	if (number_of_instances > slot.capacity) {
+		free_range(slot);
+		allocate_range(slot, number_of_instances);
+	}
+	slot.number_of_instances = number_of_instances;
+	slot.row_bits = row_bits;
+	slot.last_update = update_counter;
+	slot.is_visible = true;
+	number_of_uploaded_chunks++;
+	number_of_uploaded_instances += number_of_instances;
+	return slot_index;
+}
+
+void Chunk_Instance_Slots::upload(std::size_t offset, std::size_t number_of_instances, const glm::vec3* instances) {
+	ZoneScopedFrame;
+
+	if (number_of_instances == 0) {
+		return;
+	}
+	number_of_uploads++;
+	glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+	glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(offset * sizeof(glm::vec3)), static_cast<GLsizeiptr>(number_of_instances * sizeof(glm::vec3)), instances);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Chunk_Instance_Slots::end_update() {
+	ZoneScopedFrame;
+
+	for (std::size_t slot_index = 0; slot_index < slots.size(); slot_index++) {
+		if (slots[slot_index].is_used && slots[slot_index].last_update != update_counter) {
+			free_slot(slot_index);
+		}
+	}
+
+	// moving the camera changes which slots get drawn without changing any slot, so the commands get compared instead.
+	std::swap(draw_commands, previous_draw_commands);
+	draw_commands.clear();
+	for (const Chunk_Instance_Slot& slot: slots) {
+		if (slot.is_used && slot.is_visible && slot.number_of_instances > 0) {
+			draw_commands.push_back({static_cast<GLuint>(vertices_per_instance), static_cast<GLuint>(slot.number_of_instances), 0, static_cast<GLuint>(slot.offset)});
+		}
+	}
+	bool have_draw_commands_changed = draw_commands.size() != previous_draw_commands.size() ||
+		!std::equal(draw_commands.begin(), draw_commands.end(), previous_draw_commands.begin(), [](const Draw_Arrays_Indirect_Command& lhs, const Draw_Arrays_Indirect_Command& rhs) {
+			return lhs.count == rhs.count && lhs.instance_count == rhs.instance_count && lhs.first == rhs.first && lhs.base_instance == rhs.base_instance;
+		});
+	if (multi_draw_arrays_indirect_function == nullptr || draw_commands.empty() || !have_draw_commands_changed) {
+		return;
+	}
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer);
+	GLsizeiptr size = static_cast<GLsizeiptr>(draw_commands.size() * sizeof(Draw_Arrays_Indirect_Command));
+	if (draw_commands.size() > indirect_buffer_capacity) {
+		indirect_buffer_capacity = std::max(draw_commands.size(), indirect_buffer_capacity * 2);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, static_cast<GLsizeiptr>(indirect_buffer_capacity * sizeof(Draw_Arrays_Indirect_Command)), nullptr, GL_DYNAMIC_DRAW);
+	}
+	glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, size, draw_commands.data());
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void Chunk_Instance_Slots::draw(GLuint attribute_index) {
+	ZoneScopedFrame;
+
+	if (draw_commands.empty()) {
+		return;
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+	if (multi_draw_arrays_indirect_function != nullptr) {
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer);
+		// the base instance of each command offsets the instance attribute into the range of its chunk.
+		glVertexAttribPointer(attribute_index, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), nullptr);
+		multi_draw_arrays_indirect_function(GL_TRIANGLES, nullptr, static_cast<GLsizei>(draw_commands.size()), 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+	else {
+		for (const Draw_Arrays_Indirect_Command& command: draw_commands) {
+			std::size_t offset = static_cast<std::size_t>(command.base_instance) * sizeof(glm::vec3);
+			glVertexAttribPointer(attribute_index, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), reinterpret_cast<void*>(offset));
+			glDrawArraysInstanced(GL_TRIANGLES, 0, vertices_per_instance, static_cast<GLsizei>(command.instance_count));
+		}
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+std::size_t Chunk_Instance_Slots::get_number_of_uploaded_chunks() const {
+	return number_of_uploaded_chunks;
+}
+
+std::size_t Chunk_Instance_Slots::get_number_of_uploaded_instances() const {
+	return number_of_uploaded_instances;
+}
+
+std::size_t Chunk_Instance_Slots::get_number_of_uploads() const {
+	return number_of_uploads;
+}
+
+bool Chunk_Instance_Slots::is_using_multi_draw_indirect() const {
+	return multi_draw_arrays_indirect_function != nullptr;
+}
+
+//--------------------------------------------------------------------------------
+int Chunk_Instance_Slots::get_size_class(std::size_t number_of_instances) {
+	int size_class = 0;
+	while ((MINIMUM_RANGE_SIZE << size_class) < number_of_instances) {
+		size_class++;
+	}
+	return size_class;
+}
+
+void Chunk_Instance_Slots::allocate_range(Chunk_Instance_Slot& slot, std::size_t number_of_instances) {
+	int size_class = get_size_class(number_of_instances);
+	std::vector<std::size_t>& free_offsets = free_range_offsets[size_class];
+	slot.capacity = MINIMUM_RANGE_SIZE << size_class;
+	if (!free_offsets.empty()) {
+		slot.offset = free_offsets.back();
+		free_offsets.pop_back();
+		return;
+	}
+	if (number_of_reserved_instances + slot.capacity > buffer_capacity) {
+		grow_buffer(number_of_reserved_instances + slot.capacity);
+	}
+	slot.offset = number_of_reserved_instances;
+	number_of_reserved_instances += slot.capacity;
+}
+
+void Chunk_Instance_Slots::free_range(Chunk_Instance_Slot& slot) {
+	if (slot.capacity > 0) {
+		free_range_offsets[get_size_class(slot.capacity)].push_back(slot.offset);
+	}
+	slot.offset = 0;
+	slot.capacity = 0;
+}
+
+void Chunk_Instance_Slots::free_slot(std::size_t slot_index) {
+	Chunk_Instance_Slot& slot = slots[slot_index];
+	free_range(slot);
+	slot_indices_by_chunk_origin.erase(slot.chunk_origin);
+	slot.is_used = false;
+	slot.number_of_instances = 0;
+	free_slot_indices.push_back(slot_index);
+}
+
+void Chunk_Instance_Slots::grow_buffer(std::size_t minimum_capacity) {
+	ZoneScopedFrame;
+
+	std::size_t new_capacity = std::max<std::size_t>(buffer_capacity, 1);
+	while (new_capacity < minimum_capacity) {
+		new_capacity *= 2;
+	}
+
+	// the ranges keep their offsets, so the reserved part gets copied over on the GPU.
+	GLuint new_buffer = 0;
+	glGenBuffers(1, &new_buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, new_buffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(new_capacity * sizeof(glm::vec3)), nullptr, GL_DYNAMIC_DRAW);
+	if (number_of_reserved_instances > 0) {
+		glBindBuffer(GL_COPY_READ_BUFFER, instance_buffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, static_cast<GLsizeiptr>(number_of_reserved_instances * sizeof(glm::vec3)));
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	glDeleteBuffers(1, &instance_buffer);
+	instance_buffer = new_buffer;
+	buffer_capacity = new_capacity;
+}
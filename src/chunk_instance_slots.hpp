@@ -0,0 +1,136 @@
+#pragma once
+
+#include "profiling.hpp"
+#include "opengl.hpp"
+#include "chunk.hpp"
+#include "coordinate.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <boost/unordered/unordered_flat_map.hpp>
+
+
+//--------------------------------------------------------------------------------
+// A chunk and the range of the instance buffer which holds the translations of its alive cells.
+struct Chunk_Instance_Slot {
+	Coordinate chunk_origin;
+	// the first instance and the number of instances the range has room for, 0 while the chunk had no alive cells.
+	std::size_t offset = 0;
+	std::size_t capacity = 0;
+	std::size_t number_of_instances = 0;
+	// the cells of the uploaded instances, a chunk only gets uploaded again once they differ.
+	Chunk::Row_Bits row_bits = {};
+	// the update which last saw the chunk, the slot gets freed by the first update which does not.
+	std::uint64_t last_update = 0;
+	bool is_used = false;
+	// culled chunks keep their slot but are not drawn, they get compared and uploaded once they are visible again.
+	bool is_visible = false;
+};
+
+// Keeps every chunk at a stable range of one large instance buffer, so that only the chunks whose cells changed get
+// uploaded again (with one glBufferSubData per run of adjacent slots) and a static pattern costs nothing but the draw. The ranges come in power of two
+// sizes from 32 to Chunk::rows * Chunk::columns instances, freed ranges get reused by chunks of the same size class and
+// the buffer doubles (copying on the GPU) when it runs out. All slots are drawn by a single glMultiDrawArraysIndirect if
+// the context has GL 4.3 (loaded through GLFW, our glad loader only knows GL 3.3), otherwise by one draw per slot.
+class Chunk_Instance_Slots {
+public:
+	constexpr static std::size_t INVALID_SLOT_INDEX = ~std::size_t(0);
+
+	Chunk_Instance_Slots();
+
+	~Chunk_Instance_Slots();
+
+	Chunk_Instance_Slots(const Chunk_Instance_Slots&) = delete;
+
+	Chunk_Instance_Slots& operator = (const Chunk_Instance_Slots&) = delete;
+
+	// needs the current OpenGL context. Every instance gets drawn with vertices_per_instance vertices.
+	void initialise(GLsizei vertices_per_instance);
+
+	// returns INVALID_SLOT_INDEX if the chunk has no slot. Safe to call from several threads between updates.
+	std::size_t find_slot(const Coordinate& chunk_origin) const;
+
+	const Chunk_Instance_Slot& get_slot(std::size_t slot_index) const;
+
+	// every slot which is not passed to keep_slot() or update_slot() before end_update() gets freed.
+	void begin_update();
+
+	// safe to call from several threads for different slots.
+	void keep_slot(std::size_t slot_index, bool is_visible);
+
+	// records the new cells of the (visible) chunk and makes room for number_of_instances. slot_index is the current
+	// slot of the chunk or INVALID_SLOT_INDEX, returns the slot whose range the instances have to be upload()ed to.
+	std::size_t update_slot(const Coordinate& chunk_origin, std::size_t slot_index, std::size_t number_of_instances, const Chunk::Row_Bits& row_bits);
+
+	// writes number_of_instances instances from instance offset on, which may span the ranges of several adjacent slots.
+	void upload(std::size_t offset, std::size_t number_of_instances, const glm::vec3* instances);
+
+	// frees the slots of the chunks which are gone and rebuilds the draw commands of the visible slots.
+	void end_update();
+
+	// draws the instances of every slot, the VAO has to be bound.
+	void draw(GLuint attribute_index);
+
+	// of the last update.
+	std::size_t get_number_of_uploaded_chunks() const;
+
+	std::size_t get_number_of_uploaded_instances() const;
+
+	std::size_t get_number_of_uploads() const;
+
+	bool is_using_multi_draw_indirect() const;
+
+private:
+	constexpr static std::size_t MINIMUM_RANGE_SIZE = 32;
+	constexpr static int NUMBER_OF_SIZE_CLASSES = 6;
+	static_assert(MINIMUM_RANGE_SIZE << (NUMBER_OF_SIZE_CLASSES - 1) == Chunk::rows * Chunk::columns);
+
+	// the layout glMultiDrawArraysIndirect reads.
+	struct Draw_Arrays_Indirect_Command {
+		GLuint count;
+		GLuint instance_count;
+		GLuint first;
+		GLuint base_instance;
+	};
+
+	using Multi_Draw_Arrays_Indirect_Function = void (GLAPIENTRY*)(GLenum mode, const void* indirect, GLsizei draw_count, GLsizei stride);
+
+	static int get_size_class(std::size_t number_of_instances);
+
+	void allocate_range(Chunk_Instance_Slot& slot, std::size_t number_of_instances);
+
+	void free_range(Chunk_Instance_Slot& slot);
+
+	void free_slot(std::size_t slot_index);
+
+	void grow_buffer(std::size_t minimum_capacity);
+	//--------------------------------------------------------------------------------
+	// data
+	GLuint instance_buffer;
+	GLuint indirect_buffer;
+	Multi_Draw_Arrays_Indirect_Function multi_draw_arrays_indirect_function;
+
+	std::vector<Chunk_Instance_Slot> slots;
+	std::vector<std::size_t> free_slot_indices;
+	boost::unordered_flat_map<Coordinate, std::size_t> slot_indices_by_chunk_origin;
+
+	// in instances. Ranges get taken from the free lists of their size class first, then from the end.
+	std::size_t buffer_capacity;
+	std::size_t number_of_reserved_instances;
+	std::array<std::vector<std::size_t>, NUMBER_OF_SIZE_CLASSES> free_range_offsets;
+
+	std::uint64_t update_counter;
+	std::size_t number_of_uploaded_chunks;
+	std::size_t number_of_uploaded_instances;
+	std::size_t number_of_uploads;
+
+	// one per visible slot with alive cells, the per slot draws read them as well. The indirect buffer only gets
+	// uploaded when they differ from the previous ones.
+	std::vector<Draw_Arrays_Indirect_Command> draw_commands;
+	std::vector<Draw_Arrays_Indirect_Command> previous_draw_commands;
+	std::size_t indirect_buffer_capacity;
+	GLsizei vertices_per_instance;
+};
@@ -4,28 +4,48 @@ Coordinate::Coordinate() :
 	x(0),
 	y(0)
 {
-	ZoneScoped;
+	ZoneScopedCell;
 }
 
 Coordinate::Coordinate(int a_x, int a_y) :
 	x(a_x),
 	y(a_y)
 {
-	ZoneScoped;
+	ZoneScopedCell;
 }
 
 bool Coordinate::operator == (const Coordinate& rhs) const {
-	ZoneScoped;
+	ZoneScopedCell;
 	return x == rhs.x && y == rhs.y;
 }
 
 bool Coordinate::operator != (const Coordinate& rhs) const {
-	ZoneScoped;
+	ZoneScopedCell;
 	return !(*this == rhs);
 }
 
+// spreads the 32 bits of value out over 64 bits, ie bit i of value ends up at bit 2*i of the result.
+static std::uint64_t spread_bits_for_morton_key(std::uint32_t value) {
+	std::uint64_t result = value;
+	result = (result | (result << 16)) & 0x0000FFFF0000FFFFull;
+	result = (result | (result << 8)) & 0x00FF00FF00FF00FFull;
+	result = (result | (result << 4)) & 0x0F0F0F0F0F0F0F0Full;
+	result = (result | (result << 2)) & 0x3333333333333333ull;
+	result = (result | (result << 1)) & 0x5555555555555555ull;
+	return result;
+}
+
+std::uint64_t Coordinate::morton_key() const {
+	ZoneScopedCell;
+
+	// flip the sign bit, so that negative coordinates get ordered before positive ones.
+	std::uint32_t unsigned_x = static_cast<std::uint32_t>(x) ^ 0x80000000u;
+	std::uint32_t unsigned_y = static_cast<std::uint32_t>(y) ^ 0x80000000u;
+	return (spread_bits_for_morton_key(unsigned_x) << 1) | spread_bits_for_morton_key(unsigned_y);
+}
+
 std::size_t hash_value(Coordinate const& c)
 {
-	ZoneScoped;
+	ZoneScopedCell;
 	return 51 + boost::hash < int >()(c.x) + 51 * boost::hash < int >()(c.y);
 }
\ No newline at end of file
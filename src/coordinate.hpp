@@ -1,8 +1,10 @@
 #pragma once
 
-#include <tracy/Tracy.hpp>
+#include "profiling.hpp"
 #include <boost/container_hash/hash.hpp>
 
+#include <cstdint>
+
 class Coordinate {
 public:
 	Coordinate();
@@ -13,19 +15,32 @@ public:
 
 	bool operator != (const Coordinate& rhs) const;
 
+	// position of the coordinate on the Z-order (Morton) curve. The bits of x and y are interleaved, with the sign bit
+	// flipped first, so that sorting by the key keeps coordinates which are close in 2d space close in memory as well.
+	std::uint64_t morton_key() const;
+
 	int x;
 	int y;
 };
 
 std::size_t hash_value(Coordinate const& c);
 
+// integer division rounding towards negative infinity, eg used to get the chunk coordinate of a cell coordinate.
+inline int floor_divide(int numerator, int denominator) {
+	int quotient = numerator / denominator;
+	if ((numerator % denominator != 0) && ((numerator < 0) != (denominator < 0))) {
+		quotient--;
+	}
+	return quotient;
+}
+
 
 namespace std
 {
 	template<>
 	struct hash<Coordinate> {
 		std::size_t operator()(Coordinate const& coord) const noexcept {
-			ZoneScoped;
+			ZoneScopedCell;
 			return (51 + std::hash<int>()(coord.x) + 51 * std::hash<int>()(coord.y));
 		}
 	};
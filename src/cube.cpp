@@ -16,7 +16,7 @@ m_angle(angle)
 }
 
 const glm::mat4 Cube::compute_model_matrix_no_rotation() const {
-	ZoneScoped;
+	ZoneScopedFrame;
 
 	glm::mat4 model_matrix = glm::translate(glm::mat4(1.0f), m_position);
 
@@ -25,7 +25,7 @@ const glm::mat4 Cube::compute_model_matrix_no_rotation() const {
 
 
 const glm::mat4 Cube::compute_model_matrix_with_rotation() const {
-	ZoneScoped;
+	ZoneScopedFrame;
 
 	glm::mat4 model_matrix = glm::translate(glm::mat4(1.0f), m_position);
 	model_matrix = glm::rotate(model_matrix, m_angle, glm::vec3(1.0f, 0.3f, 0.5f));
@@ -1,62 +1,368 @@
 #include "cube_system.hpp"
+#include "bit_scan.hpp"
 
+#include <algorithm>
+#include <cmath>
+
+//--------------------------------------------------------------------------------
+bool Cube_Render_Settings::operator == (const Cube_Render_Settings& rhs) const {
+	return projection_view_matrix == rhs.projection_view_matrix && viewport_size == rhs.viewport_size && should_expand_cells_on_gpu == rhs.should_expand_cells_on_gpu &&
+		should_use_level_of_detail == rhs.should_use_level_of_detail && level_of_detail_pixels_per_cell == rhs.level_of_detail_pixels_per_cell;
+}
+
+bool Cube_Render_Settings::operator != (const Cube_Render_Settings& rhs) const {
+	return !(*this == rhs);
+}
+
+//--------------------------------------------------------------------------------
 Cube_System::Cube_System() :
-	grid_manager(nullptr),
-	number_of_translation_data(0)
+	number_of_translation_data(0),
+is_expanding_cells_on_gpu(false),
+settings({}),
+render_info({}),
+chunk_populations({}),
+is_chunk_visible({}),
+chunk_levels_of_detail({}),
+chunk_slot_indices({}),
+chunk_numbers_of_alive_cells({}),
+is_chunk_changed({}),
+changed_chunk_indices({}),
+changed_chunk_offsets({}),
+changed_translations({}),
+non_empty_chunk_indices({}),
+population_pyramid(),
+level_of_detail_nodes({}),
+level_of_detail_quads({}),
+level_of_detail_quads_version(0),
+thread_pool(nullptr),
+work_groups({})
 {
+	thread_pool = std::make_unique < Thread_Pool > (std::max(1u, std::thread::hardware_concurrency() / 2));
+}
+
+std::vector<std::pair<int, int>> get_work_group_start_end_indices_pairs(size_t desired_work_group_size, size_t total_number_of_elements) {
+	std::vector<std::pair<int, int>> work_groups;
+	desired_work_group_size = std::max<size_t>(desired_work_group_size, 1);
+	for (size_t start = 0; start < total_number_of_elements; start += desired_work_group_size) {
+		size_t end = std::min(start + desired_work_group_size, total_number_of_elements) - 1;
+		work_groups.push_back(std::make_pair(static_cast<int>(start), static_cast<int>(end)));
+	}
+	return work_groups;
+}
+
+std::size_t Cube_System::find_changed_chunks(const Render_Snapshot& snapshot, const Frustum& frustum, Chunk_Instance_Slots& chunk_instance_slots) {
+	ZoneScopedFrame;
+
+	std::size_t number_of_chunks = snapshot.chunk_bits.size();
+	// a few groups per thread, so that chunks with many more cells than others do not leave threads idle.
+	std::size_t number_of_work_groups = static_cast<std::size_t>(thread_pool->get_number_of_threads()) * 4;
+	work_groups = get_work_group_start_end_indices_pairs((number_of_chunks + number_of_work_groups - 1) / number_of_work_groups, number_of_chunks);
+
+	chunk_populations.resize(number_of_chunks);
+	is_chunk_visible.resize(number_of_chunks);
+	chunk_levels_of_detail.resize(number_of_chunks);
+	chunk_slot_indices.resize(number_of_chunks);
+	chunk_numbers_of_alive_cells.resize(number_of_chunks);
+	is_chunk_changed.resize(number_of_chunks);
+	thread_pool->run_tasks(work_groups.size(), [this, &snapshot, &frustum, &chunk_instance_slots](std::size_t task_index) {
+		for (int i = work_groups[task_index].first; i <= work_groups[task_index].second; i++) {
+			// the population pyramid needs the counts of all chunks.
+			std::size_t number_of_alive_cells = 0;
+			for (std::uint32_t row_bits: snapshot.chunk_bits[i]) {
+				number_of_alive_cells += _mm_popcnt_u32(row_bits);
+			}
+			chunk_populations[i] = number_of_alive_cells;
+
+			auto [origin_row, origin_column] = snapshot.chunk_origins[i];
+			// the cubes of the chunk, the cell at row r and column c is the unit cube around (c, -r, -3).
+			glm::vec3 box_min(origin_column - 0.5f, -(origin_row + Chunk::rows - 1) - 0.5f, -3.5f);
+			glm::vec3 box_max(origin_column + Chunk::columns - 0.5f, -origin_row + 0.5f, -2.5f);
+			bool is_visible = frustum.intersects_box(box_min, box_max);
+			is_chunk_visible[i] = is_visible;
+			chunk_levels_of_detail[i] = static_cast<std::int8_t>(is_visible ? get_level_of_detail(origin_row, origin_column) : -1);
+			std::size_t slot_index = chunk_instance_slots.find_slot(Coordinate(origin_row, origin_column));
+			chunk_slot_indices[i] = slot_index;
+			if (!is_visible || chunk_levels_of_detail[i] >= 0) {
+				// a culled or zoomed out chunk costs nothing here, its slot stays around in case its cubes come back.
+				chunk_numbers_of_alive_cells[i] = 0;
+				is_chunk_changed[i] = false;
+				if (slot_index != Chunk_Instance_Slots::INVALID_SLOT_INDEX) {
+					chunk_instance_slots.keep_slot(slot_index, false);
+				}
+				continue;
+			}
+
+			chunk_numbers_of_alive_cells[i] = number_of_alive_cells;
+			if (slot_index == Chunk_Instance_Slots::INVALID_SLOT_INDEX) {
+				is_chunk_changed[i] = true;
+				continue;
+			}
+			// every chunk has its own slot, so marking it does not race with the other threads.
+			chunk_instance_slots.keep_slot(slot_index, true);
+			is_chunk_changed[i] = chunk_instance_slots.get_slot(slot_index).row_bits != snapshot.chunk_bits[i];
+		}
+	});
 
+	std::size_t number_of_alive_cells = 0;
+	for (std::size_t number_of_chunk_cells: chunk_numbers_of_alive_cells) {
+		number_of_alive_cells += number_of_chunk_cells;
+	}
+	return number_of_alive_cells;
 }
 
-void Cube_System::initialise(std::shared_ptr<Grid_Manager> manager) {
-	grid_manager = manager;
+void Cube_System::update_model_translations_data(const Render_Snapshot& snapshot, glm::vec3* translations) {
+	ZoneScopedFrame;
+
+	std::size_t number_of_changed_chunks = changed_chunk_indices.size();
+	std::size_t number_of_work_groups = static_cast<std::size_t>(thread_pool->get_number_of_threads()) * 4;
+	std::vector<std::pair<int, int>> changed_work_groups = get_work_group_start_end_indices_pairs((number_of_changed_chunks + number_of_work_groups - 1) / number_of_work_groups, number_of_changed_chunks);
+	thread_pool->run_tasks(changed_work_groups.size(), [this, &snapshot, &changed_work_groups, translations](std::size_t task_index) {
+		for (int j = changed_work_groups[task_index].first; j <= changed_work_groups[task_index].second; j++) {
+			std::size_t i = changed_chunk_indices[j];
+			auto [origin_row, origin_column] = snapshot.chunk_origins[i];
+			glm::vec3* translation = translations + changed_chunk_offsets[j];
+			for (int r = 0; r < Chunk::rows; r++) {
+				std::uint32_t row_bits = snapshot.chunk_bits[i][r];
+				float y = static_cast<float>(-(origin_row + r));
+				while (row_bits != 0) {
+					int c = find_lowest_set_bit(row_bits);
+					row_bits &= row_bits - 1;
+					*translation++ = glm::vec3(static_cast<float>(origin_column + c), y, -3.0f);
+				}
+			}
+		}
+	});
 }
 
+int Cube_System::get_level_of_detail(int origin_row, int origin_column) const {
+	if (!settings.should_use_level_of_detail) {
+		return -1;
+	}
+	// the size of the chunk on screen, along both axes in case the camera looks at the grid from the side.
+	glm::vec3 center(origin_column + Chunk::columns * 0.5f - 0.5f, -(origin_row + Chunk::rows * 0.5f) + 0.5f, -3.0f);
+	glm::vec4 clip_center = settings.projection_view_matrix * glm::vec4(center, 1.0f);
+	glm::vec4 clip_right = settings.projection_view_matrix * glm::vec4(center + glm::vec3(Chunk::columns, 0.0f, 0.0f), 1.0f);
+	glm::vec4 clip_up = settings.projection_view_matrix * glm::vec4(center + glm::vec3(0.0f, Chunk::rows, 0.0f), 1.0f);
+	if (clip_center.w <= 0.0f || clip_right.w <= 0.0f || clip_up.w <= 0.0f) {
+		return -1;
+	}
+	glm::vec2 center_pixels = glm::vec2(clip_center) / clip_center.w * settings.viewport_size * 0.5f;
+	float chunk_pixels = std::max(glm::length(glm::vec2(clip_right) / clip_right.w * settings.viewport_size * 0.5f - center_pixels),
+		glm::length(glm::vec2(clip_up) / clip_up.w * settings.viewport_size * 0.5f - center_pixels));
+	if (chunk_pixels >= settings.level_of_detail_pixels_per_cell * Chunk::columns) {
+		return -1;
+	}
+
+	int level = 0;
+	while (level < Population_Pyramid::NUMBER_OF_LEVELS - 1 && chunk_pixels * static_cast<float>(1 << level) < MINIMUM_LEVEL_OF_DETAIL_QUAD_PIXELS) {
+		level++;
+	}
+	return level;
+}
+
+void Cube_System::update_level_of_detail_quads(const Render_Snapshot& snapshot) {
+	ZoneScopedFrame;
+
+	bool had_quads = !level_of_detail_quads.empty();
+	level_of_detail_quads.clear();
+	if (!settings.should_use_level_of_detail) {
+		level_of_detail_quads_version += had_quads ? 1 : 0;
+		return;
+	}
+
+	// only the chunks whose population changed touch the superchunks.
+	population_pyramid.begin_update();
+	for (std::size_t i = 0; i < snapshot.chunk_origins.size(); i++) {
+		auto [origin_row, origin_column] = snapshot.chunk_origins[i];
+		population_pyramid.set_chunk_population(Coordinate(floor_divide(origin_row, Chunk::rows), floor_divide(origin_column, Chunk::columns)), static_cast<std::int64_t>(chunk_populations[i]));
+	}
+	population_pyramid.end_update();
+
+	// every zoomed out chunk wants the node of its level, but a node only gets drawn if none of its visible chunks wants
+	// a lower level (or cubes), otherwise the chunk falls back to the largest node below which satisfies that. Nodes of
+	// a lower level are subsets of the ones above, so the drawn nodes never overlap.
+	for (auto& nodes: level_of_detail_nodes) {
+		nodes.clear();
+	}
+	for (std::size_t i = 0; i < snapshot.chunk_origins.size(); i++) {
+		int level_of_detail = chunk_levels_of_detail[i];
+		if (level_of_detail < 0) {
+			continue;
+		}
+		Coordinate chunk_index(floor_divide(snapshot.chunk_origins[i].first, Chunk::rows), floor_divide(snapshot.chunk_origins[i].second, Chunk::columns));
+		for (int level = 0; level <= level_of_detail; level++) {
+			Level_Of_Detail_Node& node = level_of_detail_nodes[level][Population_Pyramid::get_node(level, chunk_index)];
+			node.minimum_level = std::min(node.minimum_level, level_of_detail);
+		}
+	}
+	for (std::size_t i = 0; i < snapshot.chunk_origins.size(); i++) {
+		if (!is_chunk_visible[i] || chunk_levels_of_detail[i] >= 0) {
+			continue;
+		}
+		Coordinate chunk_index(floor_divide(snapshot.chunk_origins[i].first, Chunk::rows), floor_divide(snapshot.chunk_origins[i].second, Chunk::columns));
+		for (int level = 1; level < Population_Pyramid::NUMBER_OF_LEVELS; level++) {
+			auto it = level_of_detail_nodes[level].find(Population_Pyramid::get_node(level, chunk_index));
+			if (it != level_of_detail_nodes[level].end()) {
+				it->second.minimum_level = -1;
+			}
+		}
+	}
 
-void Cube_System::update_model_translations_data() {
-	ZoneScoped;
+	for (std::size_t i = 0; i < snapshot.chunk_origins.size(); i++) {
+		int level = chunk_levels_of_detail[i];
+		if (level < 0) {
+			continue;
+		}
+		Coordinate chunk_index(floor_divide(snapshot.chunk_origins[i].first, Chunk::rows), floor_divide(snapshot.chunk_origins[i].second, Chunk::columns));
+		Coordinate node_index = Population_Pyramid::get_node(level, chunk_index);
+		// the chunk's own node on level 0 always qualifies.
+		while (level > 0 && level_of_detail_nodes[level][node_index].minimum_level < level) {
+			level--;
+			node_index = Population_Pyramid::get_node(level, chunk_index);
+		}
+		Level_Of_Detail_Node& node = level_of_detail_nodes[level][node_index];
+		if (node.is_drawn) {
+			continue;
+		}
+		node.is_drawn = true;
+		std::int64_t population = population_pyramid.get_population(level, node_index);
+		if (population == 0) {
+			continue;
+		}
+		int size = Chunk::rows << level;
+		float density = static_cast<float>(population) / (static_cast<float>(size) * static_cast<float>(size));
+		level_of_detail_quads.push_back(glm::vec4(node_index.y * size - 0.5f, -(node_index.x * size) + 0.5f, static_cast<float>(size), density));
+	}
+	level_of_detail_quads_version++;
+}
+
+bool Cube_System::update_chunk_bitmaps(const Render_Snapshot& snapshot, Chunk_Bitmap_Buffer& chunk_bitmap_buffer) {
+	ZoneScopedFrame;
 
-	number_of_translation_data = 0;
-	for (Chunk& chunk: grid_manager->grid->chunks) {
-		for (std::size_t i = 0; i < chunk.number_of_alive_cells; ++i) {
-			std::pair<int, int> xy_position = chunk.coordinates_of_alive_cells[i];
-			float x = static_cast<float>(xy_position.first);
-			float y = static_cast<float>(xy_position.second);
-			cubes_translation_data[number_of_translation_data + i] = glm::vec3(x, y, -3.0f);
+	// dead chunks would cost CELLS_PER_CHUNK vertex shader instances each for nothing.
+	non_empty_chunk_indices.clear();
+	for (std::size_t i = 0; i < snapshot.chunk_bits.size(); i++) {
+		if (chunk_numbers_of_alive_cells[i] > 0) {
+			non_empty_chunk_indices.push_back(i);
 		}
-		number_of_translation_data += chunk.number_of_alive_cells;
 	}
+	if (non_empty_chunk_indices.size() > chunk_bitmap_buffer.get_maximum_number_of_chunks()) {
+		return false;
+	}
+
+	std::uint32_t* texels = chunk_bitmap_buffer.begin_write(non_empty_chunk_indices.size());
+	if (texels != nullptr) {
+		std::size_t number_of_chunks = non_empty_chunk_indices.size();
+		std::size_t number_of_work_groups = static_cast<std::size_t>(thread_pool->get_number_of_threads()) * 4;
+		std::vector<std::pair<int, int>> bitmap_work_groups = get_work_group_start_end_indices_pairs((number_of_chunks + number_of_work_groups - 1) / number_of_work_groups, number_of_chunks);
+		thread_pool->run_tasks(bitmap_work_groups.size(), [this, &snapshot, &bitmap_work_groups, texels](std::size_t task_index) {
+			for (int j = bitmap_work_groups[task_index].first; j <= bitmap_work_groups[task_index].second; j++) {
+				std::size_t i = non_empty_chunk_indices[j];
+				std::uint32_t* chunk_texels = texels + static_cast<std::size_t>(j) * Chunk_Bitmap_Buffer::TEXELS_PER_CHUNK;
+				std::copy(snapshot.chunk_bits[i].begin(), snapshot.chunk_bits[i].end(), chunk_texels);
+				// the shader reads the origins back as ints.
+				chunk_texels[Chunk::rows] = static_cast<std::uint32_t>(snapshot.chunk_origins[i].first);
+				chunk_texels[Chunk::rows + 1] = static_cast<std::uint32_t>(snapshot.chunk_origins[i].second);
+			}
+		});
+	}
+	chunk_bitmap_buffer.end_write();
+	return true;
 }
 
-void Cube_System::create_border_cubes_for_grid() {
-	ZoneScoped;
+void Cube_System::create_border_cubes_for_grid(const Render_Snapshot& snapshot, glm::vec3* translations) {
+	ZoneScopedFrame;
 
-	std::vector<std::pair<int, int>> coordinates;
-	for (Chunk& chunk: grid_manager->grid->chunks) {
+	auto add_cube = [&translations](int row, int column) {
+		*translations++ = glm::vec3(static_cast<float>(column), static_cast<float>(-row), -3.0f);
+	};
+	for (std::size_t i = 0; i < snapshot.chunk_origins.size(); i++) {
+		if (!is_chunk_visible[i] || chunk_levels_of_detail[i] >= 0) {
+			continue;
+		}
+		auto [origin_row, origin_column] = snapshot.chunk_origins[i];
 		for (int r = 0; r < Chunk::rows; r++) {
-			coordinates.push_back(std::make_pair(chunk.chunk_origin_row + r, chunk.chunk_origin_column - 1));
-			coordinates.push_back(std::make_pair(chunk.chunk_origin_row + r, chunk.chunk_origin_column + Chunk::columns));
+			add_cube(origin_row + r, origin_column - 1);
+			add_cube(origin_row + r, origin_column + Chunk::columns);
 		}
 		for (int c = 0; c < Chunk::columns; c++) {
-			coordinates.push_back(std::make_pair(chunk.chunk_origin_row -1, chunk.chunk_origin_column + c));
-			coordinates.push_back(std::make_pair(chunk.chunk_origin_row + Chunk::rows, chunk.chunk_origin_column + c));
+			add_cube(origin_row - 1, origin_column + c);
+			add_cube(origin_row + Chunk::rows, origin_column + c);
 		}
 	}
-	for (auto& [x, y]: coordinates) {
-		cubes_translation_data[number_of_translation_data++] = glm::vec3(static_cast<float>(y), static_cast<float>(-x), -3.0f);
-	}
-	
 }
 
 
-void Cube_System::update() {
-	ZoneScoped;
-	
-	if (grid_manager->grid_execution_state.updated_grid_coordinates) {
-		update_model_translations_data();
+void Cube_System::update(const Render_Snapshot& snapshot, const Cube_Render_Settings& a_settings, Chunk_Instance_Slots& chunk_instance_slots, Chunk_Bitmap_Buffer& chunk_bitmap_buffer, Instance_Stream_Buffer& border_buffer) {
+	ZoneScopedFrame;
+
+	settings = a_settings;
+	// the slots keep the cells they uploaded last, so switching back to them only uploads what changed in between.
+	chunk_instance_slots.begin_update();
+	number_of_translation_data = find_changed_chunks(snapshot, Frustum(settings.projection_view_matrix), chunk_instance_slots);
+	update_level_of_detail_quads(snapshot);
+	is_expanding_cells_on_gpu = settings.should_expand_cells_on_gpu && update_chunk_bitmaps(snapshot, chunk_bitmap_buffer);
+	if (is_expanding_cells_on_gpu) {
+		std::fill(is_chunk_changed.begin(), is_chunk_changed.end(), false);
 	}
-	if (grid_manager->grid_execution_state.updated_border_coordinates) {
-		if (grid_manager->grid_execution_state.show_chunk_borders) {
-			create_border_cubes_for_grid();
+
+	// the slots get (re)allocated serially, only the changed chunks get here, for a settled pattern just a few.
+	changed_chunk_indices.clear();
+	for (std::size_t i = 0; i < snapshot.chunk_bits.size(); i++) {
+		if (!is_chunk_changed[i]) {
+			continue;
 		}
+		auto [origin_row, origin_column] = snapshot.chunk_origins[i];
+		chunk_slot_indices[i] = chunk_instance_slots.update_slot(Coordinate(origin_row, origin_column), chunk_slot_indices[i], chunk_numbers_of_alive_cells[i], snapshot.chunk_bits[i]);
+		changed_chunk_indices.push_back(i);
+	}
+
+	// the changed chunks get laid out in changed_translations like their slots in the instance buffer, so that a run of
+	// adjacent slots (like the ones of a churning soup, which got allocated together) is a single upload. The rest of the
+	// range of a slot in the middle of a run gets uploaded as well, it is never drawn.
+	auto get_changed_slot = [&](std::size_t j) -> const Chunk_Instance_Slot& {
+		return chunk_instance_slots.get_slot(chunk_slot_indices[changed_chunk_indices[j]]);
+	};
+	auto is_run_continued = [&](std::size_t j) {
+		return j + 1 < changed_chunk_indices.size() && get_changed_slot(j + 1).offset == get_changed_slot(j).offset + get_changed_slot(j).capacity;
+	};
+	std::sort(changed_chunk_indices.begin(), changed_chunk_indices.end(), [&](std::size_t lhs, std::size_t rhs) {
+		return chunk_instance_slots.get_slot(chunk_slot_indices[lhs]).offset < chunk_instance_slots.get_slot(chunk_slot_indices[rhs]).offset;
+	});
+	changed_chunk_offsets.assign(1, 0);
+	for (std::size_t j = 0; j < changed_chunk_indices.size(); j++) {
+		const Chunk_Instance_Slot& slot = get_changed_slot(j);
+		changed_chunk_offsets.push_back(changed_chunk_offsets.back() + (is_run_continued(j) ? slot.capacity : slot.number_of_instances));
 	}
-}
\ No newline at end of file
+
+	changed_translations.resize(changed_chunk_offsets.back());
+	update_model_translations_data(snapshot, changed_translations.data());
+	std::size_t run_start = 0;
+	for (std::size_t j = 0; j < changed_chunk_indices.size(); j++) {
+		if (is_run_continued(j)) {
+			continue;
+		}
+		chunk_instance_slots.upload(get_changed_slot(run_start).offset, changed_chunk_offsets[j + 1] - changed_chunk_offsets[run_start], changed_translations.data() + changed_chunk_offsets[run_start]);
+		run_start = j + 1;
+	}
+	chunk_instance_slots.end_update();
+
+	std::size_t number_of_visible_chunks = std::count(is_chunk_visible.begin(), is_chunk_visible.end(), true);
+	std::size_t number_of_level_of_detail_chunks = std::count_if(chunk_levels_of_detail.begin(), chunk_levels_of_detail.end(), [](std::int8_t level) { return level >= 0; });
+	std::size_t number_of_cube_chunks = number_of_visible_chunks - number_of_level_of_detail_chunks;
+	render_info.number_of_chunks = static_cast<long long>(snapshot.chunk_bits.size());
+	render_info.number_of_visible_chunks = static_cast<long long>(number_of_visible_chunks);
+	render_info.number_of_cube_cells = static_cast<long long>(number_of_translation_data);
+	render_info.number_of_level_of_detail_chunks = static_cast<long long>(number_of_level_of_detail_chunks);
+	render_info.number_of_level_of_detail_quads = static_cast<long long>(level_of_detail_quads.size());
+	render_info.number_of_uploaded_chunks = static_cast<long long>(is_expanding_cells_on_gpu ? non_empty_chunk_indices.size() : chunk_instance_slots.get_number_of_uploaded_chunks());
+	render_info.number_of_uploads = static_cast<long long>(chunk_instance_slots.get_number_of_uploads());
+	render_info.is_expanding_cells_on_gpu = is_expanding_cells_on_gpu;
+
+	std::size_t number_of_border_cubes = snapshot.show_chunk_borders ? number_of_cube_chunks * (Chunk::rows * 2 + Chunk::columns * 2) : 0;
+	glm::vec3* translations = border_buffer.begin_write(number_of_border_cubes);
+	if (translations != nullptr && number_of_border_cubes > 0) {
+		create_border_cubes_for_grid(snapshot, translations);
+	}
+	border_buffer.end_write();
+}
@@ -1,32 +1,123 @@
 #pragma once
 
-#include <tracy/Tracy.hpp>
+#include "profiling.hpp"
 
 #include <glm/glm.hpp>
 #include "grid.hpp"
+#include "simulation_thread.hpp"
+#include "thread_pool.hpp"
+#include "instance_stream_buffer.hpp"
+#include "chunk_instance_slots.hpp"
+#include "chunk_bitmap_buffer.hpp"
+#include "frustum.hpp"
+#include "population_pyramid.hpp"
 
+#include <array>
+#include <cstdint>
 
+#include <boost/unordered/unordered_flat_map.hpp>
+
+
+// splits [0, total_number_of_elements) into consecutive groups of desired_work_group_size elements (the last one may be
+// smaller), as pairs of the first and the last index of each group.
 std::vector<std::pair<int, int>> get_work_group_start_end_indices_pairs(size_t desired_work_group_size, size_t total_number_of_elements);
 
 
+//--------------------------------------------------------------------------------
+// How the render loop wants the snapshot drawn, an update is due whenever they change.
+struct Cube_Render_Settings {
+	glm::mat4 projection_view_matrix = glm::mat4(1.0f);
+	glm::vec2 viewport_size = glm::vec2(1.0f);
+	bool should_expand_cells_on_gpu = false;
+	// chunks whose cells would get smaller than level_of_detail_pixels_per_cell on screen are drawn as density quads.
+	bool should_use_level_of_detail = false;
+	float level_of_detail_pixels_per_cell = 1.0f;
+
+	bool operator == (const Cube_Render_Settings& rhs) const;
+
+	bool operator != (const Cube_Render_Settings& rhs) const;
+};
+
+// A node of the population pyramid which some zoomed out chunk wants to be drawn as a quad.
+struct Level_Of_Detail_Node {
+	// the lowest level any visible chunk of the node wants, -1 if one of them gets drawn as cubes. The node can only be
+	// drawn if that is not below its own level, so that the quads never overlap each other or cubes.
+	int minimum_level = Population_Pyramid::NUMBER_OF_LEVELS;
+	bool is_drawn = false;
+};
+
 class Cube_System {
 public:
+	// a quad of the population pyramid covers at least this many pixels, smaller ones get merged into their parents.
+	constexpr static float MINIMUM_LEVEL_OF_DETAIL_QUAD_PIXELS = 2.0f;
+
 	Cube_System();
 
-	void initialise(std::shared_ptr<Grid_Manager> manager);
+	// brings the cubes up to date with a new snapshot or new settings, the chunks outside the view frustum get skipped
+	// and the ones too small on screen go into level_of_detail_quads. Only the remaining chunks whose cells changed since
+	// the last update get written into chunk_instance_slots, unless should_expand_cells_on_gpu, then the bitmaps of all
+	// of them with alive cells get written into chunk_bitmap_buffer. The chunk borders get streamed through
+	// border_buffer.
+	void update(const Render_Snapshot& snapshot, const Cube_Render_Settings& a_settings, Chunk_Instance_Slots& chunk_instance_slots, Chunk_Bitmap_Buffer& chunk_bitmap_buffer, Instance_Stream_Buffer& border_buffer);
+
+	// writes the bitmaps and origins of the visible chunks with alive cells, in parallel. Returns false if the texture
+	// buffer can not hold them all.
+	bool update_chunk_bitmaps(const Render_Snapshot& snapshot, Chunk_Bitmap_Buffer& chunk_bitmap_buffer);
 
-	void update();
+	// writes Chunk::rows * 2 + Chunk::columns * 2 cubes per chunk drawn as cubes.
+	void create_border_cubes_for_grid(const Render_Snapshot& snapshot, glm::vec3* translations);
 
-	void create_border_cubes_for_grid();
+	// counts the alive cells of every chunk, culls it against the frustum, picks its level of detail and compares the
+	// cells of the chunks drawn as cubes to the ones in their slots, in parallel. Returns the number of cells drawn as
+	// cubes.
+	std::size_t find_changed_chunks(const Render_Snapshot& snapshot, const Frustum& frustum, Chunk_Instance_Slots& chunk_instance_slots);
 
-	void update_model_translations_data();
+	// the level of the population pyramid the visible chunk wants to be drawn at, -1 for cubes.
+	int get_level_of_detail(int origin_row, int origin_column) const;
+
+	// updates the population pyramid from the chunk populations and picks the quads of the zoomed out chunks.
+	void update_level_of_detail_quads(const Render_Snapshot& snapshot);
+
+	// every changed chunk writes its alive cells at its offset, in parallel.
+	void update_model_translations_data(const Render_Snapshot& snapshot, glm::vec3* translations);
 	//--------------------------------------------------------------------------------
 	// data
-	std::shared_ptr<Grid_Manager> grid_manager;
+	std::size_t number_of_translation_data;
 
-	constexpr static size_t MAX_NUMBER_OF_CUBES = 1000000;
+	// whether the last update went into the chunk bitmaps instead of the chunk slots.
+	bool is_expanding_cells_on_gpu;
+	// of the last update, a camera move needs another one even without a new snapshot.
+	Cube_Render_Settings settings;
+	Render_Info render_info;
 
-	std::array<glm::vec3, MAX_NUMBER_OF_CUBES> cubes_translation_data;
+	// per chunk of the snapshot: its number of alive cells, whether it is in the view frustum, its level of detail (-1
+	// for cubes), its slot (Chunk_Instance_Slots::INVALID_SLOT_INDEX if it has none yet), its number of alive cells drawn
+	// as cubes (0 if culled or zoomed out) and whether those differ from the uploaded ones.
+	std::vector<std::size_t> chunk_populations;
+	std::vector<std::uint8_t> is_chunk_visible;
+	std::vector<std::int8_t> chunk_levels_of_detail;
+	std::vector<std::size_t> chunk_slot_indices;
+	std::vector<std::size_t> chunk_numbers_of_alive_cells;
+	std::vector<std::uint8_t> is_chunk_changed;
 
-	std::size_t number_of_translation_data;
-};
\ No newline at end of file
+	// the changed chunks in the order of their slots, changed_chunk_offsets[i] is the index of the first cube of
+	// changed_chunk_indices[i] in changed_translations and changed_chunk_offsets[number of changed chunks] its size.
+	// Chunks whose slot is followed by the one of the next changed chunk are spaced by the capacity of their slot.
+	std::vector<std::size_t> changed_chunk_indices;
+	std::vector<std::size_t> changed_chunk_offsets;
+	std::vector<glm::vec3> changed_translations;
+
+	// the chunks with alive cells, in the order of the chunk bitmaps.
+	std::vector<std::size_t> non_empty_chunk_indices;
+
+	// the zoomed out chunks, drawn as one quad per pyramid node: x and y of its top left corner, its size in cells and
+	// the fraction of its cells which are alive. The version changes whenever the quads do.
+	Population_Pyramid population_pyramid;
+	std::array<boost::unordered_flat_map<Coordinate, Level_Of_Detail_Node>, Population_Pyramid::NUMBER_OF_LEVELS> level_of_detail_nodes;
+	std::vector<glm::vec4> level_of_detail_quads;
+	std::uint64_t level_of_detail_quads_version;
+
+	// the simulation thread keeps its own pool busy, so the gather only takes half of the hardware threads.
+	std::unique_ptr<Thread_Pool> thread_pool;
+	std::vector<std::pair<int, int>> work_groups;
+};
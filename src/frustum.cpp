@@ -0,0 +1,27 @@
+#include "frustum.hpp"
+
+
+//--------------------------------------------------------------------------------
+Frustum::Frustum(const glm::mat4& projection_view_matrix) :
+	planes({})
+{
+	// glm is column major, row i of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i]).
+	glm::mat4 transposed = glm::transpose(projection_view_matrix);
+	planes[0] = transposed[3] + transposed[0];
+	planes[1] = transposed[3] - transposed[0];
+	planes[2] = transposed[3] + transposed[1];
+	planes[3] = transposed[3] - transposed[1];
+	planes[4] = transposed[3] + transposed[2];
+	planes[5] = transposed[3] - transposed[2];
+}
+
+bool Frustum::intersects_box(const glm::vec3& box_min, const glm::vec3& box_max) const {
+	for (const glm::vec4& plane: planes) {
+		// the corner of the box furthest along the normal, if even that one is below the plane the whole box is.
+		glm::vec3 corner(plane.x >= 0.0f ? box_max.x : box_min.x, plane.y >= 0.0f ? box_max.y : box_min.y, plane.z >= 0.0f ? box_max.z : box_min.z);
+		if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) {
+			return false;
+		}
+	}
+	return true;
+}
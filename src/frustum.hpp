@@ -0,0 +1,23 @@
+#pragma once
+
+#include "profiling.hpp"
+
+#include <array>
+#include <glm/glm.hpp>
+
+
+//--------------------------------------------------------------------------------
+// The six planes of the view frustum of a projection * view matrix, pointing inwards (Gribb and Hartmann).
+class Frustum {
+public:
+	explicit Frustum(const glm::mat4& projection_view_matrix);
+
+	// conservative: true if the axis aligned box may be (partly) visible.
+	bool intersects_box(const glm::vec3& box_min, const glm::vec3& box_max) const;
+
+private:
+	//--------------------------------------------------------------------------------
+	// data
+	// the box is outside if it is below any plane, xyz is the normal and w the distance.
+	std::array<glm::vec4, 6> planes;
+};
@@ -1,11 +1,20 @@
 #include "grid.hpp"
+#include "bit_scan.hpp"
+#include "checksum.hpp"
+#include "pattern_io.hpp"
+
+#include <cstring>
+#include <optional>
 
 Grid_Manager::Grid_Manager()
 : grid_execution_state({})
 {
-	ZoneScoped;
+	ZoneScopedFrame;
 	grid_info = std::make_shared < Grid_Info > ();
 	opencl_context = std::make_shared < OpenCLContext > ();
+	checkpointer = std::make_unique < Grid_Checkpointer > ();
+	Grid_UI_Controls_Info default_ui_info;
+	history = std::make_unique < Grid_History > (default_ui_info.history_keyframe_interval, static_cast<std::size_t>(default_ui_info.history_memory_budget_mb) << 20);
 
 	std::string open_cl_source_code_path = "opencl_grid.c";
 	opencl_context->initialise(open_cl_source_code_path);
@@ -15,32 +24,143 @@ Grid_Manager::Grid_Manager()
 
 
 void Grid_Manager::update_grid_info() {
-	ZoneScoped;
+	ZoneScopedFrame;
 
 	grid_info->iteration = static_cast<int>(grid->iteration);
-	grid_info->number_of_chunks = static_cast<int>(grid->number_of_chunks);
+	grid_info->number_of_chunks = static_cast<int>(grid->chunks.size());
+	grid_info->population = static_cast<long long>(grid->generation_statistics.population);
+	grid_info->number_of_births = static_cast<long long>(grid->generation_statistics.number_of_births);
+	grid_info->number_of_deaths = static_cast<long long>(grid->generation_statistics.number_of_deaths);
+	const Grid_Bounding_Box& bounding_box = grid->generation_statistics.bounding_box;
+	grid_info->has_bounding_box = !bounding_box.is_empty;
+	grid_info->bounding_box_min_row = bounding_box.min_row;
+	grid_info->bounding_box_min_column = bounding_box.min_column;
+	grid_info->bounding_box_max_row = bounding_box.max_row;
+	grid_info->bounding_box_max_column = bounding_box.max_column;
+	grid_info->is_using_time_budget = grid_execution_state.should_use_time_budget;
+	grid_info->iterations_per_time_budget = grid_execution_state.number_of_iterations_per_time_budget;
+	grid_info->estimated_ms_per_iteration = grid_execution_state.estimated_seconds_per_iteration * 1000.0;
+
+	Grid_Checkpoint_Status checkpoint_status = checkpointer->get_status();
+	grid_info->checkpoint_interval = static_cast<int>(checkpoint_settings.interval);
+	grid_info->checkpoint_retention = static_cast<int>(checkpoint_settings.retention);
+	grid_info->number_of_checkpoints = static_cast<int>(checkpoint_status.number_of_checkpoints);
+	grid_info->last_checkpoint_iteration = static_cast<int>(checkpoint_status.last_iteration);
+	grid_info->last_checkpoint_capture_ms = checkpoint_status.last_capture_seconds * 1000.0;
+	grid_info->last_checkpoint_latency_ms = checkpoint_status.last_latency_seconds * 1000.0;
+	grid_info->is_checkpoint_being_written = checkpoint_status.is_writing;
+	grid_info->checkpoint_error = checkpoint_status.error_message;
+
+	History_Statistics history_statistics = history->get_statistics();
+	grid_info->history_first_iteration = static_cast<int>(history_statistics.first_iteration);
+	grid_info->history_last_iteration = static_cast<int>(history_statistics.last_iteration);
+	grid_info->history_number_of_frames = static_cast<int>(history_statistics.number_of_frames);
+	grid_info->history_number_of_keyframes = static_cast<int>(history_statistics.number_of_keyframes);
+	grid_info->history_memory_mb = static_cast<double>(history_statistics.memory_bytes) / (1 << 20);
+	grid_info->history_compression_ratio = history_statistics.memory_bytes > 0 ? history_statistics.uncompressed_bytes / history_statistics.memory_bytes : 0.0;
+}
+
+//--------------------------------------------------------------------------------
+void Grid_Manager::run_next_iteration() {
+	ZoneScopedFrame;
+
+	// set here, so that it also applies to grids which got loaded or restored from the history in the meantime.
+	grid->temporal_block_size = grid_execution_state.temporal_block_size;
+	grid->next_iteration();
+	if (grid_execution_state.should_record_history) {
+		history->record(*grid);
+	}
+}
+
+void Grid_Manager::run_iterations_within_time_budget() {
+	ZoneScopedFrame;
+
+	constexpr int MAXIMUM_NUMBER_OF_ITERATIONS_PER_TIME_BUDGET = 1000000;
+
+	Grid_Execution_State& state = grid_execution_state;
+	auto start_time = std::chrono::steady_clock::now();
+	int number_of_iterations = 0;
+	double seconds = 0.0;
+	// a pattern which suddenly grows makes the planned number of iterations too expensive, so we give up at twice the
+	// budget instead of waiting for the estimate to catch up.
+	while (number_of_iterations < state.number_of_iterations_per_time_budget && seconds < 2.0 * state.time_budget_seconds) {
+		run_next_iteration();
+		number_of_iterations++;
+		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+	}
+
+	// a moving average, so that a single slow generation (eg a checkpoint capture) does not throw the estimate off.
+	double seconds_per_iteration = seconds / number_of_iterations;
+	if (state.estimated_seconds_per_iteration > 0.0) {
+		state.estimated_seconds_per_iteration = 0.8 * state.estimated_seconds_per_iteration + 0.2 * seconds_per_iteration;
+	} else {
+		state.estimated_seconds_per_iteration = seconds_per_iteration;
+	}
+
+	// hysteresis, the number of iterations only follows the estimate once they differ by more than 15%. Otherwise the
+	// noise of the measurement would change it every update and the generation rate would jitter.
+	double fitting_number_of_iterations = state.time_budget_seconds / std::max(state.estimated_seconds_per_iteration, 1e-9);
+	int target_number_of_iterations = static_cast<int>(std::clamp(fitting_number_of_iterations, 1.0, static_cast<double>(MAXIMUM_NUMBER_OF_ITERATIONS_PER_TIME_BUDGET)));
+	int current_number_of_iterations = state.number_of_iterations_per_time_budget;
+	if (target_number_of_iterations > current_number_of_iterations * 1.15 || target_number_of_iterations < current_number_of_iterations * 0.85) {
+		state.number_of_iterations_per_time_budget = target_number_of_iterations;
+	}
+}
+
+void Grid_Manager::seek_grid_history(std::size_t iteration) {
+	ZoneScopedFrame;
+
+	std::unique_ptr<Grid> restored_grid = std::make_unique < Grid > (opencl_context, false);
+	std::string error_message;
+	if (!history->restore(iteration, *restored_grid, error_message)) {
+		grid_info->history_error = error_message;
+		return;
+	}
+	restored_grid->finish_pattern_creation();
+	grid = std::move(restored_grid);
+	grid->should_update_coordinates_of_alive_cells = false;
+	grid_info->history_error.clear();
+	grid_execution_state.is_running = false;
+	grid_execution_state.grid_got_replaced = true;
 }
 
 //--------------------------------------------------------------------------------
-void Grid_Manager::create_new_grid() {
-	ZoneScoped;
+void Grid_Manager::create_new_grid(const std::string& pattern_path) {
+	ZoneScopedFrame;
 	
+	bool should_record_history = grid_execution_state.should_record_history;
 	grid_execution_state = {};
 	grid_execution_state.use_opencl_kernel = opencl_context->is_valid_context;
+	grid_execution_state.should_record_history = should_record_history;
+	grid_execution_state.grid_got_replaced = true;
+	history->clear();
 	
-	grid = std::make_unique < Grid > (opencl_context);
-	
+	grid_info->pattern_load_error.clear();
+	if (pattern_path.empty()) {
+		grid = std::make_unique < Grid > (opencl_context);
+	} else {
+		grid = std::make_unique < Grid > (opencl_context, false);
+		std::string error_message;
+		if (!load_pattern_file(pattern_path, *grid, error_message)) {
+			// fall back to the default pattern, so that the user does not end up with a broken grid.
+			std::cout << error_message << std::endl;
+			grid_info->pattern_load_error = error_message;
+			grid = std::make_unique < Grid > (opencl_context);
+		}
+	}
+	// the renderer gets the chunk bitmaps through Render_Snapshot, so the grid does not have to extract coordinates.
+	grid->should_update_coordinates_of_alive_cells = false;
 }
 
 void Grid_Manager::update_grid_execution_state(const Grid_UI_Controls_Info& ui_info) {
-	ZoneScoped;
+	ZoneScopedFrame;
 
 	switch (ui_info.button_type) {
 		case GRID_NO_BUTTON_PRESSED:
 			break;
 		case GRID_RESET_BUTTON_PRESSED:
 			grid.reset();
-			create_new_grid();
+			create_new_grid(std::string(ui_info.pattern_path.data()));
 			return;
 			// if you remove the return somehow later, dont forget a break statement here :)
 			// break;
@@ -54,32 +174,56 @@ void Grid_Manager::update_grid_execution_state(const Grid_UI_Controls_Info& ui_i
 			grid_execution_state.is_running = !grid_execution_state.is_running;
 			grid_execution_state.time_since_last_iteration = 0.0f;
 			break;
+		case GRID_STEP_BACK_BUTTON_PRESSED:
+			if (grid->iteration > 0) {
+				seek_grid_history(grid->iteration - 1);
+			}
+			break;
+		case GRID_SEEK_BUTTON_PRESSED:
+			seek_grid_history(static_cast<std::size_t>(std::max(ui_info.history_seek_iteration, 0)));
+			break;
 		default:
 			break;
 	}
-	// check if the user changed to show/hide the grid borders.
-	grid_execution_state.have_to_update_chunk_borders = grid_execution_state.show_chunk_borders != ui_info.show_chunk_borders;
-	
-	// set it to actual new value always.
 	grid_execution_state.show_chunk_borders = ui_info.show_chunk_borders;
 	grid_execution_state.grid_speed = ui_info.grid_speed_slider_value;
 	grid_execution_state.should_run_at_max_possible_speed = ui_info.run_grid_at_max_possible_speed;
 	grid_execution_state.number_of_iterations_per_single_frame = ui_info.number_of_grid_iterations_per_single_frame;
+	grid_execution_state.should_use_time_budget = ui_info.should_use_time_budget;
+	grid_execution_state.time_budget_seconds = std::clamp(ui_info.time_budget_ms, ui_info.min_time_budget_ms, ui_info.max_time_budget_ms) / 1000.0;
+	grid_execution_state.temporal_block_size = std::clamp(ui_info.temporal_block_size, 1, MAXIMUM_TEMPORAL_BLOCK_SIZE);
+
+	checkpoint_settings.interval = ui_info.should_write_checkpoints ? static_cast<std::size_t>(std::max(ui_info.checkpoint_interval, 1)) : 0;
+	checkpoint_settings.retention = static_cast<std::size_t>(std::max(ui_info.checkpoint_retention, 1));
+	checkpoint_settings.directory = std::string(ui_info.checkpoint_directory.data());
+	checkpoint_settings.maximum_capture_memory_mb = static_cast<std::size_t>(std::max(ui_info.checkpoint_memory_mb, 0));
+
+	if (grid_execution_state.should_record_history && !ui_info.should_record_history) {
+		history->clear();
+	}
+	grid_execution_state.should_record_history = ui_info.should_record_history;
+	history->set_keyframe_interval(static_cast<std::size_t>(std::max(ui_info.history_keyframe_interval, 1)));
+	history->set_memory_budget(static_cast<std::size_t>(std::max(ui_info.history_memory_budget_mb, 1)) << 20);
 }
 
-void Grid_Manager::update(double dt, const Grid_UI_Controls_Info& ui_info) {
-	ZoneScoped;
-	
-	update_grid_execution_state(ui_info);
-	
-	grid_execution_state.updated_grid_coordinates = false;
-	grid_execution_state.updated_border_coordinates = false;
+bool Grid_Manager::update(double dt) {
+	ZoneScopedFrame;
 
-	bool grid_changed = false;
+	// the generation the recording starts at, every later one gets recorded by run_next_iteration().
+	if (grid_execution_state.should_record_history && history->is_empty()) {
+		history->record(*grid);
+	}
+
+	bool grid_changed = grid_execution_state.grid_got_replaced;
+	grid_execution_state.grid_got_replaced = false;
 	if (grid_execution_state.is_running) {
 		if (grid_execution_state.should_run_at_max_possible_speed) {
-			for (int i = 0; i < grid_execution_state.number_of_iterations_per_single_frame; i++) {
-				grid->next_iteration();
+			if (grid_execution_state.should_use_time_budget) {
+				run_iterations_within_time_budget();
+			} else {
+				for (int i = 0; i < grid_execution_state.number_of_iterations_per_single_frame; i++) {
+					run_next_iteration();
+				}
 			}
 			grid_changed = true;
 		} else {
@@ -87,7 +231,7 @@ void Grid_Manager::update(double dt, const Grid_UI_Controls_Info& ui_info) {
 			grid_execution_state.time_since_last_iteration += (float) dt;
 			float threshold = 1.0f / grid_execution_state.grid_speed;
 			if (grid_execution_state.time_since_last_iteration >= threshold) {
-				grid->next_iteration();
+				run_next_iteration();
 				grid_changed = true;
 				grid_execution_state.time_since_last_iteration = 0.0f;
 			}
@@ -95,42 +239,58 @@ void Grid_Manager::update(double dt, const Grid_UI_Controls_Info& ui_info) {
 	} else {
 		if (grid_execution_state.run_manual_next_iteration) {
 			grid_execution_state.run_manual_next_iteration = false;
-			grid->next_iteration();
+			run_next_iteration();
 			grid_changed = true;
 		}
 	}
 
-	// only update coordinates of alive grid cells if we are in the first iteration or if the grid changed.
-	if (grid->iteration == 0 || grid_changed) {
-		grid_execution_state.updated_grid_coordinates = true;
-	}
-
-	if (grid->iteration == 0 || (grid_execution_state.show_chunk_borders && grid_changed) || grid_execution_state.have_to_update_chunk_borders) {
-		grid_execution_state.updated_border_coordinates = true;
+	// capturing only marks the chunks, the next generation copies them and the checkpointer writes them on its own
+	// thread. A paused grid has no next generation, so it copies them right away.
+	if (grid_changed) {
+		checkpointer->update(*grid, checkpoint_settings);
+	} else if (!grid_execution_state.is_running) {
+		checkpointer->finish_capture(*grid);
 	}
-	// @Cleanup, factor this into a grid_info->update() call?
-	update_grid_info();
+	return grid_changed;
 }
 
 //--------------------------------------------------------------------------------
-Grid::Grid(std::shared_ptr<OpenCLContext> context) :
+Grid::Grid(std::shared_ptr<OpenCLContext> context, bool should_create_default_pattern) :
 	iteration(0),
 number_of_chunks(0),
-chunk_map({}),
+number_of_chunk_changes_since_last_sort(0),
 chunks({}),
-opencl_context(context)
+neighbour_update_infos_per_task({}),
+minimum_number_of_chunks_per_task(500),
+temporal_block_size(1),
+temporal_block_row_bits({}),
+temporal_block_edge_flags({}),
+should_update_coordinates_of_alive_cells(true),
+thread_pool(nullptr),
+phase_timings({}),
+generation_statistics({}),
+generation_statistics_per_task({}),
+opencl_context(context),
+snapshot_capture(nullptr)
 {
-	ZoneScoped;
-
-	constexpr static int EXPECTED_MAX_NUMBER_OF_CHUNKS = 1000;
-	chunks_left_side_update_infos.reserve(EXPECTED_MAX_NUMBER_OF_CHUNKS);
-	chunks_right_side_update_infos.reserve(EXPECTED_MAX_NUMBER_OF_CHUNKS);
-	chunks_top_side_update_infos.reserve(EXPECTED_MAX_NUMBER_OF_CHUNKS);
-	chunks_bottom_side_update_infos.reserve(EXPECTED_MAX_NUMBER_OF_CHUNKS);
-	top_left_corner_update_infos.reserve(EXPECTED_MAX_NUMBER_OF_CHUNKS);
-	top_right_corner_update_infos.reserve(EXPECTED_MAX_NUMBER_OF_CHUNKS);
-	bottom_left_corner_update_infos.reserve(EXPECTED_MAX_NUMBER_OF_CHUNKS);
-	bottom_right_corner_update_infos.reserve(EXPECTED_MAX_NUMBER_OF_CHUNKS);
+	ZoneScopedPhase;
+
+	set_number_of_threads(std::thread::hardware_concurrency());
+
+	if (should_create_default_pattern) {
+		create_default_pattern();
+	}
+}
+
+Grid::~Grid() {
+	ZoneScopedPhase;
+
+	// the checkpointer may still wait for the capture, it outlives the grid.
+	finish_snapshot_capture();
+}
+
+void Grid::create_default_pattern() {
+	ZoneScopedPhase;
 
 	int base_row = (int) (Chunk::rows / 2);
 	int base_column = (int) (Chunk::columns / 2);
@@ -163,85 +323,438 @@ opencl_context(context)
 			create_new_chunk_and_set_alive_cells(Coordinate(r, c), initial_coordinates);
 		}
 	}
-	
+	finish_pattern_creation();
+}
+
+void Grid::create_random_soup(int size, float density, std::uint32_t seed) {
+	ZoneScopedPhase;
+
+	finish_snapshot_capture();
+
+	// fills the square [-size/2, size - size/2)^2 chunk by chunk, so we only look up each chunk once.
+	std::mt19937 random_number_generator(seed);
+	std::bernoulli_distribution is_alive_distribution(density);
+
+	int first_cell = -size / 2;
+	int last_cell = first_cell + size - 1;
+	int first_chunk_row = floor_divide(first_cell, Chunk::rows);
+	int last_chunk_row = floor_divide(last_cell, Chunk::rows);
+	int first_chunk_column = floor_divide(first_cell, Chunk::columns);
+	int last_chunk_column = floor_divide(last_cell, Chunk::columns);
+
+	std::vector<std::pair<int, int>> alive_cells_coordinates;
+	for (int chunk_row = first_chunk_row; chunk_row <= last_chunk_row; chunk_row++) {
+		for (int chunk_column = first_chunk_column; chunk_column <= last_chunk_column; chunk_column++) {
+			alive_cells_coordinates.clear();
+			for (int r = 0; r < Chunk::rows; r++) {
+				int row = chunk_row * Chunk::rows + r;
+				if (row < first_cell || row > last_cell) {
+					continue;
+				}
+				for (int c = 0; c < Chunk::columns; c++) {
+					int column = chunk_column * Chunk::columns + c;
+					if (column < first_cell || column > last_cell) {
+						continue;
+					}
+					if (is_alive_distribution(random_number_generator)) {
+						alive_cells_coordinates.push_back(std::make_pair(r, c));
+					}
+				}
+			}
+			if (alive_cells_coordinates.empty()) {
+				continue;
+			}
+			Coordinate chunk_coordinate = Coordinate(chunk_row, chunk_column);
+			std::size_t chunk_index = chunk_map.find(chunk_coordinate);
+			if (chunk_index == Chunk_Directory::INVALID_CHUNK_INDEX) {
+				create_new_chunk_and_set_alive_cells(chunk_coordinate, alive_cells_coordinates);
+			} else {
+				Chunk& chunk = chunks[chunk_index];
+				for (auto [r, c]: alive_cells_coordinates) {
+					chunk.cells_data[r * Chunk::rows + c] = 0xFF;
+				}
+				chunk.has_alive_cells = true;
+			}
+		}
+	}
+	finish_pattern_creation();
+}
+
+void Grid::set_cell_alive(int row, int column) {
+	ZoneScopedCell;
+
+	finish_snapshot_capture();
+
+	Coordinate chunk_coordinate = Coordinate(floor_divide(row, Chunk::rows), floor_divide(column, Chunk::columns));
+	std::size_t chunk_index = chunk_map.find(chunk_coordinate);
+	if (chunk_index == Chunk_Directory::INVALID_CHUNK_INDEX) {
+		chunk_index = chunks.size();
+		create_new_chunk(chunk_coordinate);
+		number_of_chunks = chunks.size();
+	}
+	Chunk& chunk = chunks[chunk_index];
+	int r = row - chunk.chunk_origin_row;
+	int c = column - chunk.chunk_origin_column;
+	chunk.cells_data[r * Chunk::rows + c] = 0xFF;
+	chunk.has_alive_cells = true;
+}
+
+void Grid::set_alive_cell_run(int row, int first_column, int number_of_cells) {
+	ZoneScopedCell;
+
+	finish_snapshot_capture();
+
+	int chunk_row = floor_divide(row, Chunk::rows);
+	int r = row - chunk_row * Chunk::rows;
+	int column = first_column;
+	int end_column = first_column + number_of_cells;
+	while (column < end_column) {
+		int chunk_column = floor_divide(column, Chunk::columns);
+		int c = column - chunk_column * Chunk::columns;
+		int number_of_cells_in_chunk = std::min(Chunk::columns - c, end_column - column);
+
+		Coordinate chunk_coordinate = Coordinate(chunk_row, chunk_column);
+		std::size_t chunk_index = chunk_map.find(chunk_coordinate);
+		if (chunk_index == Chunk_Directory::INVALID_CHUNK_INDEX) {
+			chunk_index = chunks.size();
+			create_new_chunk(chunk_coordinate);
+		}
+		Chunk& chunk = chunks[chunk_index];
+		std::memset(&chunk.cells_data[r * Chunk::columns + c], 0xFF, number_of_cells_in_chunk);
+		chunk.has_alive_cells = true;
+
+		column += number_of_cells_in_chunk;
+	}
+	number_of_chunks = chunks.size();
+}
+
+void Grid::finish_pattern_creation() {
+	ZoneScopedPhase;
+
+	sort_chunks_by_morton_key();
+	number_of_chunks = chunks.size();
+
 	update_coordinates_of_alive_cells_for_all_chunks();
+	recount_generation_statistics();
+}
+
+void Grid::recount_generation_statistics() {
+	ZoneScopedPhase;
+
+	generation_statistics = {};
+	for (Chunk& chunk: chunks) {
+		chunk.update_population_and_occupancy();
+		generation_statistics.add_chunk(chunk);
+	}
+	generation_statistics.bounding_box = get_bounding_box();
+}
+
+Grid_Bounding_Box Grid::get_bounding_box() const {
+	ZoneScopedPhase;
+
+	Grid_Bounding_Box bounding_box;
+	if (chunk_extent_index.is_empty()) {
+		return bounding_box;
+	}
+
+	auto get_chunk = [this](int chunk_row, int chunk_column) -> const Chunk& {
+		return chunks[chunk_map.find(Coordinate(chunk_row, chunk_column))];
+	};
+	// walks the chunk rows (or columns) from one end until one of them has a chunk with alive cells, and returns the
+	// tightest bound of the chunks in there. Empty chunks only exist within a generation or before
+	// finish_pattern_creation(), so this usually stops at the first row.
+	auto find_bound = [](auto begin, auto end, auto get_bound_of_chunk, auto is_better) {
+		for (auto line = begin; line != end; ++line) {
+			bool has_bound = false;
+			int bound = 0;
+			for (int other_coordinate: line->second) {
+				std::optional<int> chunk_bound = get_bound_of_chunk(line->first, other_coordinate);
+				if (chunk_bound && (!has_bound || is_better(*chunk_bound, bound))) {
+					bound = *chunk_bound;
+					has_bound = true;
+				}
+			}
+			if (has_bound) {
+				return std::optional<int>(bound);
+			}
+		}
+		return std::optional<int>();
+	};
+	auto is_smaller = [](int a, int b) { return a < b; };
+	auto is_bigger = [](int a, int b) { return a > b; };
+
+	const std::map<int, std::set<int>>& columns_by_row = chunk_extent_index.get_columns_by_row();
+	const std::map<int, std::set<int>>& rows_by_column = chunk_extent_index.get_rows_by_column();
+	std::optional<int> min_row = find_bound(columns_by_row.begin(), columns_by_row.end(), [&](int chunk_row, int chunk_column) {
+		const Chunk& chunk = get_chunk(chunk_row, chunk_column);
+		return chunk.row_occupancy_mask ? std::optional<int>(chunk.chunk_origin_row + find_lowest_set_bit(chunk.row_occupancy_mask)) : std::nullopt;
+	}, is_smaller);
+	if (!min_row) {
+		return bounding_box;
+	}
+	std::optional<int> max_row = find_bound(columns_by_row.rbegin(), columns_by_row.rend(), [&](int chunk_row, int chunk_column) {
+		const Chunk& chunk = get_chunk(chunk_row, chunk_column);
+		return chunk.row_occupancy_mask ? std::optional<int>(chunk.chunk_origin_row + find_highest_set_bit(chunk.row_occupancy_mask)) : std::nullopt;
+	}, is_bigger);
+	std::optional<int> min_column = find_bound(rows_by_column.begin(), rows_by_column.end(), [&](int chunk_column, int chunk_row) {
+		const Chunk& chunk = get_chunk(chunk_row, chunk_column);
+		return chunk.column_occupancy_mask ? std::optional<int>(chunk.chunk_origin_column + find_lowest_set_bit(chunk.column_occupancy_mask)) : std::nullopt;
+	}, is_smaller);
+	std::optional<int> max_column = find_bound(rows_by_column.rbegin(), rows_by_column.rend(), [&](int chunk_column, int chunk_row) {
+		const Chunk& chunk = get_chunk(chunk_row, chunk_column);
+		return chunk.column_occupancy_mask ? std::optional<int>(chunk.chunk_origin_column + find_highest_set_bit(chunk.column_occupancy_mask)) : std::nullopt;
+	}, is_bigger);
+
+	bounding_box.is_empty = false;
+	bounding_box.min_row = *min_row;
+	bounding_box.max_row = *max_row;
+	bounding_box.min_column = *min_column;
+	bounding_box.max_column = *max_column;
+	return bounding_box;
+}
+
+void Grid::set_number_of_threads(unsigned int number_of_threads) {
+	ZoneScopedPhase;
+
+	if (number_of_threads == 0) {
+		number_of_threads = 1;
+	}
+	if (thread_pool && thread_pool->get_number_of_threads() == number_of_threads) {
+		return;
+	}
+	thread_pool = std::make_unique < Thread_Pool > (number_of_threads);
+}
+
+std::size_t Grid::count_alive_cells() const {
+	ZoneScopedPhase;
+
+	std::size_t number_of_alive_cells = 0;
+	for (const Chunk& chunk: chunks) {
+		for (unsigned char value: chunk.cells_data) {
+			number_of_alive_cells += value ? 1 : 0;
+		}
+	}
+	return number_of_alive_cells;
+}
+
+std::uint64_t Grid::compute_checksum() const {
+	ZoneScopedPhase;
+
+	std::uint64_t checksum = 0;
+	for (const Chunk& chunk: chunks) {
+		for (int r = 0; r < Chunk::rows; r++) {
+			for (int c = 0; c < Chunk::columns; c++) {
+				if (chunk.cells_data[r * Chunk::columns + c]) {
+					checksum += get_alive_cell_hash(chunk.chunk_origin_row + r, chunk.chunk_origin_column + c);
+				}
+			}
+		}
+	}
+	return checksum;
+}
+
+std::vector<std::pair<int, int>> Grid::get_alive_cells() const {
+	ZoneScopedPhase;
+
+	std::vector<std::pair<int, int>> alive_cells;
+	for (const Chunk& chunk: chunks) {
+		for (int r = 0; r < Chunk::rows; r++) {
+			for (int c = 0; c < Chunk::columns; c++) {
+				if (chunk.cells_data[r * Chunk::columns + c]) {
+					alive_cells.push_back(std::make_pair(chunk.chunk_origin_row + r, chunk.chunk_origin_column + c));
+				}
+			}
+		}
+	}
+	std::sort(alive_cells.begin(), alive_cells.end());
+	return alive_cells;
 }
 
 
+void Grid::begin_snapshot_capture(std::shared_ptr<Grid_Snapshot_Capture> capture) {
+	ZoneScopedPhase;
+
+	finish_snapshot_capture();
+	capture->iteration = iteration;
+	capture->is_complete = chunks.empty();
+	resize_grid_snapshot_capture(*capture, chunks.size());
+	if (capture->is_complete) {
+		return;
+	}
+	snapshot_capture = std::move(capture);
+
+	// chunk idx gets bitmap idx, write_grid_snapshot() sorts them on the writing thread.
+	run_for_all_chunks_in_parallel([this](std::size_t task_index, std::pair<std::size_t, std::size_t> start_end_index_pair) {
+		for (std::size_t idx = start_end_index_pair.first; idx <= start_end_index_pair.second; idx++) {
+			Chunk& chunk = chunks[idx];
+			snapshot_capture->directory[idx] = Snapshot_Chunk_Entry{ chunk.grid_coordinate_row, chunk.grid_coordinate_column };
+			chunk.snapshot_bitmap_index = static_cast<std::uint32_t>(idx);
+		}
+	});
+}
+
+void Grid::finish_snapshot_capture() {
+	ZoneScopedPhase;
+
+	if (!snapshot_capture) {
+		return;
+	}
+	run_for_all_chunks_in_parallel([this](std::size_t task_index, std::pair<std::size_t, std::size_t> start_end_index_pair) {
+		for (std::size_t idx = start_end_index_pair.first; idx <= start_end_index_pair.second; idx++) {
+			copy_chunk_into_snapshot_capture(chunks[idx]);
+		}
+	});
+	snapshot_capture->is_complete = true;
+	snapshot_capture.reset();
+}
+
+void Grid::copy_chunk_into_snapshot_capture(Chunk& chunk) {
+	if (chunk.snapshot_bitmap_index == Chunk::NO_SNAPSHOT_BITMAP) {
+		return;
+	}
+	std::memcpy(snapshot_capture->bitmaps[chunk.snapshot_bitmap_index].cells.data(), chunk.cells_data.data(), SNAPSHOT_BITMAP_SIZE);
+	chunk.snapshot_bitmap_index = Chunk::NO_SNAPSHOT_BITMAP;
+}
+
 void Grid::create_new_chunk_and_set_alive_cells(const Coordinate& coord, const std::vector<std::pair<int, int>>& coordinates) {
-	ZoneScoped;
+	ZoneScopedChunk;
 
 	const Coordinate& origin_coordinate = Coordinate(coord.x * Chunk::rows, coord.y * Chunk::columns);
 
 	std::size_t chunk_index = chunks.size();
 	chunks.emplace_back(coord, origin_coordinate, coordinates);
 
-	chunk_map.insert(std::make_pair(coord, chunk_index));
+	chunk_map.insert(coord, chunk_index);
+	chunk_extent_index.insert(coord);
+	number_of_chunk_changes_since_last_sort++;
 }
 
 void Grid::create_new_chunk(const Coordinate& coord) {
-	ZoneScoped;
+	ZoneScopedChunk;
 
 	create_new_chunk_and_set_alive_cells(coord, {});
 }
 
 //--------------------------------------------------------------------------------
+double Grid_Phase_Timings::total() const {
+	return update_neighbour_count_and_set_info + create_needed_chunks + update_neighbours + update_cells + remove_empty_chunks + sort_chunks + update_coordinates_of_alive_cells;
+}
+
 void Grid::update() {
-	ZoneScoped;
+	ZoneScopedPhase;
 }
 
 void Grid::next_iteration() {
-	ZoneScoped;
+	ZoneScopedPhase;
 
 	if (chunks.size() == 0) {
+		generation_statistics = {};
 		return;
 	}
 
-	update_neighbour_count_and_set_info_of_all_chunks();
+	// returns the seconds since phase_start_time and restarts the measurement for the next phase.
+	std::chrono::steady_clock::time_point phase_start_time = std::chrono::steady_clock::now();
+	auto end_phase = [&phase_start_time]() {
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		double seconds = std::chrono::duration<double>(now - phase_start_time).count();
+		phase_start_time = now;
+		return seconds;
+	};
+
+	int number_of_generations = std::clamp(temporal_block_size, 1, MAXIMUM_TEMPORAL_BLOCK_SIZE);
+	if (number_of_generations > 1) {
+		update_row_bits_and_edge_flags_of_all_chunks(number_of_generations);
+		phase_timings.update_neighbour_count_and_set_info = end_phase();
+
+		create_needed_neighbours_for_temporal_block();
+		phase_timings.create_needed_chunks = end_phase();
+		phase_timings.update_neighbours = 0.0;
+
+		advance_all_chunks_temporally_blocked(number_of_generations);
+		phase_timings.update_cells = end_phase();
+	} else {
+		update_neighbour_count_and_set_info_of_all_chunks();
+		phase_timings.update_neighbour_count_and_set_info = end_phase();
 
-	for (Coordinate coord: coordinates_of_chunks_to_create) {
-		if (!chunk_map.contains(coord)) {
-			create_new_chunk(coord);
+		for (const ChunkNeighbourUpdateInfos& infos: neighbour_update_infos_per_task) {
+			for (Coordinate coord: infos.coordinates_of_chunks_to_create) {
+				if (!chunk_map.contains(coord)) {
+					create_new_chunk(coord);
+				}
+			}
 		}
+		phase_timings.create_needed_chunks = end_phase();
+
+		update_neighbours_of_all_chunks();
+		phase_timings.update_neighbours = end_phase();
+
+		update_cells_of_all_chunks();
+		phase_timings.update_cells = end_phase();
 	}
 
-	update_neighbours_of_all_chunks();
+	// both kernels copied every marked chunk into the open capture before overwriting its cells, and no chunk got
+	// removed since the capture started.
+	if (snapshot_capture) {
+		snapshot_capture->is_complete = true;
+		snapshot_capture.reset();
+	}
 
-	update_cells_of_all_chunks();
-	
 	remove_empty_chunks();
+	phase_timings.remove_empty_chunks = end_phase();
+
+	sort_chunks_by_morton_key_if_needed();
+	phase_timings.sort_chunks = end_phase();
 	
-	update_coordinates_of_alive_cells_for_all_chunks();
+	if (should_update_coordinates_of_alive_cells) {
+		update_coordinates_of_alive_cells_for_all_chunks();
+	}
+	phase_timings.update_coordinates_of_alive_cells = end_phase();
 	
-	iteration++;
+	iteration += number_of_generations;
+	number_of_chunks = chunks.size();
+	generation_statistics.bounding_box = get_bounding_box();
 	
 	assert(chunk_map.size() == chunks.size());
 }
 
 void Grid::update_coordinates_of_alive_cells_for_all_chunks() {
-	ZoneScoped;
+	ZoneScopedPhase;
+
+	run_for_all_chunks_in_parallel([this](std::size_t task_index, std::pair<std::size_t, std::size_t> start_end_index_pair) {
+		for (std::size_t idx = start_end_index_pair.first; idx <= start_end_index_pair.second; idx++) {
+			chunks[idx].update_coordinates_of_alive_cells();
+		}
+	});
+}
+
+void Grid::run_for_all_chunks_in_parallel(const std::function<void(std::size_t, std::pair<std::size_t, std::size_t>)>& function) {
+	ZoneScopedPhase;
 
-	for(std::size_t idx = 0; idx < chunks.size(); idx++) {
-		chunks[idx].update_coordinates_of_alive_cells();
+	if (chunks.empty()) {
+		return;
 	}
+	std::vector<std::pair<std::size_t, std::size_t>> partition = get_partition_data_for_chunks(thread_pool->get_number_of_threads(), false);
+	thread_pool->run_tasks(partition.size(), [&partition, &function](std::size_t task_index) {
+		function(task_index, partition[task_index]);
+	});
 }
 
 std::vector<std::pair<std::size_t, std::size_t>> Grid::get_partition_data_for_chunks(unsigned int number_of_workers, bool allow_small_task_sizes) {
-	ZoneScoped;
+	ZoneScopedPhase;
 
-	constexpr static std::size_t MINIMUM_NUMBER_OF_CHUNKS_PER_THREAD = 500;
-	
 	std::size_t number_of_chunks = chunks.size();
 	assert(chunks.size() == chunk_map.size());
 
+	std::size_t minimum_chunks_per_task = std::max<std::size_t>(1, minimum_number_of_chunks_per_task);
+
 	std::vector<std::pair<std::size_t, std::size_t>> partition;
-	if (number_of_chunks <= MINIMUM_NUMBER_OF_CHUNKS_PER_THREAD || number_of_workers == 1) {
+	if (number_of_chunks <= minimum_chunks_per_task || number_of_workers == 1) {
 		partition = { { 0, number_of_chunks - 1 } };
 	} else {
 		std::size_t chunks_per_thread = number_of_chunks / number_of_workers;
-		if (!allow_small_task_sizes && chunks_per_thread < MINIMUM_NUMBER_OF_CHUNKS_PER_THREAD) {
+		if (!allow_small_task_sizes && chunks_per_thread < minimum_chunks_per_task) {
 			// dont schedule any task with less than these amount of chunks per task if you dont allow small task sizes
-			chunks_per_thread = MINIMUM_NUMBER_OF_CHUNKS_PER_THREAD;
+			chunks_per_thread = minimum_chunks_per_task;
 		}
 
 		std::size_t number_of_tasks = number_of_chunks / chunks_per_thread;
@@ -264,36 +777,48 @@ std::vector<std::pair<std::size_t, std::size_t>> Grid::get_partition_data_for_ch
 
 
 void Grid::update_neighbour_count_and_set_info_of_all_chunks() {
-	ZoneScoped;
+	ZoneScopedPhase;
+
+	std::vector<std::pair<std::size_t, std::size_t>> partition = get_partition_data_for_chunks(thread_pool->get_number_of_threads(), false);
+
+	// we keep the infos of previous iterations around, so that their vectors keep their capacity.
+	if (neighbour_update_infos_per_task.size() < partition.size()) {
+		neighbour_update_infos_per_task.resize(partition.size());
+	}
+	for (ChunkNeighbourUpdateInfos& infos: neighbour_update_infos_per_task) {
+		infos.clear();
+	}
 
+	thread_pool->run_tasks(partition.size(), [this, &partition](std::size_t task_index) {
+		update_neighbour_count_and_set_info_for_chunk_index_range(partition[task_index], neighbour_update_infos_per_task[task_index]);
+	});
+}
+
+void Grid::update_neighbour_count_and_set_info_for_chunk_index_range(std::pair<std::size_t, std::size_t> start_end_index_pair, ChunkNeighbourUpdateInfos& infos) {
+	ZoneScopedPhase;
+
+	for (std::size_t idx = start_end_index_pair.first; idx <= start_end_index_pair.second; idx++) {
+		chunks[idx].update_neighbour_count_inside();
+		set_chunk_neighbour_info(idx, infos);
+	}
+}
+
+void ChunkNeighbourUpdateInfos::clear() {
 	chunks_left_side_update_infos.clear();
-	chunks_left_side_update_infos.shrink_to_fit();
 	chunks_right_side_update_infos.clear();
-	chunks_right_side_update_infos.shrink_to_fit();
-	chunks_bottom_side_update_infos.clear();
-	chunks_bottom_side_update_infos.shrink_to_fit();
 	chunks_top_side_update_infos.clear();
-	chunks_top_side_update_infos.shrink_to_fit();
+	chunks_bottom_side_update_infos.clear();
 
 	top_left_corner_update_infos.clear();
-	top_left_corner_update_infos.shrink_to_fit();
 	top_right_corner_update_infos.clear();
-	top_right_corner_update_infos.shrink_to_fit();
 	bottom_left_corner_update_infos.clear();
-	bottom_left_corner_update_infos.shrink_to_fit();
 	bottom_right_corner_update_infos.clear();
-	bottom_right_corner_update_infos.shrink_to_fit();
 
 	coordinates_of_chunks_to_create.clear();
-
-	for (std::size_t idx = 0; idx < chunks.size(); idx++) {
-		chunks[idx].update_neighbour_count_inside();
-		set_chunk_neighbour_info(idx);
-	}
 }
 
-void Grid::set_chunk_neighbour_info(std::size_t chunk_id) {
-	ZoneScoped;
+void Grid::set_chunk_neighbour_info(std::size_t chunk_id, ChunkNeighbourUpdateInfos& infos) {
+	ZoneScopedChunk;
 	Chunk& chunk = chunks[chunk_id];
 	std::array<unsigned char, Chunk::rows*Chunk::columns>& cells_data = chunk.cells_data;
 
@@ -310,14 +835,14 @@ void Grid::set_chunk_neighbour_info(std::size_t chunk_id) {
 	if (has_to_update_top) {
 		const Coordinate& top_coord = Coordinate(chunk.grid_coordinate_row - 1, chunk.grid_coordinate_column);
 		if (!chunk_map.contains(top_coord)) {
-			coordinates_of_chunks_to_create.push_back(top_coord);
+			infos.coordinates_of_chunks_to_create.push_back(top_coord);
 		}
 		
 		ChunkSideUpdateInfo top_info;
 		top_info.chunk_to_update_coordinate = top_coord;
 		std::copy_n(std::begin(cells_data), Chunk::columns, std::begin(top_info.data));
 
-		chunks_bottom_side_update_infos.push_back(top_info);
+		infos.chunks_bottom_side_update_infos.push_back(top_info);
 	}
 
 	// bottom side of chunk, so top side of neighbour chunk
@@ -333,13 +858,13 @@ void Grid::set_chunk_neighbour_info(std::size_t chunk_id) {
 	if (has_to_update_bottom) {
 		const Coordinate& bottom_coord = Coordinate(chunk.grid_coordinate_row + 1, chunk.grid_coordinate_column);
 		if (!chunk_map.contains(bottom_coord)) {
-			coordinates_of_chunks_to_create.push_back(bottom_coord);
+			infos.coordinates_of_chunks_to_create.push_back(bottom_coord);
 		}
 		ChunkSideUpdateInfo bottom_info;
 		bottom_info.chunk_to_update_coordinate = bottom_coord;
 		std::copy_n(std::end(cells_data) - Chunk::columns , Chunk::columns, std::begin(bottom_info.data));
 
-		chunks_top_side_update_infos.push_back(bottom_info);
+		infos.chunks_top_side_update_infos.push_back(bottom_info);
 	}
 
 	// left side of chunk, so right side of neighbour chunk
@@ -355,12 +880,12 @@ void Grid::set_chunk_neighbour_info(std::size_t chunk_id) {
 	if (has_to_update_left) {
 		const Coordinate& left_coord = Coordinate(chunk.grid_coordinate_row, chunk.grid_coordinate_column - 1);
 		if (!chunk_map.contains(left_coord)) {
-			coordinates_of_chunks_to_create.push_back(left_coord);
+			infos.coordinates_of_chunks_to_create.push_back(left_coord);
 		}
 		ChunkSideUpdateInfo left_info;
 		left_info.chunk_to_update_coordinate = left_coord;
 		left_info.data = left_column;
-		chunks_right_side_update_infos.push_back(left_info);
+		infos.chunks_right_side_update_infos.push_back(left_info);
 	}
 
 	// right side of chunk, so left side of neighbour chunk
@@ -376,97 +901,106 @@ void Grid::set_chunk_neighbour_info(std::size_t chunk_id) {
 	if (has_to_update_right) {
 		const Coordinate& right_coord = Coordinate(chunk.grid_coordinate_row, chunk.grid_coordinate_column + 1);
 		if (!chunk_map.contains(right_coord)) {
-			coordinates_of_chunks_to_create.push_back(right_coord);
+			infos.coordinates_of_chunks_to_create.push_back(right_coord);
 		}
 		ChunkSideUpdateInfo right_info;
 		right_info.chunk_to_update_coordinate = right_coord;
 		right_info.data = right_column;
-		chunks_left_side_update_infos.push_back(right_info);
+		infos.chunks_left_side_update_infos.push_back(right_info);
 	}
 
 	//top left corner
 	if (cells_data[0]) {
 		const Coordinate& top_left_coord = Coordinate(chunk.grid_coordinate_row - 1, chunk.grid_coordinate_column - 1);
 		if (!chunk_map.contains(top_left_coord)) {
-			coordinates_of_chunks_to_create.push_back(top_left_coord);
+			infos.coordinates_of_chunks_to_create.push_back(top_left_coord);
 		}
-		bottom_right_corner_update_infos.push_back(top_left_coord);
+		infos.bottom_right_corner_update_infos.push_back(top_left_coord);
 	}
 	//top right corner
 	if (cells_data[Chunk::columns - 1]) {
 		const Coordinate& top_right_coord = Coordinate(chunk.grid_coordinate_row - 1, chunk.grid_coordinate_column + 1);
 		if (!chunk_map.contains(top_right_coord)) {
-			coordinates_of_chunks_to_create.push_back(top_right_coord);
+			infos.coordinates_of_chunks_to_create.push_back(top_right_coord);
 		}
 		
-		bottom_left_corner_update_infos.push_back(top_right_coord);
+		infos.bottom_left_corner_update_infos.push_back(top_right_coord);
 	}
 	//bottom right corner
 	if (cells_data[(Chunk::rows - 1) * Chunk::rows + Chunk::columns - 1]) {
 		const Coordinate& bottom_right_coord = Coordinate(chunk.grid_coordinate_row + 1, chunk.grid_coordinate_column + 1);
 		if (!chunk_map.contains(bottom_right_coord)) {
-			coordinates_of_chunks_to_create.push_back(bottom_right_coord);
+			infos.coordinates_of_chunks_to_create.push_back(bottom_right_coord);
 		}
 		
-		top_left_corner_update_infos.push_back(bottom_right_coord);
+		infos.top_left_corner_update_infos.push_back(bottom_right_coord);
 	}
 	//bottom left corner
 	if (cells_data[(Chunk::rows - 1) * Chunk::rows]) {
 		const Coordinate& bottom_left_coord = Coordinate(chunk.grid_coordinate_row + 1, chunk.grid_coordinate_column - 1);
 		if (!chunk_map.contains(bottom_left_coord)) {
-			coordinates_of_chunks_to_create.push_back(bottom_left_coord);
+			infos.coordinates_of_chunks_to_create.push_back(bottom_left_coord);
 		}
-		top_right_corner_update_infos.push_back(bottom_left_coord);
+		infos.top_right_corner_update_infos.push_back(bottom_left_coord);
 	}
 }
 
 void Grid::update_neighbours_of_all_chunks() {
-	ZoneScoped;
+	ZoneScopedPhase;
+
+	// this phase stays serial, the infos of different chunks can target the same neighbour chunk.
+	for (const ChunkNeighbourUpdateInfos& infos: neighbour_update_infos_per_task) {
+		update_neighbours_from_infos(infos);
+	}
+}
+
+void Grid::update_neighbours_from_infos(const ChunkNeighbourUpdateInfos& infos) {
+	ZoneScopedPhase;
 	
-	for (ChunkSideUpdateInfo& info: chunks_left_side_update_infos) {
+	for (const ChunkSideUpdateInfo& info: infos.chunks_left_side_update_infos) {
 		Coordinate chunk_coordinate = info.chunk_to_update_coordinate;
-		std::size_t chunk_index = chunk_map.find(chunk_coordinate)->second;
+		std::size_t chunk_index = chunk_map.find(chunk_coordinate);
 		Chunk& chunk = chunks[chunk_index];
 		chunk.update_neighbour_count_left_side(info.data);
 	}
-	for (ChunkSideUpdateInfo& info: chunks_right_side_update_infos) {
+	for (const ChunkSideUpdateInfo& info: infos.chunks_right_side_update_infos) {
 		Coordinate chunk_coordinate = info.chunk_to_update_coordinate;
-		std::size_t chunk_index = chunk_map.find(chunk_coordinate)->second;
+		std::size_t chunk_index = chunk_map.find(chunk_coordinate);
 		Chunk& chunk = chunks[chunk_index];
 		chunk.update_neighbour_count_right_side(info.data);
 	}
 
-	for (ChunkSideUpdateInfo& info: chunks_top_side_update_infos) {
+	for (const ChunkSideUpdateInfo& info: infos.chunks_top_side_update_infos) {
 		Coordinate chunk_coordinate = info.chunk_to_update_coordinate;
-		std::size_t chunk_index = chunk_map.find(chunk_coordinate)->second;
+		std::size_t chunk_index = chunk_map.find(chunk_coordinate);
 		Chunk& chunk = chunks[chunk_index];
 		chunk.update_neighbour_count_top_side(info.data);
 	}
-	for (ChunkSideUpdateInfo& info: chunks_bottom_side_update_infos) {
+	for (const ChunkSideUpdateInfo& info: infos.chunks_bottom_side_update_infos) {
 		Coordinate chunk_coordinate = info.chunk_to_update_coordinate;
-		std::size_t chunk_index = chunk_map.find(chunk_coordinate)->second;
+		std::size_t chunk_index = chunk_map.find(chunk_coordinate);
 		Chunk& chunk = chunks[chunk_index];
 		chunk.update_neighbour_count_bottom_side(info.data);
 	}
 	
-	for (Coordinate& chunk_coordinate: top_left_corner_update_infos) {
-		std::size_t chunk_index = chunk_map.find(chunk_coordinate)->second;
+	for (const Coordinate& chunk_coordinate: infos.top_left_corner_update_infos) {
+		std::size_t chunk_index = chunk_map.find(chunk_coordinate);
 		Chunk& chunk = chunks[chunk_index];
 		chunk.update_neighbour_count_top_left_corner();
 	}
 		
-	for (Coordinate& chunk_coordinate: top_right_corner_update_infos) {
-		std::size_t chunk_index = chunk_map.find(chunk_coordinate)->second;
+	for (const Coordinate& chunk_coordinate: infos.top_right_corner_update_infos) {
+		std::size_t chunk_index = chunk_map.find(chunk_coordinate);
 		Chunk& chunk = chunks[chunk_index];
 		chunk.update_neighbour_count_top_right_corner();
 	}
-	for (Coordinate& chunk_coordinate: bottom_left_corner_update_infos) {
-		std::size_t chunk_index = chunk_map.find(chunk_coordinate)->second;
+	for (const Coordinate& chunk_coordinate: infos.bottom_left_corner_update_infos) {
+		std::size_t chunk_index = chunk_map.find(chunk_coordinate);
 		Chunk& chunk = chunks[chunk_index];
 		chunk.update_neighbour_count_bottom_left_corner();
 	}
-	for (Coordinate& chunk_coordinate: bottom_right_corner_update_infos) {
-		std::size_t chunk_index = chunk_map.find(chunk_coordinate)->second;
+	for (const Coordinate& chunk_coordinate: infos.bottom_right_corner_update_infos) {
+		std::size_t chunk_index = chunk_map.find(chunk_coordinate);
 		Chunk& chunk = chunks[chunk_index];
 		chunk.update_neighbour_count_bottom_right_corner();
 	}
@@ -474,16 +1008,142 @@ void Grid::update_neighbours_of_all_chunks() {
 
 
 void Grid::update_cells_of_all_chunks() {
-	ZoneScoped;
+	ZoneScopedPhase;
+
+	std::vector<std::pair<std::size_t, std::size_t>> partition = get_partition_data_for_chunks(thread_pool->get_number_of_threads(), false);
+	generation_statistics_per_task.assign(partition.size(), {});
+
+	// each task reduces the counters of its chunks right after updating them, while they are still in the cache.
+	thread_pool->run_tasks(partition.size(), [this, &partition](std::size_t task_index) {
+		Grid_Generation_Statistics& task_statistics = generation_statistics_per_task[task_index];
+		for (std::size_t idx = partition[task_index].first; idx <= partition[task_index].second; idx++) {
+			copy_chunk_into_snapshot_capture(chunks[idx]);
+			chunks[idx].update_cells();
+			task_statistics.add_chunk(chunks[idx]);
+		}
+	});
+
+	generation_statistics = {};
+	for (const Grid_Generation_Statistics& task_statistics: generation_statistics_per_task) {
+		generation_statistics.add(task_statistics);
+	}
+}
+
+void Grid::update_row_bits_and_edge_flags_of_all_chunks(int number_of_generations) {
+	ZoneScopedPhase;
+
+	temporal_block_row_bits.resize(chunks.size());
+	temporal_block_edge_flags.resize(chunks.size());
+	const std::uint32_t left_columns_mask = (1u << number_of_generations) - 1;
+	const std::uint32_t right_columns_mask = left_columns_mask << (Chunk::columns - number_of_generations);
+	run_for_all_chunks_in_parallel([this, number_of_generations, left_columns_mask, right_columns_mask](std::size_t task_index, std::pair<std::size_t, std::size_t> start_end_index_pair) {
+		for (std::size_t idx = start_end_index_pair.first; idx <= start_end_index_pair.second; idx++) {
+			Chunk::Row_Bits& row_bits = temporal_block_row_bits[idx];
+			row_bits = chunks[idx].get_row_bits();
+			std::uint32_t top_rows = 0;
+			std::uint32_t bottom_rows = 0;
+			std::uint32_t all_rows = 0;
+			for (int r = 0; r < Chunk::rows; r++) {
+				top_rows |= r < number_of_generations ? row_bits[r] : 0;
+				bottom_rows |= r >= Chunk::rows - number_of_generations ? row_bits[r] : 0;
+				all_rows |= row_bits[r];
+			}
+			temporal_block_edge_flags[idx] = static_cast<std::uint8_t>((top_rows != 0 ? 1 : 0) | (bottom_rows != 0 ? 2 : 0)
+				| ((all_rows & left_columns_mask) != 0 ? 4 : 0) | ((all_rows & right_columns_mask) != 0 ? 8 : 0));
+		}
+	});
+}
+
+void Grid::create_needed_neighbours_for_temporal_block() {
+	ZoneScopedPhase;
+
+	// cells spread at most one cell per generation, so only a chunk with alive cells within the block size of an edge
+	// can bring a neighbour to life, which is what the edge flags record. The diagonal neighbours are created if the chunk has cells near both of
+	// their edges, which may create a few chunks too many, those get removed again at the end of the block.
+	std::size_t number_of_chunks_before = chunks.size();
+	for (std::size_t idx = 0; idx < number_of_chunks_before; idx++) {
+		std::uint8_t edge_flags = temporal_block_edge_flags[idx];
+		if (edge_flags == 0) {
+			continue;
+		}
+		Coordinate coord = Coordinate(chunks[idx].grid_coordinate_row, chunks[idx].grid_coordinate_column);
+		for (int row_offset = -1; row_offset <= 1; row_offset++) {
+			bool is_row_needed = row_offset == 0 || (edge_flags & (row_offset < 0 ? 1 : 2));
+			for (int column_offset = -1; column_offset <= 1; column_offset++) {
+				bool is_column_needed = column_offset == 0 || (edge_flags & (column_offset < 0 ? 4 : 8));
+				if ((row_offset == 0 && column_offset == 0) || !is_row_needed || !is_column_needed) {
+					continue;
+				}
+				Coordinate neighbour_coord = Coordinate(coord.x + row_offset, coord.y + column_offset);
+				if (!chunk_map.contains(neighbour_coord)) {
+					create_new_chunk(neighbour_coord);
+					temporal_block_row_bits.push_back({});
+				}
+			}
+		}
+	}
+}
+
+void Grid::advance_all_chunks_temporally_blocked(int number_of_generations) {
+	ZoneScopedPhase;
+
+	std::vector<std::pair<std::size_t, std::size_t>> partition = get_partition_data_for_chunks(thread_pool->get_number_of_threads(), false);
+	generation_statistics_per_task.assign(partition.size(), {});
+
+	// the tiles only read temporal_block_row_bits, so every chunk can take its new cells as soon as it is done.
+	thread_pool->run_tasks(partition.size(), [this, &partition, number_of_generations](std::size_t task_index) {
+		Grid_Generation_Statistics& task_statistics = generation_statistics_per_task[task_index];
+		for (std::size_t idx = partition[task_index].first; idx <= partition[task_index].second; idx++) {
+			Chunk& chunk = chunks[idx];
+			Temporal_Block_Neighbourhood neighbourhood;
+			for (int row_offset = -1; row_offset <= 1; row_offset++) {
+				for (int column_offset = -1; column_offset <= 1; column_offset++) {
+					std::size_t neighbour_index = chunk_map.find(Coordinate(chunk.grid_coordinate_row + row_offset, chunk.grid_coordinate_column + column_offset));
+					neighbourhood[(row_offset + 1) * 3 + column_offset + 1] = neighbour_index == Chunk_Directory::INVALID_CHUNK_INDEX ? nullptr : &temporal_block_row_bits[neighbour_index];
+				}
+			}
+			const Chunk::Row_Bits& old_row_bits = temporal_block_row_bits[idx];
+			Chunk::Row_Bits new_row_bits = advance_temporal_block(neighbourhood, number_of_generations);
+			copy_chunk_into_snapshot_capture(chunk);
+			chunk.set_cells_from_row_bits(new_row_bits);
+
+			chunk.population = 0;
+			chunk.number_of_births = 0;
+			chunk.number_of_deaths = 0;
+			chunk.row_occupancy_mask = 0;
+			chunk.column_occupancy_mask = 0;
+			for (int r = 0; r < Chunk::rows; r++) {
+				chunk.population += _mm_popcnt_u32(new_row_bits[r]);
+				chunk.number_of_births += _mm_popcnt_u32(new_row_bits[r] & ~old_row_bits[r]);
+				chunk.number_of_deaths += _mm_popcnt_u32(old_row_bits[r] & ~new_row_bits[r]);
+				chunk.row_occupancy_mask |= static_cast<std::uint32_t>(new_row_bits[r] != 0) << r;
+				chunk.column_occupancy_mask |= new_row_bits[r];
+			}
+			task_statistics.add_chunk(chunk);
+		}
+	});
 
-	for(std::size_t idx = 0; idx < chunks.size(); idx++) {
-		chunks[idx].update_cells();
+	generation_statistics = {};
+	for (const Grid_Generation_Statistics& task_statistics: generation_statistics_per_task) {
+		generation_statistics.add(task_statistics);
 	}
 }
 
+void Grid_Generation_Statistics::add_chunk(const Chunk& chunk) {
+	population += chunk.population;
+	number_of_births += chunk.number_of_births;
+	number_of_deaths += chunk.number_of_deaths;
+}
+
+void Grid_Generation_Statistics::add(const Grid_Generation_Statistics& other) {
+	population += other.population;
+	number_of_births += other.number_of_births;
+	number_of_deaths += other.number_of_deaths;
+}
+
 
 void Grid::remove_empty_chunks() {
-	ZoneScoped;
+	ZoneScopedPhase;
 
 	std::vector<int> indices_of_chunks_to_remove;
 	for (int idx = 0; idx < chunks.size(); ++idx) {
@@ -493,10 +1153,12 @@ void Grid::remove_empty_chunks() {
 		}
 	}
 	std::size_t number_of_indices_to_remove = indices_of_chunks_to_remove.size();
+	number_of_chunk_changes_since_last_sort += number_of_indices_to_remove;
 	if (number_of_indices_to_remove > 0) {
 		if (number_of_indices_to_remove == chunks.size()) {
 			chunks.clear();
-			chunk_map = {};
+			chunk_map.clear();
+			chunk_extent_index.clear();
 		} else {
 
 			for (int i = static_cast < int > (indices_of_chunks_to_remove.size()) - 1; i >= 0; i--) {
@@ -506,25 +1168,89 @@ void Grid::remove_empty_chunks() {
 				// check if its at the last position
 				if (idx == idx_of_last_element) {
 					assert(chunks.size() > 0);
-					Chunk& chunk = chunks.back();
-					chunks.pop_back();
+					const Chunk& chunk = chunks.back();
 					// update chunk map as well.
 					chunk_map.erase(Coordinate(chunk.grid_coordinate_row, chunk.grid_coordinate_column));
+					chunk_extent_index.erase(Coordinate(chunk.grid_coordinate_row, chunk.grid_coordinate_column));
+					chunks.pop_back();
 				} else {
 					// if its not at the last position, move the last elem to that position and update the chunk map.
 					const Chunk& chunk_to_remove = chunks[idx];
 					chunk_map.erase(Coordinate(chunk_to_remove.grid_coordinate_row, chunk_to_remove.grid_coordinate_column));
+					chunk_extent_index.erase(Coordinate(chunk_to_remove.grid_coordinate_row, chunk_to_remove.grid_coordinate_column));
 
 					assert(chunks.size() > 0);
 					const Chunk& last_chunk = chunks.back();
-					chunks.pop_back();
 					Coordinate last_chunk_coordinate = Coordinate(last_chunk.grid_coordinate_row, last_chunk.grid_coordinate_column);
 					chunk_map.erase(last_chunk_coordinate);
 
-					chunks[idx] = last_chunk;
-					chunk_map.insert(std::make_pair(last_chunk_coordinate, idx));
+					chunks[idx] = std::move(chunks.back());
+					chunks.pop_back();
+					chunk_map.insert(last_chunk_coordinate, idx);
 				}
 			}
 		}
 	}
+}
+
+void Grid::sort_chunks_by_morton_key_if_needed() {
+	ZoneScopedPhase;
+
+	// New chunks get appended at the end and removed chunks get replaced by the last chunk, so every change moves a
+	// chunk away from its spatial neighbours in memory. Sorting is a full pass over all chunks, so we only do it once
+	// enough chunks changed since the last sort, which amortizes the cost over many iterations.
+	constexpr static std::size_t CHUNK_CHANGES_PER_SORT_DIVISOR = 2;
+
+	if (number_of_chunk_changes_since_last_sort > chunks.size() / CHUNK_CHANGES_PER_SORT_DIVISOR) {
+		sort_chunks_by_morton_key();
+	}
+}
+
+void Grid::sort_chunks_by_morton_key() {
+	ZoneScopedPhase;
+
+	number_of_chunk_changes_since_last_sort = 0;
+
+	// sort (key, index) pairs instead of the chunks themselves, chunks are big so we want to move each of them only once.
+	std::vector<std::pair<std::uint64_t, std::size_t>> morton_key_index_pairs;
+	morton_key_index_pairs.reserve(chunks.size());
+	for (std::size_t idx = 0; idx < chunks.size(); idx++) {
+		const Chunk& chunk = chunks[idx];
+		Coordinate chunk_coordinate = Coordinate(chunk.grid_coordinate_row, chunk.grid_coordinate_column);
+		morton_key_index_pairs.push_back(std::make_pair(chunk_coordinate.morton_key(), idx));
+	}
+
+	bool is_already_sorted = std::is_sorted(morton_key_index_pairs.begin(), morton_key_index_pairs.end());
+	if (is_already_sorted) {
+		return;
+	}
+	std::sort(morton_key_index_pairs.begin(), morton_key_index_pairs.end());
+
+	// apply the permutation in place, cycle by cycle. Allocating a second chunk vector instead is a lot slower for big
+	// grids, since the fresh memory has to be faulted in on every sort.
+	std::vector<bool> is_at_sorted_position(chunks.size(), false);
+	for (std::size_t cycle_start = 0; cycle_start < chunks.size(); cycle_start++) {
+		if (is_at_sorted_position[cycle_start]) {
+			continue;
+		}
+		std::size_t idx = cycle_start;
+		std::size_t source_idx = morton_key_index_pairs[idx].second;
+		if (source_idx != cycle_start) {
+			Chunk cycle_start_chunk = std::move(chunks[cycle_start]);
+			while (source_idx != cycle_start) {
+				chunks[idx] = std::move(chunks[source_idx]);
+				is_at_sorted_position[idx] = true;
+				idx = source_idx;
+				source_idx = morton_key_index_pairs[idx].second;
+			}
+			chunks[idx] = std::move(cycle_start_chunk);
+		}
+		is_at_sorted_position[idx] = true;
+	}
+
+	chunk_map.clear();
+	for (std::size_t idx = 0; idx < chunks.size(); idx++) {
+		const Chunk& chunk = chunks[idx];
+		chunk_map.insert(Coordinate(chunk.grid_coordinate_row, chunk.grid_coordinate_column), idx);
+	}
 }
\ No newline at end of file
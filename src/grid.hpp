@@ -1,27 +1,151 @@
 #pragma once
 
-#include <tracy/Tracy.hpp>
+#include "profiling.hpp"
 
 #include "omp.h"
-#include "ui_state.hpp"
+#include "grid_info.hpp"
 #include "opencl_context.hpp"
 #include "chunk.hpp"
+#include "chunk_directory.hpp"
+#include "chunk_extent_index.hpp"
+#include "thread_pool.hpp"
+#include "checkpoint.hpp"
+#include "history.hpp"
+#include "temporal_blocking.hpp"
 
 #include "coordinate.hpp"
 
 #include <execution>
+#include <algorithm>
+#include <memory>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <thread>
+#include <chrono>
+
+
+//--------------------------------------------------------------------------------
+// Everything a range of chunks has to tell its neighbours after computing its inside neighbour counts. Each task of
+// update_neighbour_count_and_set_info_of_all_chunks() fills its own instance, so the tasks do not share any state.
+struct ChunkNeighbourUpdateInfos {
+	void clear();
+
+	std::vector<ChunkSideUpdateInfo> chunks_left_side_update_infos;
+	std::vector<ChunkSideUpdateInfo> chunks_right_side_update_infos;
+	std::vector<ChunkSideUpdateInfo> chunks_top_side_update_infos;
+	std::vector<ChunkSideUpdateInfo> chunks_bottom_side_update_infos;
+
+	std::vector<Coordinate> top_left_corner_update_infos;
+	std::vector<Coordinate> top_right_corner_update_infos;
+	std::vector<Coordinate> bottom_left_corner_update_infos;
+	std::vector<Coordinate> bottom_right_corner_update_infos;
+
+	std::vector<Coordinate> coordinates_of_chunks_to_create;
+};
+
+
+//--------------------------------------------------------------------------------
+// Wall clock seconds spent in the phases of the last next_iteration() call. With temporal blocking the extraction of
+// the row bits counts as update_neighbour_count_and_set_info and advancing the tiles as update_cells.
+struct Grid_Phase_Timings {
+	double total() const;
+
+	double update_neighbour_count_and_set_info = 0.0;
+	double create_needed_chunks = 0.0;
+	double update_neighbours = 0.0;
+	double update_cells = 0.0;
+	double remove_empty_chunks = 0.0;
+	double sort_chunks = 0.0;
+	double update_coordinates_of_alive_cells = 0.0;
+};
+
+
+//--------------------------------------------------------------------------------
+// The smallest box of cells containing all alive cells, inclusive on every side.
+struct Grid_Bounding_Box {
+	bool is_empty = true;
+	int min_row = 0;
+	int min_column = 0;
+	int max_row = 0;
+	int max_column = 0;
+};
+
+// Metrics of a generation, reduced from the per chunk counters of Chunk::update_cells(), so they cost no extra pass
+// over the cells.
+struct Grid_Generation_Statistics {
+	void add_chunk(const Chunk& chunk);
+
+	void add(const Grid_Generation_Statistics& other);
+
+	std::uint64_t population = 0;
+	std::uint64_t number_of_births = 0;
+	std::uint64_t number_of_deaths = 0;
+	Grid_Bounding_Box bounding_box;
+};
 
 
 //--------------------------------------------------------------------------------
 class Grid {
 public:
-	Grid(std::shared_ptr<OpenCLContext> context);
+	Grid(std::shared_ptr<OpenCLContext> context, bool should_create_default_pattern = true);
+
+	// completes the open snapshot capture, see begin_snapshot_capture().
+	~Grid();
+
+	void create_default_pattern();
+
+	void create_random_soup(int size, float density, std::uint32_t seed);
+
+	void set_cell_alive(int row, int column);
+
+	// sets number_of_cells cells starting at (row, first_column) alive, one memset per touched chunk. The importers
+	// decode pattern runs with this, so they never have to touch single cells.
+	void set_alive_cell_run(int row, int first_column, int number_of_cells);
+
+	// call after placing the cells of a new pattern, sorts the chunks, extracts the render coordinates and counts the
+	// population.
+	void finish_pattern_creation();
+
+	// sets generation_statistics from the cells, without any births or deaths. next_iteration() keeps them up to date.
+	void recount_generation_statistics();
+
+	// the tight bounds of the occupancy masks of the chunks on the border of chunk_extent_index. Only looks at those
+	// chunks, so it is cheap enough to call every generation.
+	Grid_Bounding_Box get_bounding_box() const;
+
+	void set_number_of_threads(unsigned int number_of_threads);
+
+	std::size_t count_alive_cells() const;
+
+	// returns the (row, column) world coordinates of all alive cells, sorted.
+	std::vector<std::pair<int, int>> get_alive_cells() const;
+
+	// order independent hash over all alive cells, see checksum.hpp. Equal states give equal checksums, no matter how
+	// the cells are distributed over chunks or in which order the chunks are stored.
+	std::uint64_t compute_checksum() const;
+
+	// Starts a copy-on-write capture of the current cells: fills the directory of capture and marks every chunk, but
+	// does not copy any cells yet. The next generation copies each marked chunk right before it overwrites its cells
+	// and completes the capture, any other change of the cells completes it first. O(number of chunks) with a few bytes
+	// per chunk, the copy itself is spread over the update tasks. An open capture gets completed first.
+	void begin_snapshot_capture(std::shared_ptr<Grid_Snapshot_Capture> capture);
+
+	// copies the chunks the open capture still waits for and completes it, does nothing if there is none.
+	void finish_snapshot_capture();
+
+	// call before the cells of chunk change, copies them into the open capture if it still waits for them.
+	void copy_chunk_into_snapshot_capture(Chunk& chunk);
 
 	void create_new_chunk_and_set_alive_cells(const Coordinate& coord, const std::vector<std::pair<int, int>>& coordinates);
 
 	void update_cells_of_all_chunks();
 
-	void update_neighbour_count_inside_for_chunk_index_range(std::pair<std::size_t, std::size_t> start_end_index_pair);
+	void update_neighbour_count_and_set_info_for_chunk_index_range(std::pair<std::size_t, std::size_t> start_end_index_pair, ChunkNeighbourUpdateInfos& infos);
+
+	void update_neighbours_from_infos(const ChunkNeighbourUpdateInfos& infos);
+
+	void run_for_all_chunks_in_parallel(const std::function<void(std::size_t, std::pair<std::size_t, std::size_t>)>& function);
 
 	void update_coordinates_of_alive_cells_for_all_chunks();
 
@@ -33,13 +157,25 @@ public:
 
 	void update_neighbour_count_and_set_info_of_all_chunks();
 
+	// advances temporal_block_size generations.
 	void next_iteration();
+
+	// the temporally blocked part of next_iteration(), see temporal_blocking.hpp.
+	void update_row_bits_and_edge_flags_of_all_chunks(int number_of_generations);
+
+	void create_needed_neighbours_for_temporal_block();
+
+	void advance_all_chunks_temporally_blocked(int number_of_generations);
 	
 	void update_neighbours_of_all_chunks();
 
 	void create_needed_neighbours_of_all_chunks();
 
-	void set_chunk_neighbour_info(std::size_t chunk_id);
+	void set_chunk_neighbour_info(std::size_t chunk_id, ChunkNeighbourUpdateInfos& infos);
+
+	void sort_chunks_by_morton_key();
+
+	void sort_chunks_by_morton_key_if_needed();
 
 	std::vector < std::pair<std::size_t, std::size_t> > get_partition_data_for_chunks(unsigned int number_of_workers, bool allow_small_task_sizes);
 	//--------------------------------------------------------------------------------
@@ -48,22 +184,50 @@ public:
 
 	std::size_t number_of_chunks;
 
-	boost::unordered_flat_map<Coordinate, std::size_t> chunk_map;
+	// number of chunks which got created or removed since the last time we sorted the chunks along the Z-order curve.
+	// The chunks get sorted again once this exceeds a fraction of all chunks, see sort_chunks_by_morton_key_if_needed().
+	std::size_t number_of_chunk_changes_since_last_sort;
+
+	Chunk_Directory chunk_map;
 	std::vector<Chunk> chunks;
 
-	std::vector<ChunkSideUpdateInfo> chunks_left_side_update_infos;
-	std::vector<ChunkSideUpdateInfo> chunks_right_side_update_infos;
-	std::vector<ChunkSideUpdateInfo> chunks_top_side_update_infos;
-	std::vector<ChunkSideUpdateInfo> chunks_bottom_side_update_infos;
+	// gets updated along with chunk_map whenever a chunk is created or removed.
+	Chunk_Extent_Index chunk_extent_index;
 
-	std::vector<Coordinate> top_left_corner_update_infos;
-	std::vector<Coordinate> top_right_corner_update_infos;
-	std::vector<Coordinate> bottom_left_corner_update_infos;
-	std::vector<Coordinate> bottom_right_corner_update_infos;
-	
-	std::vector<Coordinate> coordinates_of_chunks_to_create;
+	// one entry per task of the current chunk partition, see update_neighbour_count_and_set_info_of_all_chunks().
+	std::vector<ChunkNeighbourUpdateInfos> neighbour_update_infos_per_task;
+
+	// the chunks get split into tasks of at least this many chunks, smaller grids run on a single thread. The
+	// verification harness lowers it to exercise the parallel code paths on small grids.
+	std::size_t minimum_number_of_chunks_per_task;
+
+	// number of generations per next_iteration() call. 1 exchanges the chunk borders every generation, larger values
+	// (up to MAXIMUM_TEMPORAL_BLOCK_SIZE) advance every chunk that many generations at once on a tile with a halo from
+	// its neighbours. The births and deaths of generation_statistics then count over the whole block.
+	int temporal_block_size;
+
+	// the cells of every chunk at the start of a temporal block, the tiles get built from these so the chunks can be
+	// overwritten with their new cells right away. Bit 0 to 3 of the edge flags are set if the top, bottom, left or
+	// right temporal_block_size rows or columns of the chunk have alive cells.
+	std::vector<Chunk::Row_Bits> temporal_block_row_bits;
+	std::vector<std::uint8_t> temporal_block_edge_flags;
+
+	// the per chunk render coordinates are only needed if somebody draws the grid, the headless runner turns them off.
+	bool should_update_coordinates_of_alive_cells;
+
+	std::unique_ptr<Thread_Pool> thread_pool;
+
+	Grid_Phase_Timings phase_timings;
+
+	Grid_Generation_Statistics generation_statistics;
+	// one entry per task of update_cells_of_all_chunks(), reduced into generation_statistics.
+	std::vector<Grid_Generation_Statistics> generation_statistics_per_task;
 
 	std::shared_ptr<OpenCLContext> opencl_context;
+
+	// the capture which still waits for the cells of the marked chunks, empty if there is none. Shared with the
+	// checkpointer, which writes it once it is complete.
+	std::shared_ptr<Grid_Snapshot_Capture> snapshot_capture;
 };
 
 
@@ -71,15 +235,22 @@ public:
 struct Grid_Execution_State {
 	bool use_opencl_kernel = false;
 	int number_of_iterations_per_single_frame = 1;
-	bool updated_grid_coordinates = false;
-	bool updated_border_coordinates = false;
 	bool is_running = false;
 	bool run_manual_next_iteration = false;
 	float time_since_last_iteration = 0.0f;
 	float grid_speed = 1.0f;
 	bool show_chunk_borders = false;
-	bool have_to_update_chunk_borders = false;
 	bool should_run_at_max_possible_speed = true;
+	// set until the next update() if the grid got reset or replaced by a generation from the history.
+	bool grid_got_replaced = false;
+	bool should_record_history = false;
+	// adaptive stepping, see Grid_Manager::run_iterations_within_time_budget().
+	bool should_use_time_budget = false;
+	double time_budget_seconds = 0.016;
+	double estimated_seconds_per_iteration = 0.0;
+	int number_of_iterations_per_time_budget = 1;
+	// generations per iteration, applied to every grid the manager runs, see Grid::temporal_block_size.
+	int temporal_block_size = 1;
 };
 
 //--------------------------------------------------------------------------------
@@ -87,11 +258,23 @@ class Grid_Manager {
 public:
 	Grid_Manager();
 
-	void update(double dt, const Grid_UI_Controls_Info& grid_ui_controls_info);
+	// runs the generations which are due after dt seconds. Returns true if the grid changed, see Grid_Simulation_Thread.
+	bool update(double dt);
 
+	// applies the controls of the user interface, called once for every command of the queue.
 	void update_grid_execution_state(const Grid_UI_Controls_Info& ui_info);
 
-	void create_new_grid();
+	void create_new_grid(const std::string& pattern_path = "");
+
+	// runs a single iteration of temporal_block_size generations and records it in the history if that is enabled.
+	void run_next_iteration();
+
+	// runs as many generations as the estimated cost per generation lets fit into the time budget and updates the
+	// estimate with the measured time.
+	void run_iterations_within_time_budget();
+
+	// replaces the grid with the latest recorded generation at or before iteration and stops the simulation.
+	void seek_grid_history(std::size_t iteration);
 	
 	void update_grid_info();
 
@@ -99,5 +282,10 @@ public:
 	std::unique_ptr<Grid> grid;
 	Grid_Execution_State grid_execution_state;
 
+	Grid_Checkpoint_Settings checkpoint_settings;
+	std::unique_ptr<Grid_Checkpointer> checkpointer;
+
+	std::unique_ptr<Grid_History> history;
+
 	std::shared_ptr<OpenCLContext> opencl_context;
 };
\ No newline at end of file
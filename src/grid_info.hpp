@@ -0,0 +1,131 @@
+#pragma once
+
+#include <array>
+#include <string>
+
+//--------------------------------------------------------------------------------
+// Plain data shared between the grid and the user interface. Kept free of any GLFW/ImGui includes, so that the grid
+// code builds without the rendering dependencies (see the headless runner).
+enum Grid_UI_Control_Button_Events {
+	GRID_NO_BUTTON_PRESSED,
+	GRID_RESET_BUTTON_PRESSED,
+	GRID_NEXT_ITERATION_BUTTON_PRESSED,
+	GRID_START_STOP_BUTTON_PRESSED,
+	GRID_STEP_BACK_BUTTON_PRESSED,
+	GRID_SEEK_BUTTON_PRESSED
+};
+
+struct Grid_UI_Controls_Info {
+	bool m_show_demo_window = false;
+	bool m_show_grid_info = true;
+
+	Grid_UI_Control_Button_Events button_type = GRID_NO_BUTTON_PRESSED;
+	float min_grid_speed_slider_value = 1.0f;
+	float max_grid_speed_slider_value = 100.0f;
+	float grid_speed_slider_value = max_grid_speed_slider_value;
+
+	bool show_chunk_borders = false;
+	bool run_grid_at_max_possible_speed = true;
+	// render side only: the vertex shader expands the packed chunk bitmaps instead of the CPU writing a translation per
+	// alive cell, see Chunk_Bitmap_Buffer.
+	bool should_expand_cells_on_gpu = false;
+	// render side only: chunks whose cells would get smaller than this on screen are drawn as density quads.
+	bool should_use_level_of_detail = true;
+	float min_level_of_detail_pixels_per_cell = 0.25f;
+	float max_level_of_detail_pixels_per_cell = 8.0f;
+	float level_of_detail_pixels_per_cell = 1.0f;
+
+	int min_number_of_grid_iterations_per_single_frame = 1;
+	int max_number_of_grid_iterations_per_single_frame = 10000;
+	int number_of_grid_iterations_per_single_frame = 1;
+
+	// generations per iteration, see Grid::temporal_block_size. The maximum is MAXIMUM_TEMPORAL_BLOCK_SIZE.
+	int min_temporal_block_size = 1;
+	int max_temporal_block_size = 16;
+	int temporal_block_size = 1;
+
+	// adaptive stepping, runs as many iterations per update as fit into the time budget instead of a fixed number.
+	bool should_use_time_budget = false;
+	float min_time_budget_ms = 1.0f;
+	float max_time_budget_ms = 100.0f;
+	float time_budget_ms = 16.0f;
+
+	// pattern file (RLE, plaintext, Life 1.06, macrocell or snapshot) which gets loaded on reset, the default pattern if empty.
+	std::array<char, 512> pattern_path = {};
+
+	// periodic background checkpoints, see Grid_Checkpointer.
+	bool should_write_checkpoints = false;
+	int checkpoint_interval = 10000;
+	int checkpoint_retention = 3;
+	// bound of the memory of the checkpoint captures, 0 for no bound.
+	int checkpoint_memory_mb = 0;
+	// directory of the checkpoint files, the working directory if empty.
+	std::array<char, 512> checkpoint_directory = {};
+
+	// generation history for stepping back and seeking, see Grid_History.
+	bool should_record_history = false;
+	int history_keyframe_interval = 64;
+	int history_memory_budget_mb = 256;
+	int history_seek_iteration = 0;
+};
+
+//--------------------------------------------------------------------------------
+struct Grid_Info {
+	int number_of_chunks = 0;
+	int iteration = 0;
+	// measured on the simulation thread, independent of the frame rate.
+	double simulation_generations_per_second = 0.0;
+	// of the adaptive stepping, only valid if is_using_time_budget is set.
+	bool is_using_time_budget = false;
+	int iterations_per_time_budget = 0;
+	double estimated_ms_per_iteration = 0.0;
+	// of the last generation, see Grid_Generation_Statistics.
+	long long population = 0;
+	long long number_of_births = 0;
+	long long number_of_deaths = 0;
+	// inclusive bounds of the alive cells, only valid if has_bounding_box is set.
+	bool has_bounding_box = false;
+	int bounding_box_min_row = 0;
+	int bounding_box_min_column = 0;
+	int bounding_box_max_row = 0;
+	int bounding_box_max_column = 0;
+	// error of the last pattern file load, empty if it succeeded.
+	std::string pattern_load_error;
+
+	int checkpoint_interval = 0;
+	int checkpoint_retention = 0;
+	int number_of_checkpoints = 0;
+	int last_checkpoint_iteration = 0;
+	double last_checkpoint_capture_ms = 0.0;
+	double last_checkpoint_latency_ms = 0.0;
+	bool is_checkpoint_being_written = false;
+	// error of the last failed checkpoint, empty if the last one succeeded.
+	std::string checkpoint_error;
+
+	int history_first_iteration = 0;
+	int history_last_iteration = 0;
+	int history_number_of_frames = 0;
+	int history_number_of_keyframes = 0;
+	double history_memory_mb = 0.0;
+	// bytes of the recorded generations as chunk cells divided by the bytes of the history.
+	double history_compression_ratio = 0.0;
+	// error of the last seek, empty if it succeeded.
+	std::string history_error;
+};
+
+//--------------------------------------------------------------------------------
+// What the renderer did with the last snapshot, filled in by the Cube_System on the render thread.
+struct Render_Info {
+	// chunks outside the view frustum are neither extracted nor uploaded nor drawn.
+	long long number_of_chunks = 0;
+	long long number_of_visible_chunks = 0;
+	long long number_of_cube_cells = 0;
+	// visible chunks whose cells would be too small on screen, drawn as density quads of the population pyramid.
+	long long number_of_level_of_detail_chunks = 0;
+	long long number_of_level_of_detail_quads = 0;
+	// of the last update, the chunk slots only upload the visible chunks which changed, one upload per run of adjacent
+	// slots.
+	long long number_of_uploaded_chunks = 0;
+	long long number_of_uploads = 0;
+	bool is_expanding_cells_on_gpu = false;
+};
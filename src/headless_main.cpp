@@ -0,0 +1,361 @@
+#include "profiling.hpp"
+
+//--------------------------------------------------------------------------------
+// Runs the simulation without creating a window or an OpenGL context, eg for batch jobs on compute nodes. Loads a
+// pattern, runs a given number of generations as fast as possible and prints throughput, population and chunk counts.
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+#include <algorithm>
+
+#include "grid.hpp"
+#include "patterns.hpp"
+#include "pattern_io.hpp"
+#include "macrocell.hpp"
+#include "snapshot.hpp"
+#include "checkpoint.hpp"
+#include "history.hpp"
+#include "statistics.hpp"
+
+int main(int argc, char** argv);
+
+//--------------------------------------------------------------------------------
+struct Headless_Options {
+	std::size_t number_of_generations = 1000;
+	unsigned int number_of_threads = std::thread::hardware_concurrency();
+	// generations per Grid::next_iteration() call, see Grid::temporal_block_size.
+	int temporal_block_size = 1;
+	// "default" is the seed of the application, "soup" a random square soup, everything else a built in pattern.
+	std::string pattern = "default";
+	// RLE, plaintext, Life 1.06, macrocell or snapshot file, replaces the pattern if set.
+	std::string pattern_path = "";
+	// the final state gets written to this macrocell file if set.
+	std::string save_macrocell_path = "";
+	// the final state gets written to this snapshot file if set, load it again with --pattern-file to continue the run.
+	std::string save_snapshot_path = "";
+	// periodic background checkpoints, disabled if the interval is 0.
+	Grid_Checkpoint_Settings checkpoint_settings;
+	// records every generation into a Grid_History with this keyframe interval if not 0.
+	std::size_t history_keyframe_interval = 0;
+	std::size_t history_memory_budget_mb = 1024;
+	// restores this generation from the history after the run, to check it against a direct run to it.
+	long long seek_iteration = -1;
+	// writes a binary record per generation to this file if set, and converts it to CSV afterwards if that is set.
+	std::string statistics_log_path = "";
+	std::string statistics_csv_path = "";
+	int soup_size = 1024;
+	float soup_density = 0.5f;
+	std::uint32_t seed = 1;
+	// print an intermediate report every report_interval generations, 0 only prints the final report.
+	std::size_t report_interval = 0;
+};
+
+void print_usage();
+bool parse_options(int argc, char** argv, Headless_Options& options);
+void print_report(const Grid& grid, std::size_t number_of_generations, double seconds, double number_of_simulated_cells);
+void print_bounding_box(const Grid_Bounding_Box& bounding_box);
+
+//--------------------------------------------------------------------------------
+void print_usage() {
+	std::cout << "Usage: grid_of_life_headless [options]\n"
+		<< "  --generations N      number of generations to run (default 1000)\n"
+		<< "  --threads N          number of simulation threads (default: number of hardware threads)\n"
+		<< "  --pattern NAME       default, soup or a built in pattern like r-pentomino (default: default)\n"
+		<< "  --pattern-file PATH  load an RLE, plaintext (.cells), Life 1.06 or macrocell (.mc) pattern file or a snapshot instead\n"
+		<< "  --temporal-block K   advance K generations per step (1 to " << MAXIMUM_TEMPORAL_BLOCK_SIZE << ", default 1), the checkpoints,\n"
+		<< "                       the history and the statistics log then only see every K-th generation\n"
+		<< "  --save-macrocell PATH  write the final generation to a macrocell (.mc) file\n"
+		<< "  --save-snapshot PATH   write the final state to a binary snapshot, --pattern-file continues from it\n"
+		<< "  --checkpoint-every N   write a snapshot every N generations in the background\n"
+		<< "  --checkpoint-retention N  number of checkpoints to keep (default 3)\n"
+		<< "  --checkpoint-directory DIR  directory of the checkpoints (default: working directory)\n"
+		<< "  --checkpoint-memory-mb N  memory of the checkpoint captures, about 1 KB per chunk (default 0, no bound)\n"
+		<< "  --history-keyframes K  record the generation history with a keyframe every K generations\n"
+		<< "  --history-budget-mb N  memory budget of the history (default 1024)\n"
+		<< "  --seek N               restore generation N from the history after the run and report it\n"
+		<< "  --statistics-log PATH  write population, births, deaths, chunks and bounding box of every generation to a binary log\n"
+		<< "  --statistics-csv PATH  convert the statistics log to CSV after the run\n"
+		<< "  --soup-size N        side length of the random soup in cells (default 1024)\n"
+		<< "  --soup-density D     probability of a soup cell being alive (default 0.5)\n"
+		<< "  --seed N             seed of the random soup (default 1)\n"
+		<< "  --report-every N     print an intermediate report every N generations\n";
+}
+
+bool parse_options(int argc, char** argv, Headless_Options& options) {
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		if (argument == "--help" || argument == "-h") {
+			return false;
+		}
+		if (i + 1 >= argc) {
+			std::cout << "Missing value for option " << argument << std::endl;
+			return false;
+		}
+		std::string value = argv[++i];
+		if (argument == "--generations") {
+			options.number_of_generations = std::strtoull(value.c_str(), nullptr, 10);
+		} else if (argument == "--threads") {
+			options.number_of_threads = static_cast<unsigned int>(std::strtoul(value.c_str(), nullptr, 10));
+		} else if (argument == "--temporal-block") {
+			options.temporal_block_size = std::clamp(std::atoi(value.c_str()), 1, MAXIMUM_TEMPORAL_BLOCK_SIZE);
+		} else if (argument == "--pattern") {
+			options.pattern = value;
+		} else if (argument == "--pattern-file") {
+			options.pattern_path = value;
+		} else if (argument == "--save-macrocell") {
+			options.save_macrocell_path = value;
+		} else if (argument == "--save-snapshot") {
+			options.save_snapshot_path = value;
+		} else if (argument == "--checkpoint-every") {
+			options.checkpoint_settings.interval = std::strtoull(value.c_str(), nullptr, 10);
+		} else if (argument == "--checkpoint-retention") {
+			options.checkpoint_settings.retention = std::strtoull(value.c_str(), nullptr, 10);
+		} else if (argument == "--checkpoint-directory") {
+			options.checkpoint_settings.directory = value;
+		} else if (argument == "--checkpoint-memory-mb") {
+			options.checkpoint_settings.maximum_capture_memory_mb = std::strtoull(value.c_str(), nullptr, 10);
+		} else if (argument == "--history-keyframes") {
+			options.history_keyframe_interval = std::strtoull(value.c_str(), nullptr, 10);
+		} else if (argument == "--history-budget-mb") {
+			options.history_memory_budget_mb = std::strtoull(value.c_str(), nullptr, 10);
+		} else if (argument == "--seek") {
+			options.seek_iteration = std::atoll(value.c_str());
+		} else if (argument == "--statistics-log") {
+			options.statistics_log_path = value;
+		} else if (argument == "--statistics-csv") {
+			options.statistics_csv_path = value;
+		} else if (argument == "--soup-size") {
+			options.soup_size = std::atoi(value.c_str());
+		} else if (argument == "--soup-density") {
+			options.soup_density = static_cast<float>(std::atof(value.c_str()));
+		} else if (argument == "--seed") {
+			options.seed = static_cast<std::uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+		} else if (argument == "--report-every") {
+			options.report_interval = std::strtoull(value.c_str(), nullptr, 10);
+		} else {
+			std::cout << "Unknown option " << argument << std::endl;
+			return false;
+		}
+	}
+	if (!options.statistics_csv_path.empty() && options.statistics_log_path.empty()) {
+		std::cout << "--statistics-csv needs --statistics-log" << std::endl;
+		return false;
+	}
+	if (options.pattern != "default" && options.pattern != "soup" && get_pattern_cells(options.pattern).empty()) {
+		std::cout << "Unknown pattern " << options.pattern << std::endl;
+		return false;
+	}
+	return true;
+}
+
+//--------------------------------------------------------------------------------
+void print_report(const Grid& grid, std::size_t number_of_generations, double seconds, double number_of_simulated_cells) {
+	ZoneScopedFrame;
+
+	double generations_per_second = seconds > 0.0 ? number_of_generations / seconds : 0.0;
+	double cells_per_second = seconds > 0.0 ? number_of_simulated_cells / seconds : 0.0;
+
+	std::cout << "generation " << grid.iteration
+		<< " | " << std::fixed << std::setprecision(3) << seconds << " s"
+		<< " | " << std::setprecision(1) << generations_per_second << " generations/s"
+		<< " | " << std::scientific << std::setprecision(3) << cells_per_second << " cells/s"
+		<< std::defaultfloat
+		<< " | population " << grid.generation_statistics.population
+		<< " | births " << grid.generation_statistics.number_of_births
+		<< " | deaths " << grid.generation_statistics.number_of_deaths
+		<< " | chunks " << grid.chunks.size();
+	print_bounding_box(grid.generation_statistics.bounding_box);
+	std::cout << " | checksum " << std::hex << grid.compute_checksum() << std::dec << std::endl;
+}
+
+void print_bounding_box(const Grid_Bounding_Box& bounding_box) {
+	if (bounding_box.is_empty) {
+		std::cout << " | bounding box empty";
+		return;
+	}
+	std::cout << " | bounding box (" << bounding_box.min_row << ", " << bounding_box.min_column << ") to ("
+		<< bounding_box.max_row << ", " << bounding_box.max_column << ")";
+}
+
+//--------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+	Headless_Options options;
+	if (!parse_options(argc, argv, options)) {
+		print_usage();
+		return -1;
+	}
+
+	// the headless runner has no OpenCL support, the context stays invalid.
+	std::shared_ptr<OpenCLContext> opencl_context = std::make_shared < OpenCLContext > ();
+
+	bool is_default_pattern = options.pattern == "default" && options.pattern_path.empty();
+	std::unique_ptr<Grid> grid = std::make_unique < Grid > (opencl_context, is_default_pattern);
+	if (!options.pattern_path.empty()) {
+		auto load_start_time = std::chrono::steady_clock::now();
+		std::string error_message;
+		if (!load_pattern_file(options.pattern_path, *grid, error_message)) {
+			std::cout << error_message << std::endl;
+			return -1;
+		}
+		double load_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - load_start_time).count();
+		std::cout << "loaded " << options.pattern_path << " in " << load_seconds << " s" << std::endl;
+	} else if (options.pattern == "soup") {
+		grid->create_random_soup(options.soup_size, options.soup_density, options.seed);
+	} else if (!is_default_pattern) {
+		for (auto [row, column]: get_pattern_cells(options.pattern)) {
+			grid->set_cell_alive(row, column);
+		}
+		grid->finish_pattern_creation();
+	}
+	grid->set_number_of_threads(options.number_of_threads);
+	// nobody renders the grid, so dont extract the coordinates of the alive cells.
+	grid->should_update_coordinates_of_alive_cells = false;
+
+	std::cout << "pattern: " << (options.pattern_path.empty() ? options.pattern : options.pattern_path);
+	if (options.pattern_path.empty() && options.pattern == "soup") {
+		std::cout << " " << options.soup_size << "x" << options.soup_size << ", density " << options.soup_density << ", seed " << options.seed;
+	}
+	std::cout << " | threads: " << grid->thread_pool->get_number_of_threads()
+		<< " | temporal block: " << options.temporal_block_size
+		<< " | population " << grid->generation_statistics.population
+		<< " | chunks " << grid->chunks.size();
+	print_bounding_box(grid->generation_statistics.bounding_box);
+	std::cout << std::endl;
+
+	// we count every cell of every chunk as simulated, since the kernels process whole chunks.
+	double number_of_simulated_cells = 0.0;
+	double interval_number_of_simulated_cells = 0.0;
+
+	Grid_Checkpointer checkpointer;
+	Grid_History history(options.history_keyframe_interval, options.history_memory_budget_mb << 20);
+	bool should_record_history = options.history_keyframe_interval > 0;
+	if (should_record_history) {
+		history.record(*grid);
+	}
+	Grid_Statistics_Log statistics_log;
+	if (!options.statistics_log_path.empty()) {
+		std::string error_message;
+		if (!statistics_log.open(options.statistics_log_path, error_message)) {
+			std::cout << error_message << std::endl;
+			return -1;
+		}
+		statistics_log.record(*grid);
+	}
+
+	// the generations actually advanced, a pattern which dies stops advancing the iteration.
+	std::size_t start_iteration = grid->iteration;
+	std::size_t interval_start_iteration = start_iteration;
+	auto start_time = std::chrono::steady_clock::now();
+	auto interval_start_time = start_time;
+	std::size_t generation = 0;
+	while (generation < options.number_of_generations) {
+		// the last block gets shortened, so that the run ends exactly after number_of_generations.
+		std::size_t number_of_block_generations = std::min<std::size_t>(options.temporal_block_size, options.number_of_generations - generation);
+		double simulated_cells = static_cast<double>(grid->chunks.size()) * Chunk::rows * Chunk::columns * number_of_block_generations;
+		number_of_simulated_cells += simulated_cells;
+		interval_number_of_simulated_cells += simulated_cells;
+
+		grid->temporal_block_size = static_cast<int>(number_of_block_generations);
+		grid->next_iteration();
+		std::size_t previous_generation = generation;
+		generation += number_of_block_generations;
+		checkpointer.update(*grid, options.checkpoint_settings);
+		if (should_record_history) {
+			history.record(*grid);
+		}
+		statistics_log.record(*grid);
+
+		bool is_report_due = options.report_interval > 0 && generation / options.report_interval > previous_generation / options.report_interval;
+		if (is_report_due && generation != options.number_of_generations) {
+			auto now = std::chrono::steady_clock::now();
+			double interval_seconds = std::chrono::duration<double>(now - interval_start_time).count();
+			print_report(*grid, grid->iteration - interval_start_iteration, interval_seconds, interval_number_of_simulated_cells);
+			interval_start_iteration = grid->iteration;
+			interval_start_time = std::chrono::steady_clock::now();
+			interval_number_of_simulated_cells = 0.0;
+		}
+	}
+	auto end_time = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(end_time - start_time).count();
+
+	std::cout << "total: ";
+	print_report(*grid, grid->iteration - start_iteration, seconds, number_of_simulated_cells);
+
+	if (should_record_history) {
+		History_Statistics statistics = history.get_statistics();
+		std::cout << "history: generations " << statistics.first_iteration << " to " << statistics.last_iteration
+			<< " | " << statistics.number_of_keyframes << " keyframes"
+			<< " | " << std::fixed << std::setprecision(1) << statistics.memory_bytes / double(1 << 20) << " MB"
+			<< " | " << (statistics.memory_bytes > 0 ? statistics.uncompressed_bytes / statistics.memory_bytes : 0.0) << "x compressed" << std::defaultfloat << std::endl;
+	}
+	if (options.seek_iteration >= 0) {
+		auto seek_start_time = std::chrono::steady_clock::now();
+		std::unique_ptr<Grid> restored_grid = std::make_unique < Grid > (opencl_context, false);
+		std::string error_message;
+		if (!history.restore(static_cast<std::size_t>(options.seek_iteration), *restored_grid, error_message)) {
+			std::cout << error_message << std::endl;
+			return -1;
+		}
+		restored_grid->finish_pattern_creation();
+		double seek_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - seek_start_time).count();
+		std::cout << "seek to generation " << restored_grid->iteration << " in " << seek_seconds << " s"
+			<< " | population " << restored_grid->generation_statistics.population
+			<< " | checksum " << std::hex << restored_grid->compute_checksum() << std::dec << std::endl;
+	}
+	if (statistics_log.is_open()) {
+		Statistics_Log_Status statistics_log_status = statistics_log.get_status();
+		std::string error_message;
+		if (!statistics_log.close(error_message)) {
+			std::cout << error_message << std::endl;
+			return -1;
+		}
+		std::cout << "statistics log: " << statistics_log_status.number_of_records << " records in " << options.statistics_log_path
+			<< " | " << statistics_log_status.number_of_full_buffer_waits << " waits for the writer" << std::endl;
+		if (!options.statistics_csv_path.empty()) {
+			if (!convert_statistics_log_to_csv(options.statistics_log_path, options.statistics_csv_path, error_message)) {
+				std::cout << error_message << std::endl;
+				return -1;
+			}
+			std::cout << "converted the statistics log to " << options.statistics_csv_path << std::endl;
+		}
+	}
+	if (options.checkpoint_settings.interval > 0) {
+		// the capture of the last checkpoint waits for a generation which does not come anymore.
+		checkpointer.finish_capture(*grid);
+		checkpointer.wait_until_idle();
+		Grid_Checkpoint_Status checkpoint_status = checkpointer.get_status();
+		std::cout << "checkpoints: " << checkpoint_status.number_of_checkpoints << " written"
+			<< " | last " << checkpoint_status.last_path
+			<< " | capture " << std::fixed << std::setprecision(2) << checkpoint_status.last_capture_seconds * 1000.0 << " ms"
+			<< " | latency " << checkpoint_status.last_latency_seconds * 1000.0 << " ms" << std::defaultfloat << std::endl;
+		if (!checkpoint_status.error_message.empty()) {
+			std::cout << checkpoint_status.error_message << std::endl;
+		}
+	}
+
+	if (!options.save_macrocell_path.empty()) {
+		auto save_start_time = std::chrono::steady_clock::now();
+		std::string error_message;
+		if (!save_macrocell_file(options.save_macrocell_path, *grid, error_message)) {
+			std::cout << error_message << std::endl;
+			return -1;
+		}
+		double save_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - save_start_time).count();
+		std::cout << "saved " << options.save_macrocell_path << " in " << save_seconds << " s" << std::endl;
+	}
+	if (!options.save_snapshot_path.empty()) {
+		auto save_start_time = std::chrono::steady_clock::now();
+		std::string error_message;
+		if (!save_grid_snapshot(options.save_snapshot_path, *grid, error_message)) {
+			std::cout << error_message << std::endl;
+			return -1;
+		}
+		double save_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - save_start_time).count();
+		std::cout << "saved " << options.save_snapshot_path << " in " << save_seconds << " s" << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,212 @@
+#include "history.hpp"
+
+#include "grid.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+
+//--------------------------------------------------------------------------------
+static_assert(Chunk::rows == 32 && Chunk::columns == 32);
+
+static bool is_zero(const History_Chunk_Bits& bits) {
+	return std::all_of(bits.rows.begin(), bits.rows.end(), [](std::uint32_t row) { return row == 0; });
+}
+
+//--------------------------------------------------------------------------------
+Grid_History::Grid_History(std::size_t keyframe_interval, std::size_t memory_budget_bytes) :
+	keyframe_interval(std::max<std::size_t>(keyframe_interval, 1)),
+memory_budget_bytes(memory_budget_bytes),
+frames({}),
+memory_bytes(0),
+iteration_of_last_keyframe(0),
+previous_chunks({})
+{
+	ZoneScopedFrame;
+}
+
+void Grid_History::record(const Grid& grid) {
+	ZoneScopedPhase;
+
+	bool is_keyframe = frames.empty() || grid.iteration >= iteration_of_last_keyframe + keyframe_interval;
+	if (!frames.empty() && grid.iteration <= frames.back().iteration) {
+		// the grid went back in time, the recorded future is gone.
+		while (!frames.empty() && frames.back().iteration >= grid.iteration) {
+			memory_bytes -= get_frame_memory_bytes(frames.back());
+			frames.pop_back();
+		}
+		is_keyframe = true;
+	}
+	if (is_keyframe) {
+		previous_chunks.clear();
+		iteration_of_last_keyframe = grid.iteration;
+	}
+
+	History_Frame frame;
+	// a generation usually encodes to about as much as the one before.
+	frame.data.reserve(frames.empty() ? 0 : frames.back().data.size() + frames.back().data.size() / 8);
+	frame.iteration = grid.iteration;
+	frame.is_keyframe = is_keyframe;
+	frame.number_of_grid_chunks = grid.chunks.size();
+	for (const Chunk& chunk: grid.chunks) {
+		Coordinate coord = Coordinate(chunk.grid_coordinate_row, chunk.grid_coordinate_column);
+		History_Chunk_Bits bits = { chunk.get_row_bits() };
+		auto previous_chunk = previous_chunks.find(coord);
+		if (previous_chunk == previous_chunks.end()) {
+			if (!is_zero(bits)) {
+				encode_chunk(coord, bits, frame);
+				previous_chunks.emplace(coord, Previous_Chunk{ bits, grid.iteration });
+			}
+			continue;
+		}
+
+		History_Chunk_Bits delta;
+		for (int r = 0; r < Chunk::rows; r++) {
+			delta.rows[r] = previous_chunk->second.bits.rows[r] ^ bits.rows[r];
+		}
+		if (!is_zero(delta)) {
+			encode_chunk(coord, delta, frame);
+		}
+		if (is_zero(bits)) {
+			previous_chunks.erase(previous_chunk);
+		} else {
+			previous_chunk->second = Previous_Chunk{ bits, grid.iteration };
+		}
+	}
+	// chunks which got removed from the grid since the last generation, the delta clears them.
+	boost::unordered::erase_if(previous_chunks, [&](const auto& entry) {
+		if (entry.second.last_seen_iteration == grid.iteration) {
+			return false;
+		}
+		encode_chunk(entry.first, entry.second.bits, frame);
+		return true;
+	});
+
+	frame.data.shrink_to_fit();
+	memory_bytes += get_frame_memory_bytes(frame);
+	frames.push_back(std::move(frame));
+	drop_frames_over_budget();
+}
+
+void Grid_History::encode_chunk(const Coordinate& coord, const History_Chunk_Bits& bits, History_Frame& frame) {
+	std::uint32_t row_mask = 0;
+	for (int r = 0; r < Chunk::rows; r++) {
+		row_mask |= (bits.rows[r] != 0 ? 1u : 0u) << r;
+	}
+	std::size_t position = frame.data.size();
+	frame.data.resize(position + 3 + _mm_popcnt_u32(row_mask));
+	std::uint32_t* data = frame.data.data() + position;
+	*data++ = static_cast<std::uint32_t>(coord.x);
+	*data++ = static_cast<std::uint32_t>(coord.y);
+	*data++ = row_mask;
+	for (int r = 0; r < Chunk::rows; r++) {
+		if (bits.rows[r] != 0) {
+			*data++ = bits.rows[r];
+		}
+	}
+	frame.number_of_chunks++;
+}
+
+void Grid_History::drop_frames_over_budget() {
+	ZoneScopedPhase;
+
+	// only whole keyframe groups can go, the newest group always stays.
+	while (memory_bytes > memory_budget_bytes) {
+		auto next_keyframe = std::find_if(frames.begin() + 1, frames.end(), [](const History_Frame& frame) { return frame.is_keyframe; });
+		if (next_keyframe == frames.end()) {
+			return;
+		}
+		for (auto frame = frames.begin(); frame != next_keyframe; ++frame) {
+			memory_bytes -= get_frame_memory_bytes(*frame);
+		}
+		frames.erase(frames.begin(), next_keyframe);
+	}
+}
+
+std::size_t Grid_History::get_frame_memory_bytes(const History_Frame& frame) {
+	return sizeof(History_Frame) + frame.data.capacity() * sizeof(std::uint32_t);
+}
+
+void Grid_History::clear() {
+	ZoneScopedPhase;
+
+	frames.clear();
+	previous_chunks.clear();
+	memory_bytes = 0;
+	iteration_of_last_keyframe = 0;
+}
+
+bool Grid_History::restore(std::size_t iteration, Grid& grid, std::string& error_message) const {
+	ZoneScopedPhase;
+
+	if (frames.empty() || iteration < frames.front().iteration) {
+		error_message = "iteration " + std::to_string(iteration) + " is not recorded";
+		return false;
+	}
+	auto target_frame = std::upper_bound(frames.begin(), frames.end(), iteration, [](std::size_t value, const History_Frame& frame) { return value < frame.iteration; }) - 1;
+	auto keyframe = target_frame;
+	while (!keyframe->is_keyframe) {
+		--keyframe;
+	}
+
+	boost::unordered_flat_map<Coordinate, History_Chunk_Bits> chunks;
+	for (auto frame = keyframe; frame != target_frame + 1; ++frame) {
+		const std::vector<std::uint32_t>& data = frame->data;
+		std::size_t position = 0;
+		while (position < data.size()) {
+			Coordinate coord = Coordinate(static_cast<int>(data[position]), static_cast<int>(data[position + 1]));
+			std::uint32_t row_mask = data[position + 2];
+			position += 3;
+			History_Chunk_Bits& bits = chunks.try_emplace(coord, History_Chunk_Bits{}).first->second;
+			for (int r = 0; r < Chunk::rows; r++) {
+				if (row_mask & (1u << r)) {
+					bits.rows[r] ^= data[position++];
+				}
+			}
+			if (is_zero(bits)) {
+				chunks.erase(coord);
+			}
+		}
+	}
+
+	grid.chunks.reserve(grid.chunks.size() + chunks.size());
+	for (const auto& [coord, bits]: chunks) {
+		std::size_t chunk_index = grid.chunk_map.find(coord);
+		if (chunk_index == Chunk_Directory::INVALID_CHUNK_INDEX) {
+			chunk_index = grid.chunks.size();
+			grid.create_new_chunk(coord);
+		}
+		grid.chunks[chunk_index].set_cells_from_row_bits(bits.rows);
+	}
+	grid.number_of_chunks = grid.chunks.size();
+	grid.iteration = target_frame->iteration;
+	return true;
+}
+
+bool Grid_History::is_empty() const {
+	return frames.empty();
+}
+
+History_Statistics Grid_History::get_statistics() const {
+	History_Statistics statistics;
+	statistics.number_of_frames = frames.size();
+	statistics.memory_bytes = memory_bytes;
+	for (const History_Frame& frame: frames) {
+		statistics.number_of_keyframes += frame.is_keyframe ? 1 : 0;
+		statistics.uncompressed_bytes += static_cast<double>(frame.number_of_grid_chunks) * Chunk::rows * Chunk::columns;
+	}
+	if (!frames.empty()) {
+		statistics.first_iteration = frames.front().iteration;
+		statistics.last_iteration = frames.back().iteration;
+	}
+	return statistics;
+}
+
+void Grid_History::set_keyframe_interval(std::size_t interval) {
+	keyframe_interval = std::max<std::size_t>(interval, 1);
+}
+
+void Grid_History::set_memory_budget(std::size_t budget_bytes) {
+	memory_budget_bytes = budget_bytes;
+	drop_frames_over_budget();
+}
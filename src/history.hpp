@@ -0,0 +1,97 @@
+#pragma once
+
+#include "profiling.hpp"
+#include "coordinate.hpp"
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <boost/unordered/unordered_flat_map.hpp>
+
+class Grid;
+
+
+//--------------------------------------------------------------------------------
+// One bit per cell, bit c of rows[r] is the cell at (r, c) of a chunk. A quarter of a cache line per 8 rows instead of
+// the byte per cell of Chunk::cells_data.
+struct History_Chunk_Bits {
+	std::array<std::uint32_t, 32> rows;
+};
+
+// A recorded generation. Keyframes hold every non empty chunk, all other frames hold the XOR of the changed chunks with
+// their state in the previous frame. Both store the same stream of encoded chunks:
+//   chunk row, chunk column, mask of the non zero rows, the non zero rows
+// so empty rows, which are most rows of a delta and of sparse patterns, cost a single bit.
+struct History_Frame {
+	std::size_t iteration = 0;
+	bool is_keyframe = false;
+	std::size_t number_of_chunks = 0;
+	// chunks of the grid in this generation, for the compression statistics.
+	std::size_t number_of_grid_chunks = 0;
+	std::vector<std::uint32_t> data;
+};
+
+struct History_Statistics {
+	std::size_t number_of_frames = 0;
+	std::size_t number_of_keyframes = 0;
+	std::size_t first_iteration = 0;
+	std::size_t last_iteration = 0;
+	std::size_t memory_bytes = 0;
+	// bytes the recorded generations would take as Chunk::cells_data.
+	double uncompressed_bytes = 0.0;
+};
+
+//--------------------------------------------------------------------------------
+// Records the generations of a grid for stepping backwards and seeking. Every keyframe_interval generations a keyframe
+// gets stored, in between only the changed chunks as deltas. Seeking replays the deltas from the nearest keyframe before
+// the target. Once the history needs more than memory_budget_bytes, the oldest keyframe and its deltas get dropped.
+class Grid_History {
+public:
+	Grid_History(std::size_t keyframe_interval, std::size_t memory_budget_bytes);
+
+	// call after every generation. A grid iteration which is not after the last recorded one (a reset or a seek back)
+	// drops the recorded future and starts over with a keyframe. With Grid::temporal_block_size K > 1 only every K-th
+	// generation gets recorded, the keyframe interval still counts generations and a seek lands on the recorded
+	// generation at or before the target.
+	void record(const Grid& grid);
+
+	void clear();
+
+	// creates the chunks of the latest recorded generation at or before iteration in grid, which should be empty. Like
+	// the pattern loaders it does not sort the chunks, call Grid::finish_pattern_creation() afterwards. Returns false if
+	// no such generation is recorded.
+	bool restore(std::size_t iteration, Grid& grid, std::string& error_message) const;
+
+	bool is_empty() const;
+
+	History_Statistics get_statistics() const;
+
+	void set_keyframe_interval(std::size_t keyframe_interval);
+
+	void set_memory_budget(std::size_t memory_budget_bytes);
+
+private:
+	void encode_chunk(const Coordinate& coord, const History_Chunk_Bits& bits, History_Frame& frame);
+
+	void drop_frames_over_budget();
+
+	static std::size_t get_frame_memory_bytes(const History_Frame& frame);
+	//--------------------------------------------------------------------------------
+	// data
+	std::size_t keyframe_interval;
+	std::size_t memory_budget_bytes;
+
+	std::deque<History_Frame> frames;
+	std::size_t memory_bytes;
+	std::size_t iteration_of_last_keyframe;
+
+	// the non empty chunks of the last recorded generation, the deltas get computed against them.
+	struct Previous_Chunk {
+		History_Chunk_Bits bits;
+		std::size_t last_seen_iteration;
+	};
+	boost::unordered_flat_map<Coordinate, Previous_Chunk> previous_chunks;
+};
@@ -0,0 +1,183 @@
+#include "instance_stream_buffer.hpp"
+#include "buffer_mapping.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+
+//--------------------------------------------------------------------------------
+// not in the GL 3.3 headers of glad.
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+//--------------------------------------------------------------------------------
+Instance_Stream_Buffer::Instance_Stream_Buffer() :
+	buffer(0),
+buffer_storage_function(nullptr),
+use_persistent_mapping(false),
+mapped_data(nullptr),
+slot_capacity(0),
+slot_fences({}),
+write_slot(0),
+draw_slot(0),
+number_of_instances(0),
+number_of_written_instances(0)
+{
+
+}
+
+Instance_Stream_Buffer::~Instance_Stream_Buffer() {
+	ZoneScopedFrame;
+
+	if (has_current_opengl_context()) {
+		delete_buffer();
+	}
+}
+
+void Instance_Stream_Buffer::initialise() {
+	ZoneScopedFrame;
+
+	if (glfwExtensionSupported("GL_ARB_buffer_storage")) {
+		buffer_storage_function = reinterpret_cast<Buffer_Storage_Function>(glfwGetProcAddress("glBufferStorage"));
+	}
+	use_persistent_mapping = buffer_storage_function != nullptr;
+	std::cout << "Instance data: " << (use_persistent_mapping ? "persistently mapped ring buffer" : "buffer orphaning") << std::endl;
+
+	glGenBuffers(1, &buffer);
+	if (use_persistent_mapping) {
+		create_persistent_buffer(1 << 16);
+	}
+}
+
+//--------------------------------------------------------------------------------
+glm::vec3* Instance_Stream_Buffer::begin_write(std::size_t number_of_instances_to_write) {
+	ZoneScopedFrame;
+
+	number_of_written_instances = number_of_instances_to_write;
+	if (use_persistent_mapping && number_of_instances_to_write > slot_capacity) {
+		// may fall back to orphaning if the larger buffer can not be mapped.
+		create_persistent_buffer(std::max(number_of_instances_to_write, slot_capacity * 2));
+	}
+	if (use_persistent_mapping) {
+		write_slot = (draw_slot + 1) % NUMBER_OF_SLOTS;
+		wait_for_slot(write_slot);
+		return mapped_data + write_slot * slot_capacity;
+	}
+
+	void* data = map_orphaned_buffer(GL_ARRAY_BUFFER, buffer, number_of_instances_to_write * sizeof(glm::vec3));
+	if (data == nullptr) {
+		number_of_written_instances = 0;
+	}
+	return static_cast<glm::vec3*>(data);
+}
+
+void Instance_Stream_Buffer::end_write() {
+	ZoneScopedFrame;
+
+	if (use_persistent_mapping) {
+		// the mapping is coherent, the writes are visible to every draw issued from now on.
+		draw_slot = write_slot;
+		number_of_instances = number_of_written_instances;
+		return;
+	}
+
+	bool is_valid = unmap_buffer(GL_ARRAY_BUFFER, buffer);
+	draw_slot = 0;
+	number_of_instances = is_valid ? number_of_written_instances : 0;
+}
+
+void Instance_Stream_Buffer::set_instance_attribute_pointer(GLuint attribute_index) {
+	ZoneScopedFrame;
+
+	std::size_t offset = static_cast<std::size_t>(draw_slot) * slot_capacity * sizeof(glm::vec3);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glVertexAttribPointer(attribute_index, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), reinterpret_cast<void*>(offset));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Instance_Stream_Buffer::fence_draws() {
+	ZoneScopedFrame;
+
+	if (!use_persistent_mapping) {
+		return;
+	}
+	// the slot gets drawn every frame until the next generation arrives, only the last draw matters.
+	if (slot_fences[draw_slot] != nullptr) {
+		glDeleteSync(slot_fences[draw_slot]);
+	}
+	slot_fences[draw_slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+std::size_t Instance_Stream_Buffer::get_number_of_instances() const {
+	return number_of_instances;
+}
+
+bool Instance_Stream_Buffer::is_persistently_mapped() const {
+	return use_persistent_mapping;
+}
+
+//--------------------------------------------------------------------------------
+void Instance_Stream_Buffer::create_persistent_buffer(std::size_t capacity) {
+	ZoneScopedFrame;
+
+	// immutable storage can not grow, so we wait for every draw and start over with a larger buffer.
+	delete_buffer();
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	GLsizeiptr size = static_cast<GLsizeiptr>(capacity * NUMBER_OF_SLOTS * sizeof(glm::vec3));
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	buffer_storage_function(GL_ARRAY_BUFFER, size, nullptr, flags);
+	mapped_data = static_cast<glm::vec3*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	slot_capacity = capacity;
+	draw_slot = 0;
+	number_of_instances = 0;
+	if (mapped_data == nullptr) {
+		// the driver claimed the extension but can not map, orphaning works everywhere. It needs a buffer with mutable
+		// storage though, glBufferData fails on the one from glBufferStorage.
+		std::cout << "Failed to map the instance buffer persistently, falling back to buffer orphaning." << std::endl;
+		delete_buffer();
+		glGenBuffers(1, &buffer);
+		use_persistent_mapping = false;
+		slot_capacity = 0;
+	}
+}
+
+void Instance_Stream_Buffer::wait_for_slot(int slot) {
+	ZoneScopedFrame;
+
+	GLsync fence = slot_fences[slot];
+	if (fence == nullptr) {
+		return;
+	}
+	// with three slots the draw two frames ago is usually long done, so this almost never blocks.
+	while (true) {
+		GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED) {
+			break;
+		}
+	}
+	glDeleteSync(fence);
+	slot_fences[slot] = nullptr;
+}
+
+void Instance_Stream_Buffer::delete_buffer() {
+	ZoneScopedFrame;
+
+	for (int slot = 0; slot < NUMBER_OF_SLOTS; slot++) {
+		wait_for_slot(slot);
+	}
+	if (buffer != 0) {
+		if (mapped_data != nullptr) {
+			unmap_buffer(GL_ARRAY_BUFFER, buffer);
+			mapped_data = nullptr;
+		}
+		glDeleteBuffers(1, &buffer);
+		buffer = 0;
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "profiling.hpp"
+#include "opengl.hpp"
+
+#include <array>
+#include <cstddef>
+
+
+//--------------------------------------------------------------------------------
+// Streams the per instance translations of the cubes to the GPU. If the context has ARB_buffer_storage (core since GL
+// 4.4, our glad loader only knows GL 3.3, so glBufferStorage gets loaded through GLFW) the buffer is mapped once,
+// persistently and coherently, and split into three slots. The CPU writes the next generation straight into a slot
+// which the GPU is done with, every slot gets a glFenceSync after its last draw which the next write into it waits for.
+// Without the extension every write orphans the buffer with glBufferData and maps the fresh storage.
+class Instance_Stream_Buffer {
+public:
+	Instance_Stream_Buffer();
+
+	~Instance_Stream_Buffer();
+
+	Instance_Stream_Buffer(const Instance_Stream_Buffer&) = delete;
+
+	Instance_Stream_Buffer& operator = (const Instance_Stream_Buffer&) = delete;
+
+	// needs the current OpenGL context.
+	void initialise();
+
+	// returns the memory for the next number_of_instances translations, they are drawn after end_write(). The memory
+	// may be written from any thread until then.
+	glm::vec3* begin_write(std::size_t number_of_instances);
+
+	void end_write();
+
+	// points the instance attribute at the translations of the last end_write(), the VAO has to be bound.
+	void set_instance_attribute_pointer(GLuint attribute_index);
+
+	// call after the draws which used the translations, so that their slot is not overwritten while the GPU reads it.
+	void fence_draws();
+
+	std::size_t get_number_of_instances() const;
+
+	bool is_persistently_mapped() const;
+
+private:
+	constexpr static int NUMBER_OF_SLOTS = 3;
+
+	using Buffer_Storage_Function = void (GLAPIENTRY*)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+	// recreates the persistently mapped buffer with room for slot_capacity instances per slot.
+	void create_persistent_buffer(std::size_t capacity);
+
+	void wait_for_slot(int slot);
+
+	void delete_buffer();
+	//--------------------------------------------------------------------------------
+	// data
+	GLuint buffer;
+	Buffer_Storage_Function buffer_storage_function;
+	bool use_persistent_mapping;
+
+	// persistent mapping, slot i starts at mapped_data + i * slot_capacity.
+	glm::vec3* mapped_data;
+	std::size_t slot_capacity;
+	std::array<GLsync, NUMBER_OF_SLOTS> slot_fences;
+	int write_slot;
+
+	// the slot (always 0 when orphaning) and the number of the translations of the last end_write().
+	int draw_slot;
+	std::size_t number_of_instances;
+	std::size_t number_of_written_instances;
+};
@@ -0,0 +1,467 @@
+#include "macrocell.hpp"
+
+#include "grid.hpp"
+#include "pattern_io.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#include <boost/unordered/unordered_flat_map.hpp>
+
+
+//--------------------------------------------------------------------------------
+constexpr static int MACROCELL_LEAF_LEVEL = 3;
+constexpr static int MACROCELL_LEAF_SIZE = 1 << MACROCELL_LEAF_LEVEL;
+// level of the nodes which cover exactly one chunk.
+constexpr static int MACROCELL_CHUNK_LEVEL = 5;
+constexpr static int MACROCELL_MAXIMUM_LEVEL = 63;
+// deep trees can describe far more chunks than fit into memory, counting saturates at the chunks of 64 GB and the load
+// fails. Smaller machines run out of memory before that, which gets reported as an error as well.
+constexpr static std::uint64_t MACROCELL_MAXIMUM_MEMORY = std::uint64_t(64) << 30;
+constexpr static std::uint64_t MACROCELL_MAXIMUM_NUMBER_OF_CHUNKS = MACROCELL_MAXIMUM_MEMORY / sizeof(Chunk);
+static_assert(Chunk::rows == 1 << MACROCELL_CHUNK_LEVEL && Chunk::columns == 1 << MACROCELL_CHUNK_LEVEL);
+
+struct Macrocell_Node {
+	int level = 0;
+	// nw, ne, sw, se.
+	std::array<std::uint32_t, 4> children = {};
+	// leaves only, bit row * 8 + column is the cell at (row, column).
+	std::uint64_t leaf_cells = 0;
+};
+
+//--------------------------------------------------------------------------------
+// Expands the parsed quadtree into the chunks of a grid. Chunk sized nodes get decoded into a bitmap the first time
+// they show up and are copied from there for every further occurence.
+struct Macrocell_Expander {
+	constexpr static std::int32_t NOT_DECODED = -1;
+	constexpr static std::int32_t EMPTY = -2;
+
+	// writes the cells of a node of at most chunk size into cells, a bitmap with Chunk::columns bytes per row.
+	void decode(std::uint32_t node_id, int row, int column, unsigned char* cells) const;
+
+	// number of chunk sized nodes below node_id, memoised per node, so that the chunks can be reserved up front.
+	std::uint64_t count_chunks(std::uint32_t node_id);
+
+	void expand(std::uint32_t node_id, std::int64_t row, std::int64_t column);
+
+	void place_chunk(std::uint32_t node_id, std::int64_t row, std::int64_t column);
+
+	const std::vector<Macrocell_Node>& nodes;
+	Grid& grid;
+	// index into decoded_chunks, NOT_DECODED or EMPTY per node.
+	std::vector<std::int32_t> decoded_chunk_index_of_node;
+	std::vector<std::array<unsigned char, Chunk::rows * Chunk::columns>> decoded_chunks;
+	std::vector<std::uint64_t> number_of_chunks_of_node;
+	bool is_out_of_range = false;
+};
+
+void Macrocell_Expander::decode(std::uint32_t node_id, int row, int column, unsigned char* cells) const {
+	if (node_id == 0) {
+		return;
+	}
+	const Macrocell_Node& node = nodes[node_id];
+	if (node.level == MACROCELL_LEAF_LEVEL) {
+		for (int r = 0; r < MACROCELL_LEAF_SIZE; r++) {
+			unsigned int row_cells = static_cast<unsigned int>(node.leaf_cells >> (r * MACROCELL_LEAF_SIZE)) & 0xFF;
+			for (int c = 0; c < MACROCELL_LEAF_SIZE; c++) {
+				if (row_cells & (1u << c)) {
+					cells[(row + r) * Chunk::columns + column + c] = 0xFF;
+				}
+			}
+		}
+		return;
+	}
+	int half_size = 1 << (node.level - 1);
+	decode(node.children[0], row, column, cells);
+	decode(node.children[1], row, column + half_size, cells);
+	decode(node.children[2], row + half_size, column, cells);
+	decode(node.children[3], row + half_size, column + half_size, cells);
+}
+
+std::uint64_t Macrocell_Expander::count_chunks(std::uint32_t node_id) {
+	if (node_id == 0) {
+		return 0;
+	}
+	const Macrocell_Node& node = nodes[node_id];
+	if (node.level == MACROCELL_CHUNK_LEVEL) {
+		return 1;
+	}
+	std::uint64_t& number_of_chunks = number_of_chunks_of_node[node_id];
+	if (number_of_chunks == 0) {
+		for (std::uint32_t child: node.children) {
+			number_of_chunks = std::min(number_of_chunks + count_chunks(child), MACROCELL_MAXIMUM_NUMBER_OF_CHUNKS);
+		}
+	}
+	return number_of_chunks;
+}
+
+void Macrocell_Expander::expand(std::uint32_t node_id, std::int64_t row, std::int64_t column) {
+	if (node_id == 0 || is_out_of_range) {
+		return;
+	}
+	const Macrocell_Node& node = nodes[node_id];
+	if (node.level == MACROCELL_CHUNK_LEVEL) {
+		place_chunk(node_id, row, column);
+		return;
+	}
+	std::int64_t half_size = std::int64_t(1) << (node.level - 1);
+	expand(node.children[0], row, column);
+	expand(node.children[1], row, column + half_size);
+	expand(node.children[2], row + half_size, column);
+	expand(node.children[3], row + half_size, column + half_size);
+}
+
+void Macrocell_Expander::place_chunk(std::uint32_t node_id, std::int64_t row, std::int64_t column) {
+	ZoneScopedChunk;
+
+	std::int32_t& decoded_chunk_index = decoded_chunk_index_of_node[node_id];
+	if (decoded_chunk_index == NOT_DECODED) {
+		std::array<unsigned char, Chunk::rows * Chunk::columns> cells;
+		cells.fill(0);
+		decode(node_id, 0, 0, cells.data());
+		if (std::all_of(cells.begin(), cells.end(), [](unsigned char cell) { return cell == 0; })) {
+			decoded_chunk_index = EMPTY;
+		} else {
+			decoded_chunk_index = static_cast<std::int32_t>(decoded_chunks.size());
+			decoded_chunks.push_back(cells);
+		}
+	}
+	if (decoded_chunk_index == EMPTY) {
+		return;
+	}
+	// same limits as the other importers, far away chunks would overflow the cell coordinates of their neighbours.
+	if (row < INT32_MIN / 2 || row > INT32_MAX / 2 || column < INT32_MIN / 2 || column > INT32_MAX / 2) {
+		is_out_of_range = true;
+		return;
+	}
+
+	// chunk sized nodes of a tree with a root of at least level 6 are always aligned to the chunk grid.
+	Coordinate chunk_coordinate = Coordinate(static_cast<int>(row / Chunk::rows), static_cast<int>(column / Chunk::columns));
+	std::size_t chunk_index = grid.chunk_map.find(chunk_coordinate);
+	if (chunk_index == Chunk_Directory::INVALID_CHUNK_INDEX) {
+		chunk_index = grid.chunks.size();
+		grid.create_new_chunk(chunk_coordinate);
+	}
+	Chunk& chunk = grid.chunks[chunk_index];
+	std::memcpy(chunk.cells_data.data(), decoded_chunks[decoded_chunk_index].data(), chunk.cells_data.size());
+	chunk.has_alive_cells = true;
+}
+
+//--------------------------------------------------------------------------------
+// "8x8 leaf" lines, eg "..*$...*$***$" for a glider.
+static bool parse_macrocell_leaf(const std::string& line, Macrocell_Node& node) {
+	node.level = MACROCELL_LEAF_LEVEL;
+	int row = 0;
+	int column = 0;
+	for (char character: line) {
+		if (character == '$') {
+			row++;
+			column = 0;
+		} else if (character == '.' || character == '*') {
+			if (row >= MACROCELL_LEAF_SIZE || column >= MACROCELL_LEAF_SIZE) {
+				return false;
+			}
+			if (character == '*') {
+				node.leaf_cells |= std::uint64_t(1) << (row * MACROCELL_LEAF_SIZE + column);
+			}
+			column++;
+		} else if (!std::isspace(static_cast<unsigned char>(character))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// "level nw ne sw se" lines.
+static bool parse_macrocell_inner_node(const std::string& line, Macrocell_Node& node) {
+	const char* position = line.c_str();
+	char* end = nullptr;
+	node.level = static_cast<int>(std::strtol(position, &end, 10));
+	if (end == position) {
+		return false;
+	}
+	for (std::uint32_t& child: node.children) {
+		position = end;
+		unsigned long long child_id = std::strtoull(position, &end, 10);
+		if (end == position || child_id > UINT32_MAX) {
+			return false;
+		}
+		child = static_cast<std::uint32_t>(child_id);
+	}
+	return true;
+}
+
+bool load_macrocell_pattern(Pattern_File_Stream& stream, Grid& grid, std::string& error_message) {
+	ZoneScopedPhase;
+
+	std::string header = stream.read_line();
+	if (header.rfind("[M2]", 0) != 0) {
+		error_message = "missing macrocell header \"[M2]\"";
+		return false;
+	}
+
+	// node 0 is the empty node of any level.
+	std::vector<Macrocell_Node> nodes(1);
+	while (stream.peek() != Pattern_File_Stream::END_OF_FILE) {
+		std::size_t line_number = stream.get_line_number();
+		std::string line = stream.read_line();
+		if (line.empty()) {
+			continue;
+		}
+		if (line[0] == '#') {
+			if (line.rfind("#R", 0) == 0) {
+				std::string rule = line.substr(2);
+				rule.erase(std::remove_if(rule.begin(), rule.end(), [](unsigned char character) { return std::isspace(character); }), rule.end());
+				std::transform(rule.begin(), rule.end(), rule.begin(), [](unsigned char character) { return static_cast<char>(std::toupper(character)); });
+				if (rule != "B3/S23" && rule != "23/3") {
+					error_message = "unsupported rule " + rule + ", only B3/S23 is supported";
+					return false;
+				}
+			} else if (line.rfind("#G", 0) == 0) {
+				grid.iteration = std::strtoull(line.c_str() + 2, nullptr, 10);
+			}
+			continue;
+		}
+
+		Macrocell_Node node;
+		if (line[0] == '.' || line[0] == '*' || line[0] == '$') {
+			if (!parse_macrocell_leaf(line, node)) {
+				error_message = "malformed leaf in line " + std::to_string(line_number);
+				return false;
+			}
+		} else {
+			if (!parse_macrocell_inner_node(line, node) || node.level <= MACROCELL_LEAF_LEVEL || node.level > MACROCELL_MAXIMUM_LEVEL) {
+				error_message = "malformed node in line " + std::to_string(line_number);
+				return false;
+			}
+			for (std::uint32_t child: node.children) {
+				if (child >= nodes.size() || (child != 0 && nodes[child].level != node.level - 1)) {
+					error_message = "invalid child node " + std::to_string(child) + " in line " + std::to_string(line_number);
+					return false;
+				}
+			}
+		}
+		nodes.push_back(node);
+	}
+	if (nodes.size() == 1) {
+		return true;
+	}
+
+	Macrocell_Expander expander{ nodes, grid, std::vector<std::int32_t>(nodes.size(), Macrocell_Expander::NOT_DECODED), {}, std::vector<std::uint64_t>(nodes.size(), 0), false };
+	std::uint32_t root_id = static_cast<std::uint32_t>(nodes.size() - 1);
+	const Macrocell_Node& root = nodes[root_id];
+	if (root.level <= MACROCELL_CHUNK_LEVEL) {
+		// small roots are not aligned to the chunk grid, place them cell by cell.
+		std::array<unsigned char, Chunk::rows * Chunk::columns> cells;
+		cells.fill(0);
+		expander.decode(root_id, 0, 0, cells.data());
+		int half_size = 1 << (root.level - 1);
+		for (int r = 0; r < Chunk::rows; r++) {
+			for (int c = 0; c < Chunk::columns; c++) {
+				if (cells[r * Chunk::columns + c]) {
+					grid.set_cell_alive(r - half_size, c - half_size);
+				}
+			}
+		}
+		return true;
+	}
+
+	// a chunk is several KB big, growing the chunks vector while expanding would copy all of them again and again.
+	std::uint64_t number_of_chunks = expander.count_chunks(root_id);
+	if (number_of_chunks >= MACROCELL_MAXIMUM_NUMBER_OF_CHUNKS) {
+		error_message = "pattern too big, it expands into more than " + std::to_string(MACROCELL_MAXIMUM_NUMBER_OF_CHUNKS) + " chunks";
+		return false;
+	}
+	try {
+		grid.chunks.reserve(grid.chunks.size() + number_of_chunks);
+		std::int64_t half_size = std::int64_t(1) << (root.level - 1);
+		expander.expand(root_id, -half_size, -half_size);
+	}
+	catch (const std::bad_alloc&) {
+		// give the memory back right away, the caller only gets an empty grid.
+		std::vector<Chunk>().swap(grid.chunks);
+		grid.chunk_map.clear();
+		grid.chunk_extent_index.clear();
+		grid.number_of_chunks = 0;
+		error_message = "out of memory, the pattern expands into " + std::to_string(number_of_chunks) + " chunks";
+		return false;
+	}
+	grid.number_of_chunks = grid.chunks.size();
+	if (expander.is_out_of_range) {
+		error_message = "pattern too big, cells are out of range";
+		return false;
+	}
+	return true;
+}
+
+//--------------------------------------------------------------------------------
+// Hash-conses the nodes while writing them, every node is written once, right before the first node which uses it.
+struct Macrocell_Writer {
+	constexpr static std::size_t FLUSH_SIZE = 1 << 20;
+
+	std::uint32_t get_leaf_id(std::uint64_t leaf_cells);
+
+	std::uint32_t get_node_id(int level, const std::array<std::uint32_t, 4>& children);
+
+	// returns the chunk sized node of the cells of chunk.
+	std::uint32_t get_chunk_node_id(const Chunk& chunk);
+
+	bool flush();
+
+	std::FILE* file = nullptr;
+	std::string buffer;
+	std::uint32_t number_of_nodes = 0;
+	boost::unordered_flat_map<std::uint64_t, std::uint32_t> leaf_ids;
+	boost::unordered_flat_map<std::array<std::uint32_t, 4>, std::uint32_t> node_ids;
+};
+
+std::uint32_t Macrocell_Writer::get_leaf_id(std::uint64_t leaf_cells) {
+	if (leaf_cells == 0) {
+		return 0;
+	}
+	auto [iterator, is_new] = leaf_ids.try_emplace(leaf_cells, number_of_nodes + 1);
+	if (!is_new) {
+		return iterator->second;
+	}
+	number_of_nodes++;
+
+	int last_row = MACROCELL_LEAF_SIZE - 1;
+	while (((leaf_cells >> (last_row * MACROCELL_LEAF_SIZE)) & 0xFF) == 0) {
+		last_row--;
+	}
+	for (int r = 0; r <= last_row; r++) {
+		unsigned int row_cells = static_cast<unsigned int>(leaf_cells >> (r * MACROCELL_LEAF_SIZE)) & 0xFF;
+		for (int c = 0; row_cells >> c; c++) {
+			buffer.push_back((row_cells >> c) & 1 ? '*' : '.');
+		}
+		buffer.push_back('$');
+	}
+	buffer.push_back('\n');
+	return number_of_nodes;
+}
+
+std::uint32_t Macrocell_Writer::get_node_id(int level, const std::array<std::uint32_t, 4>& children) {
+	if (children[0] == 0 && children[1] == 0 && children[2] == 0 && children[3] == 0) {
+		return 0;
+	}
+	// non empty children determine the level, so equal children always mean equal nodes.
+	auto [iterator, is_new] = node_ids.try_emplace(children, number_of_nodes + 1);
+	if (!is_new) {
+		return iterator->second;
+	}
+	number_of_nodes++;
+
+	buffer += std::to_string(level);
+	for (std::uint32_t child: children) {
+		buffer.push_back(' ');
+		buffer += std::to_string(child);
+	}
+	buffer.push_back('\n');
+	return number_of_nodes;
+}
+
+std::uint32_t Macrocell_Writer::get_chunk_node_id(const Chunk& chunk) {
+	ZoneScopedChunk;
+
+	constexpr int LEAVES_PER_SIDE = Chunk::columns / MACROCELL_LEAF_SIZE;
+
+	// one movemask per chunk row gives the 32 cells of the row as bits, byte i of the mask is a row of leaf column i.
+	std::array<std::uint64_t, LEAVES_PER_SIDE * LEAVES_PER_SIDE> leaves = {};
+	for (int r = 0; r < Chunk::rows; r++) {
+		__m256i row_cells = _mm256_load_si256(reinterpret_cast<const __m256i*>(&chunk.cells_data[r * Chunk::columns]));
+		std::uint32_t row_mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(row_cells));
+		for (int leaf_column = 0; leaf_column < LEAVES_PER_SIDE; leaf_column++) {
+			std::uint64_t leaf_row = (row_mask >> (leaf_column * MACROCELL_LEAF_SIZE)) & 0xFF;
+			leaves[(r / MACROCELL_LEAF_SIZE) * LEAVES_PER_SIDE + leaf_column] |= leaf_row << ((r % MACROCELL_LEAF_SIZE) * MACROCELL_LEAF_SIZE);
+		}
+	}
+
+	std::array<std::uint32_t, 4> quadrants;
+	for (int quadrant = 0; quadrant < 4; quadrant++) {
+		int first_leaf_row = (quadrant / 2) * 2;
+		int first_leaf_column = (quadrant % 2) * 2;
+		std::array<std::uint32_t, 4> children;
+		for (int child = 0; child < 4; child++) {
+			children[child] = get_leaf_id(leaves[(first_leaf_row + child / 2) * LEAVES_PER_SIDE + first_leaf_column + child % 2]);
+		}
+		quadrants[quadrant] = get_node_id(MACROCELL_LEAF_LEVEL + 1, children);
+	}
+	return get_node_id(MACROCELL_CHUNK_LEVEL, quadrants);
+}
+
+bool Macrocell_Writer::flush() {
+	bool is_written = std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+	buffer.clear();
+	return is_written;
+}
+
+bool save_macrocell_file(const std::string& path, const Grid& grid, std::string& error_message) {
+	ZoneScopedPhase;
+
+	Macrocell_Writer writer;
+	writer.file = std::fopen(path.c_str(), "wb");
+	if (!writer.file) {
+		error_message = "Could not open " + path + " for writing";
+		return false;
+	}
+	writer.buffer = "[M2] (grid_of_life)\n#R B3/S23\n#G " + std::to_string(grid.iteration) + "\n";
+	bool is_written = true;
+
+	// the nodes of one level by their position, in units of the node size. Each round merges 2x2 nodes into their
+	// parent until everything lies in the four quadrants around (0, 0), which become the children of the root.
+	boost::unordered_flat_map<Coordinate, std::uint32_t> level_node_ids;
+	for (const Chunk& chunk: grid.chunks) {
+		std::uint32_t node_id = writer.get_chunk_node_id(chunk);
+		if (node_id != 0) {
+			level_node_ids[Coordinate(chunk.grid_coordinate_row, chunk.grid_coordinate_column)] = node_id;
+		}
+		if (writer.buffer.size() >= Macrocell_Writer::FLUSH_SIZE) {
+			is_written = writer.flush() && is_written;
+		}
+	}
+
+	auto is_root_quadrant = [](const Coordinate& coord) {
+		return coord.x >= -1 && coord.x <= 0 && coord.y >= -1 && coord.y <= 0;
+	};
+	int level = MACROCELL_CHUNK_LEVEL;
+	while (!std::all_of(level_node_ids.begin(), level_node_ids.end(), [&](const auto& entry) { return is_root_quadrant(entry.first); })) {
+		boost::unordered_flat_map<Coordinate, std::array<std::uint32_t, 4>> parent_children;
+		for (const auto& [coord, node_id]: level_node_ids) {
+			Coordinate parent = Coordinate(floor_divide(coord.x, 2), floor_divide(coord.y, 2));
+			int quadrant = (coord.x - parent.x * 2) * 2 + (coord.y - parent.y * 2);
+			parent_children[parent][quadrant] = node_id;
+		}
+		level++;
+		level_node_ids.clear();
+		for (const auto& [parent, children]: parent_children) {
+			level_node_ids[parent] = writer.get_node_id(level, children);
+		}
+		if (writer.buffer.size() >= Macrocell_Writer::FLUSH_SIZE) {
+			is_written = writer.flush() && is_written;
+		}
+	}
+
+	std::array<std::uint32_t, 4> root_children = {};
+	for (const auto& [coord, node_id]: level_node_ids) {
+		root_children[(coord.x + 1) * 2 + coord.y + 1] = node_id;
+	}
+	if (writer.get_node_id(level + 1, root_children) == 0) {
+		// an empty grid, Golly expects at least one node.
+		writer.buffer += "$\n";
+	}
+
+	is_written = writer.flush() && is_written;
+	is_written = std::fclose(writer.file) == 0 && is_written;
+	if (!is_written) {
+		error_message = "Could not write " + path;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "profiling.hpp"
+
+#include <string>
+
+class Grid;
+class Pattern_File_Stream;
+
+
+//--------------------------------------------------------------------------------
+// Golly's macrocell format (.mc) stores a pattern as a quadtree in which identical subtrees are shared. Every line after
+// the "[M2]" header is a node, numbered from 1 on, 0 is the empty node of any size:
+// - leaves are 8x8 cells (level 3) written as rows of '.' and '*', each row ends with '$', trailing dead cells and rows
+//   are left out.
+// - all other nodes are "level nw ne sw se", a square of 2^level cells built from four earlier nodes of level - 1.
+// The last node is the root, its center is at (0, 0).
+
+// Expands the quadtree into chunks. Every distinct 32x32 node (one chunk) gets decoded once and copied into each chunk
+// it appears in, so huge patterns built from few distinct tiles load at the speed of memcpy. "#G" sets the iteration.
+bool load_macrocell_pattern(Pattern_File_Stream& stream, Grid& grid, std::string& error_message);
+
+// Writes the grid as a macrocell file. Identical leaves, chunks and higher nodes get hash-consed into a single node, so
+// the file size grows with the number of distinct tiles instead of the number of cells.
+bool save_macrocell_file(const std::string& path, const Grid& grid, std::string& error_message);
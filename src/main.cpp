@@ -1,4 +1,4 @@
-#include <tracy/Tracy.hpp>
+#include "profiling.hpp"
 // General remark for tracy: Set the /Zi compiler flag in visual studio, or otherwise there will be a vs
 // studio bug/feature regarding macro expansions. Otherwise the macros of Tracy, e.g. ZoneScoped, FrameMark wont work.
 
@@ -36,7 +36,7 @@ void set_input_callbacks(GLFWwindow* window) {
 
 //--------------------------------------------------------------------------------
 GLFWwindow* init_glfw_glad_and_create_window(int window_width, int window_height) {
-	ZoneScoped;
+	ZoneScopedFrame;
 	std::cout << "Hello, Sailor!" << std::endl;
 	glfwInit();
 
@@ -168,7 +168,7 @@ void APIENTRY GLDebugMessageCallback(GLenum source, GLenum type, GLuint id,
 */
 //--------------------------------------------------------------------------------
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-	ZoneScoped;
+	ZoneScopedFrame;
 
 	// pass to our state, we check that we are not in debug window
 	if (window == g_state->window) {
@@ -177,7 +177,7 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
 }
 
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
-	ZoneScoped;
+	ZoneScopedFrame;
 
 	// pass to our state, we check that we are not in debug window
 	if (window == g_state->window) {
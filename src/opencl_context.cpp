@@ -92,7 +92,7 @@ void OpenCLContext::initialise_cells_buffer() {
 
 /*
 	void OpenCLContext::update_cells(Array < unsigned int, Chunk::rows, Chunk::columns, Eigen::RowMajor >& neighbour_count, Array < bool, Chunk::rows, Chunk::columns, Eigen::RowMajor >& cells) {
-	ZoneScoped;
+	ZoneScopedFrame;
 	unsigned int* neighbour_count_data = neighbour_count.data();
 	clEnqueueWriteBuffer(command_queue, 
 	neighbour_count_buffer,
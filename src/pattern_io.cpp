@@ -0,0 +1,351 @@
+#include "pattern_io.hpp"
+
+#include "grid.hpp"
+#include "macrocell.hpp"
+#include "snapshot.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+
+
+//--------------------------------------------------------------------------------
+Pattern_File_Stream::Pattern_File_Stream(const std::string& path) :
+	file(nullptr),
+buffer(BUFFER_SIZE),
+position(0),
+size(0),
+line_number(1)
+{
+	ZoneScopedFrame;
+
+	file = std::fopen(path.c_str(), "rb");
+}
+
+Pattern_File_Stream::~Pattern_File_Stream() {
+	ZoneScopedFrame;
+
+	if (file) {
+		std::fclose(file);
+	}
+}
+
+bool Pattern_File_Stream::is_open() const {
+	return file != nullptr;
+}
+
+bool Pattern_File_Stream::refill() {
+	ZoneScopedPhase;
+
+	if (!file) {
+		return false;
+	}
+	size = std::fread(buffer.data(), 1, buffer.size(), file);
+	position = 0;
+	return size > 0;
+}
+
+int Pattern_File_Stream::peek() {
+	if (position >= size && !refill()) {
+		return END_OF_FILE;
+	}
+	return static_cast<unsigned char>(buffer[position]);
+}
+
+int Pattern_File_Stream::next() {
+	int character = peek();
+	if (character != END_OF_FILE) {
+		position++;
+		if (character == '\n') {
+			line_number++;
+		}
+	}
+	return character;
+}
+
+void Pattern_File_Stream::skip_line() {
+	int character = next();
+	while (character != END_OF_FILE && character != '\n') {
+		character = next();
+	}
+}
+
+std::string Pattern_File_Stream::read_line() {
+	std::string line;
+	int character = next();
+	while (character != END_OF_FILE && character != '\n') {
+		if (character != '\r') {
+			line.push_back(static_cast<char>(character));
+		}
+		character = next();
+	}
+	return line;
+}
+
+std::size_t Pattern_File_Stream::get_line_number() const {
+	return line_number;
+}
+
+//--------------------------------------------------------------------------------
+Pattern_File_Format detect_pattern_file_format(const std::string& path) {
+	ZoneScopedFrame;
+
+	if (is_grid_snapshot_file(path)) {
+		return PATTERN_FILE_FORMAT_SNAPSHOT;
+	}
+	Pattern_File_Stream stream(path);
+	if (!stream.is_open()) {
+		return PATTERN_FILE_FORMAT_UNKNOWN;
+	}
+	std::string first_line = stream.read_line();
+	if (first_line.rfind("[M2]", 0) == 0) {
+		return PATTERN_FILE_FORMAT_MACROCELL;
+	}
+	if (first_line.rfind("#Life 1.06", 0) == 0) {
+		return PATTERN_FILE_FORMAT_LIFE_106;
+	}
+	if (first_line.rfind("#Life", 0) == 0) {
+		// eg Life 1.05, which we do not support.
+		return PATTERN_FILE_FORMAT_UNKNOWN;
+	}
+
+	std::string extension = path.substr(std::min(path.size(), path.find_last_of('.')));
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char character) { return static_cast<char>(std::tolower(character)); });
+	if (extension == ".rle") {
+		return PATTERN_FILE_FORMAT_RLE;
+	}
+	if (extension == ".cells") {
+		return PATTERN_FILE_FORMAT_PLAINTEXT;
+	}
+	if (extension == ".mc") {
+		return PATTERN_FILE_FORMAT_MACROCELL;
+	}
+
+	// no known extension, RLE files start with comments followed by the "x = .., y = .." header.
+	std::string line = first_line;
+	while (!line.empty() && line[0] == '#') {
+		line = stream.read_line();
+	}
+	std::size_t first_non_space = line.find_first_not_of(" \t");
+	if (first_non_space != std::string::npos && line[first_non_space] == 'x' && line.find('=') != std::string::npos) {
+		return PATTERN_FILE_FORMAT_RLE;
+	}
+	if (first_line.empty() || first_line[0] == '!' || first_line[0] == '.' || first_line[0] == 'O') {
+		return PATTERN_FILE_FORMAT_PLAINTEXT;
+	}
+	return PATTERN_FILE_FORMAT_UNKNOWN;
+}
+
+bool load_pattern_file(const std::string& path, Grid& grid, std::string& error_message) {
+	ZoneScopedFrame;
+
+	Pattern_File_Format format = detect_pattern_file_format(path);
+	Pattern_File_Stream stream(path);
+	if (!stream.is_open()) {
+		error_message = "Could not open pattern file " + path;
+		return false;
+	}
+
+	bool is_loaded = false;
+	switch (format) {
+		case PATTERN_FILE_FORMAT_RLE:
+			is_loaded = load_rle_pattern(stream, grid, error_message);
+			break;
+		case PATTERN_FILE_FORMAT_PLAINTEXT:
+			is_loaded = load_plaintext_pattern(stream, grid, error_message);
+			break;
+		case PATTERN_FILE_FORMAT_LIFE_106:
+			is_loaded = load_life_106_pattern(stream, grid, error_message);
+			break;
+		case PATTERN_FILE_FORMAT_MACROCELL:
+			is_loaded = load_macrocell_pattern(stream, grid, error_message);
+			break;
+		case PATTERN_FILE_FORMAT_SNAPSHOT:
+			is_loaded = load_grid_snapshot(path, grid, error_message);
+			break;
+		default:
+			error_message = "Unknown pattern file format of " + path + ", supported are RLE, plaintext (.cells), Life 1.06 and macrocell (.mc)";
+			break;
+	}
+	if (!is_loaded) {
+		error_message = path + ": " + error_message;
+	}
+	grid.finish_pattern_creation();
+	return is_loaded;
+}
+
+//--------------------------------------------------------------------------------
+// Golly style RLE: '#' comment lines, the "x = width, y = height, rule = B3/S23" header and then runs of
+// [count]tag, where the tag is 'b' for dead cells, 'o' for alive cells, '$' for the end of a row and '!' for the end of
+// the pattern. Multi state letters are treated as alive.
+bool load_rle_pattern(Pattern_File_Stream& stream, Grid& grid, std::string& error_message) {
+	ZoneScopedPhase;
+
+	constexpr static long long MAXIMUM_RUN_COUNT = 1 << 30;
+
+	// comments and the header.
+	while (stream.peek() == '#' || stream.peek() == '\n' || stream.peek() == '\r') {
+		stream.skip_line();
+	}
+	std::string header = stream.read_line();
+	std::size_t first_non_space = header.find_first_not_of(" \t");
+	if (first_non_space == std::string::npos || header[first_non_space] != 'x') {
+		error_message = "missing RLE header line \"x = .., y = ..\"";
+		return false;
+	}
+	std::size_t rule_position = header.find("rule");
+	if (rule_position != std::string::npos) {
+		std::string rule = header.substr(header.find('=', rule_position) + 1);
+		rule.erase(std::remove_if(rule.begin(), rule.end(), [](unsigned char character) { return std::isspace(character); }), rule.end());
+		std::transform(rule.begin(), rule.end(), rule.begin(), [](unsigned char character) { return static_cast<char>(std::toupper(character)); });
+		if (rule != "B3/S23" && rule != "23/3") {
+			error_message = "unsupported rule " + rule + ", only B3/S23 is supported";
+			return false;
+		}
+	}
+
+	// the runs add up in long long and the cells have to stay within the range of the other loaders, so that the
+	// coordinates of the neighbour chunks cannot overflow.
+	long long row = 0;
+	long long column = 0;
+	long long run_count = 0;
+	int character = stream.next();
+	while (character != Pattern_File_Stream::END_OF_FILE && character != '!') {
+		if (character >= '0' && character <= '9') {
+			run_count = run_count * 10 + (character - '0');
+			if (run_count > MAXIMUM_RUN_COUNT) {
+				error_message = "run count too big in line " + std::to_string(stream.get_line_number());
+				return false;
+			}
+			character = stream.next();
+			continue;
+		}
+		if (std::isspace(character)) {
+			character = stream.next();
+			continue;
+		}
+		long long length = std::max(1ll, run_count);
+		run_count = 0;
+		if (character == 'b' || character == '.') {
+			column += length;
+		} else if (character == 'o' || (character >= 'A' && character <= 'X')) {
+			if (row > INT32_MAX / 2 || column + length - 1 > INT32_MAX / 2) {
+				error_message = "coordinate out of range in line " + std::to_string(stream.get_line_number());
+				return false;
+			}
+			grid.set_alive_cell_run(static_cast<int>(row), static_cast<int>(column), static_cast<int>(length));
+			column += length;
+		} else if (character == '$') {
+			row += length;
+			column = 0;
+		} else {
+			error_message = std::string("unexpected character '") + static_cast<char>(character) + "' in line " + std::to_string(stream.get_line_number());
+			return false;
+		}
+		// no cell could be placed that far out, stop before endless dead runs overflow the long longs.
+		if (row > INT32_MAX || column > INT32_MAX) {
+			error_message = "coordinate out of range in line " + std::to_string(stream.get_line_number());
+			return false;
+		}
+		character = stream.next();
+	}
+	return true;
+}
+
+// '!' comment lines, then one line per row with 'O' (or '*') for alive and '.' for dead cells.
+bool load_plaintext_pattern(Pattern_File_Stream& stream, Grid& grid, std::string& error_message) {
+	ZoneScopedPhase;
+
+	int row = 0;
+	int column = 0;
+	int run_start_column = 0;
+	int run_length = 0;
+	bool is_comment_line = stream.peek() == '!';
+	int character = stream.next();
+	while (character != Pattern_File_Stream::END_OF_FILE) {
+		if (is_comment_line) {
+			if (character == '\n') {
+				is_comment_line = stream.peek() == '!';
+			}
+		} else if (character == 'O' || character == '*') {
+			if (run_length == 0) {
+				run_start_column = column;
+			}
+			run_length++;
+			column++;
+		} else {
+			if (run_length > 0) {
+				grid.set_alive_cell_run(row, run_start_column, run_length);
+				run_length = 0;
+			}
+			if (character == '.') {
+				column++;
+			} else if (character == '\n') {
+				row++;
+				column = 0;
+				is_comment_line = stream.peek() == '!';
+			} else if (character != '\r' && character != ' ' && character != '\t') {
+				error_message = std::string("unexpected character '") + static_cast<char>(character) + "' in line " + std::to_string(stream.get_line_number());
+				return false;
+			}
+		}
+		// same range as the other loaders, so that the coordinates of the neighbour chunks cannot overflow. Checked after
+		// every step, the counters never get past the limit by more than one.
+		if (row > INT32_MAX / 2 || column > INT32_MAX / 2) {
+			error_message = "coordinate out of range in line " + std::to_string(stream.get_line_number());
+			return false;
+		}
+		character = stream.next();
+	}
+	if (run_length > 0) {
+		grid.set_alive_cell_run(row, run_start_column, run_length);
+	}
+	return true;
+}
+
+// "#Life 1.06" followed by one "x y" pair per alive cell, x is the column and y the row.
+bool load_life_106_pattern(Pattern_File_Stream& stream, Grid& grid, std::string& error_message) {
+	ZoneScopedPhase;
+
+	// reads an optionally signed integer and skips the spaces before it, returns false if there is none.
+	auto read_integer = [&stream](long long& value) {
+		while (stream.peek() == ' ' || stream.peek() == '\t') {
+			stream.next();
+		}
+		bool is_negative = false;
+		if (stream.peek() == '-' || stream.peek() == '+') {
+			is_negative = stream.next() == '-';
+		}
+		if (stream.peek() < '0' || stream.peek() > '9') {
+			return false;
+		}
+		value = 0;
+		while (stream.peek() >= '0' && stream.peek() <= '9' && value < (1ll << 40)) {
+			value = value * 10 + (stream.next() - '0');
+		}
+		value = is_negative ? -value : value;
+		return true;
+	};
+
+	while (stream.peek() != Pattern_File_Stream::END_OF_FILE) {
+		int character = stream.peek();
+		if (character == '#' || character == '\n' || character == '\r') {
+			stream.skip_line();
+			continue;
+		}
+		long long x = 0;
+		long long y = 0;
+		std::size_t line_number = stream.get_line_number();
+		if (!read_integer(x) || !read_integer(y)) {
+			error_message = "expected \"x y\" in line " + std::to_string(line_number);
+			return false;
+		}
+		if (x < INT32_MIN / 2 || x > INT32_MAX / 2 || y < INT32_MIN / 2 || y > INT32_MAX / 2) {
+			error_message = "coordinate out of range in line " + std::to_string(line_number);
+			return false;
+		}
+		grid.set_cell_alive(static_cast<int>(y), static_cast<int>(x));
+		stream.skip_line();
+	}
+	return true;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "profiling.hpp"
+
+#include <string>
+#include <vector>
+#include <cstdio>
+
+class Grid;
+
+
+//--------------------------------------------------------------------------------
+enum Pattern_File_Format {
+	PATTERN_FILE_FORMAT_UNKNOWN,
+	PATTERN_FILE_FORMAT_RLE,
+	PATTERN_FILE_FORMAT_PLAINTEXT,
+	PATTERN_FILE_FORMAT_LIFE_106,
+	PATTERN_FILE_FORMAT_MACROCELL,
+	PATTERN_FILE_FORMAT_SNAPSHOT
+};
+
+//--------------------------------------------------------------------------------
+// Reads a file byte by byte through a fixed size buffer, so that the parsers never hold more than a buffer of the file
+// in memory, no matter how big the pattern is.
+class Pattern_File_Stream {
+public:
+	constexpr static int END_OF_FILE = -1;
+	constexpr static std::size_t BUFFER_SIZE = 1 << 20;
+
+	explicit Pattern_File_Stream(const std::string& path);
+
+	~Pattern_File_Stream();
+
+	Pattern_File_Stream(const Pattern_File_Stream&) = delete;
+
+	Pattern_File_Stream& operator = (const Pattern_File_Stream&) = delete;
+
+	bool is_open() const;
+
+	// returns the next byte, or END_OF_FILE.
+	int next();
+
+	// returns the next byte without consuming it, or END_OF_FILE.
+	int peek();
+
+	// consumes everything up to and including the next line break.
+	void skip_line();
+
+	// consumes and returns the rest of the current line, without the line break.
+	std::string read_line();
+
+	// 1 based number of the line the next byte belongs to, for error messages.
+	std::size_t get_line_number() const;
+
+private:
+	bool refill();
+	//--------------------------------------------------------------------------------
+	// data
+	std::FILE* file;
+	std::vector<char> buffer;
+	std::size_t position;
+	std::size_t size;
+	std::size_t line_number;
+};
+
+//--------------------------------------------------------------------------------
+// Guesses the format from the first line of the file and falls back to the file extension (.rle, .cells, .mc).
+Pattern_File_Format detect_pattern_file_format(const std::string& path);
+
+// Loads the pattern into grid, which should be empty. RLE and plaintext patterns get their top left corner at (0, 0),
+// Life 1.06 cells keep their absolute coordinates and macrocell patterns get centered around (0, 0). Snapshots (see
+// snapshot.hpp) restore the chunks and the iteration they were saved with. Returns false and sets error_message if the file can not be read or
+// is malformed, grid then contains everything up to the error.
+bool load_pattern_file(const std::string& path, Grid& grid, std::string& error_message);
+
+bool load_rle_pattern(Pattern_File_Stream& stream, Grid& grid, std::string& error_message);
+
+bool load_plaintext_pattern(Pattern_File_Stream& stream, Grid& grid, std::string& error_message);
+
+bool load_life_106_pattern(Pattern_File_Stream& stream, Grid& grid, std::string& error_message);
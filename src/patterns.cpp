@@ -0,0 +1,65 @@
+#include "patterns.hpp"
+
+std::vector<std::string> get_pattern_names() {
+	return { "r-pentomino", "acorn", "diehard", "glider", "gosper-gun" };
+}
+
+std::vector<std::string> get_plaintext_pattern(const std::string& name) {
+	if (name == "r-pentomino") {
+		return {
+			".OO",
+			"OO.",
+			".O."
+		};
+	}
+	if (name == "acorn") {
+		return {
+			".O.....",
+			"...O...",
+			"OO..OOO"
+		};
+	}
+	if (name == "diehard") {
+		return {
+			"......O.",
+			"OO......",
+			".O...OOO"
+		};
+	}
+	if (name == "glider") {
+		return {
+			".O.",
+			"..O",
+			"OOO"
+		};
+	}
+	if (name == "gosper-gun") {
+		return {
+			"........................O...........",
+			"......................O.O...........",
+			"............OO......OO............OO",
+			"...........O...O....OO............OO",
+			"OO........O.....O...OO..............",
+			"OO........O...O.OO....O.O...........",
+			"..........O.....O.......O...........",
+			"...........O...O....................",
+			"............OO......................"
+		};
+	}
+	return {};
+}
+
+std::vector<std::pair<int, int>> get_pattern_cells(const std::string& name) {
+	ZoneScopedFrame;
+
+	std::vector<std::pair<int, int>> cells;
+	std::vector<std::string> pattern = get_plaintext_pattern(name);
+	for (int r = 0; r < (int) pattern.size(); r++) {
+		for (int c = 0; c < (int) pattern[r].size(); c++) {
+			if (pattern[r][c] == 'O') {
+				cells.push_back(std::make_pair(r, c));
+			}
+		}
+	}
+	return cells;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "profiling.hpp"
+
+#include <string>
+#include <vector>
+#include <utility>
+
+
+//--------------------------------------------------------------------------------
+// A few small, well known patterns which the benchmark, the verification and the headless runner can refer to by name.
+// They are stored in the plaintext format, ie one string per row with 'O' for alive and '.' for dead cells.
+std::vector<std::string> get_pattern_names();
+
+// returns an empty pattern for unknown names.
+std::vector<std::string> get_plaintext_pattern(const std::string& name);
+
+// returns the (row, column) coordinates of the alive cells of the pattern, with its top left corner at (0, 0).
+std::vector<std::pair<int, int>> get_pattern_cells(const std::string& name);
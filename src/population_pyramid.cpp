@@ -0,0 +1,68 @@
+#include "population_pyramid.hpp"
+
+
+//--------------------------------------------------------------------------------
+Population_Pyramid::Population_Pyramid() :
+	chunk_populations({}),
+superchunk_populations({}),
+update_counter(0)
+{
+
+}
+
+void Population_Pyramid::begin_update() {
+	update_counter++;
+}
+
+void Population_Pyramid::set_chunk_population(const Coordinate& chunk_index, std::int64_t population) {
+	Chunk_Population& chunk_population = chunk_populations[chunk_index];
+	chunk_population.last_update = update_counter;
+	std::int64_t delta = population - chunk_population.population;
+	if (delta == 0) {
+		return;
+	}
+	chunk_population.population = population;
+	add_to_superchunks(chunk_index, delta);
+}
+
+void Population_Pyramid::end_update() {
+	ZoneScopedFrame;
+
+	boost::unordered::erase_if(chunk_populations, [this](const auto& entry) {
+		if (entry.second.last_update == update_counter) {
+			return false;
+		}
+		add_to_superchunks(entry.first, -entry.second.population);
+		return true;
+	});
+}
+
+std::int64_t Population_Pyramid::get_population(int level, const Coordinate& node) const {
+	if (level == 0) {
+		auto it = chunk_populations.find(node);
+		return it != chunk_populations.end() ? it->second.population : 0;
+	}
+	auto it = superchunk_populations[level].find(node);
+	return it != superchunk_populations[level].end() ? it->second : 0;
+}
+
+Coordinate Population_Pyramid::get_node(int level, const Coordinate& chunk_index) {
+	return Coordinate(floor_divide(chunk_index.x, 1 << level), floor_divide(chunk_index.y, 1 << level));
+}
+
+std::size_t Population_Pyramid::get_number_of_nodes(int level) const {
+	return level == 0 ? chunk_populations.size() : superchunk_populations[level].size();
+}
+
+//--------------------------------------------------------------------------------
+void Population_Pyramid::add_to_superchunks(const Coordinate& chunk_index, std::int64_t delta) {
+	for (int level = 1; level < NUMBER_OF_LEVELS; level++) {
+		Coordinate node = get_node(level, chunk_index);
+		std::int64_t& population = superchunk_populations[level][node];
+		population += delta;
+		// the nodes of the empty parts of the universe are not kept around.
+		if (population == 0) {
+			superchunk_populations[level].erase(node);
+		}
+	}
+}
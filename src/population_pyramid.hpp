@@ -0,0 +1,52 @@
+#pragma once
+
+#include "profiling.hpp"
+#include "coordinate.hpp"
+
+#include <array>
+#include <cstdint>
+
+#include <boost/unordered/unordered_flat_map.hpp>
+
+
+//--------------------------------------------------------------------------------
+// The number of alive cells per chunk and per superchunk of 2x2, 4x4 ... chunks, for drawing zoomed out patterns as
+// density shaded quads. Level L groups 2^L x 2^L chunks, the node of the chunk with index (row, column), ie the chunk
+// at origin (row * Chunk::rows, column * Chunk::columns), is (floor(row / 2^L), floor(column / 2^L)). Only the chunks
+// whose population changed since the last update touch the levels above.
+class Population_Pyramid {
+public:
+	constexpr static int NUMBER_OF_LEVELS = 11;
+
+	Population_Pyramid();
+
+	// every chunk which is not passed to set_chunk_population() before end_update() counts as empty afterwards.
+	void begin_update();
+
+	void set_chunk_population(const Coordinate& chunk_index, std::int64_t population);
+
+	void end_update();
+
+	// 0 for nodes without alive cells.
+	std::int64_t get_population(int level, const Coordinate& node) const;
+
+	static Coordinate get_node(int level, const Coordinate& chunk_index);
+
+	// the number of nodes of the level with alive cells.
+	std::size_t get_number_of_nodes(int level) const;
+
+private:
+	struct Chunk_Population {
+		std::int64_t population = 0;
+		std::uint64_t last_update = 0;
+	};
+
+	// adds delta to the nodes of the chunk on all levels above the chunks.
+	void add_to_superchunks(const Coordinate& chunk_index, std::int64_t delta);
+	//--------------------------------------------------------------------------------
+	// data
+	boost::unordered_flat_map<Coordinate, Chunk_Population> chunk_populations;
+	// levels 1 to NUMBER_OF_LEVELS - 1, level 0 are the chunk populations.
+	std::array<boost::unordered_flat_map<Coordinate, std::int64_t>, NUMBER_OF_LEVELS> superchunk_populations;
+	std::uint64_t update_counter;
+};
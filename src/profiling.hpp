@@ -0,0 +1,49 @@
+#pragma once
+
+//--------------------------------------------------------------------------------
+#include <tracy/Tracy.hpp>
+
+// Tiered Tracy instrumentation. Every zone belongs to one of the levels below and only zones up to
+// GRID_OF_LIFE_PROFILING_LEVEL get compiled in, everything above expands to nothing. The level gets set by CMake via
+// the GRID_OF_LIFE_PROFILING_LEVEL cache variable.
+//
+// FRAME: once per rendered frame (rendering, ui, input, grid manager).
+// PHASE: once per grid iteration (the phases of Grid::next_iteration).
+// CHUNK: once per chunk and iteration (chunk kernels, chunk creation).
+// CELL:  small helpers which run per cell or per lookup (Coordinate, hashing).
+//
+// The chunk and cell levels run millions of times per second, with them compiled in the profiler overhead dominates
+// the small kernels, so only enable them explicitly for fine-grained profiling.
+#define GRID_OF_LIFE_PROFILING_LEVEL_NONE 0
+#define GRID_OF_LIFE_PROFILING_LEVEL_FRAME 1
+#define GRID_OF_LIFE_PROFILING_LEVEL_PHASE 2
+#define GRID_OF_LIFE_PROFILING_LEVEL_CHUNK 3
+#define GRID_OF_LIFE_PROFILING_LEVEL_CELL 4
+
+#ifndef GRID_OF_LIFE_PROFILING_LEVEL
+#define GRID_OF_LIFE_PROFILING_LEVEL GRID_OF_LIFE_PROFILING_LEVEL_PHASE
+#endif
+
+#if GRID_OF_LIFE_PROFILING_LEVEL >= GRID_OF_LIFE_PROFILING_LEVEL_FRAME
+#define ZoneScopedFrame ZoneScoped
+#else
+#define ZoneScopedFrame
+#endif
+
+#if GRID_OF_LIFE_PROFILING_LEVEL >= GRID_OF_LIFE_PROFILING_LEVEL_PHASE
+#define ZoneScopedPhase ZoneScoped
+#else
+#define ZoneScopedPhase
+#endif
+
+#if GRID_OF_LIFE_PROFILING_LEVEL >= GRID_OF_LIFE_PROFILING_LEVEL_CHUNK
+#define ZoneScopedChunk ZoneScoped
+#else
+#define ZoneScopedChunk
+#endif
+
+#if GRID_OF_LIFE_PROFILING_LEVEL >= GRID_OF_LIFE_PROFILING_LEVEL_CELL
+#define ZoneScopedCell ZoneScoped
+#else
+#define ZoneScopedCell
+#endif
@@ -5,7 +5,7 @@
 
 //--------------------------------------------------------------------------------
 std::string read_from_file_into_std_string(const std::string& full_path) {
-	ZoneScoped;
+	ZoneScopedFrame;
 	std::ifstream t(full_path);
 	std::stringstream buffer;
 	buffer << t.rdbuf();
@@ -15,13 +15,13 @@ std::string read_from_file_into_std_string(const std::string& full_path) {
 
 //--------------------------------------------------------------------------------
 unsigned char* load_image_from_file(const std::string& full_path, int* width, int* height, int* number_of_channels) {
-	ZoneScoped;
+	ZoneScopedFrame;
 	//stbi_set_flip_vertically_on_load(true);
 	return stbi_load(full_path.c_str(), width, height, number_of_channels, 0);
 }
 
 //--------------------------------------------------------------------------------
 void free_image_data(unsigned char* data) {
-	ZoneScoped;
+	ZoneScopedFrame;
 	stbi_image_free(data);
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
 #pragma once
 
 //--------------------------------------------------------------------------------
-#include <tracy/Tracy.hpp>
+#include "profiling.hpp"
 
 #include <string>
 #include <fstream>
@@ -0,0 +1,79 @@
+#include "reference_grid.hpp"
+#include "checksum.hpp"
+
+#include <algorithm>
+
+#include <boost/unordered/unordered_flat_map.hpp>
+
+Reference_Grid::Reference_Grid() :
+	iteration(0),
+alive_cells({})
+{
+	ZoneScopedPhase;
+}
+
+std::uint64_t Reference_Grid::get_key(int row, int column) {
+	return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(row)) << 32) | static_cast<std::uint32_t>(column);
+}
+
+std::pair<int, int> Reference_Grid::get_cell(std::uint64_t key) {
+	int row = static_cast<int>(static_cast<std::uint32_t>(key >> 32));
+	int column = static_cast<int>(static_cast<std::uint32_t>(key));
+	return std::make_pair(row, column);
+}
+
+void Reference_Grid::set_cell_alive(int row, int column) {
+	ZoneScopedCell;
+
+	alive_cells.insert(get_key(row, column));
+}
+
+void Reference_Grid::next_iteration() {
+	ZoneScopedPhase;
+
+	// every alive cell adds one to the neighbour count of its 8 neighbours.
+	boost::unordered_flat_map<std::uint64_t, int> neighbour_counts;
+	neighbour_counts.reserve(alive_cells.size() * 8);
+	for (std::uint64_t key: alive_cells) {
+		auto [row, column] = get_cell(key);
+		for (int dr = -1; dr <= 1; dr++) {
+			for (int dc = -1; dc <= 1; dc++) {
+				if (dr != 0 || dc != 0) {
+					neighbour_counts[get_key(row + dr, column + dc)]++;
+				}
+			}
+		}
+	}
+
+	boost::unordered_flat_set<std::uint64_t> next_alive_cells;
+	for (auto [key, neighbour_count]: neighbour_counts) {
+		if (neighbour_count == 3 || (neighbour_count == 2 && alive_cells.contains(key))) {
+			next_alive_cells.insert(key);
+		}
+	}
+	alive_cells = std::move(next_alive_cells);
+	iteration++;
+}
+
+std::vector<std::pair<int, int>> Reference_Grid::get_alive_cells() const {
+	ZoneScopedPhase;
+
+	std::vector<std::pair<int, int>> cells;
+	cells.reserve(alive_cells.size());
+	for (std::uint64_t key: alive_cells) {
+		cells.push_back(get_cell(key));
+	}
+	std::sort(cells.begin(), cells.end());
+	return cells;
+}
+
+std::uint64_t Reference_Grid::compute_checksum() const {
+	ZoneScopedPhase;
+
+	std::uint64_t checksum = 0;
+	for (std::uint64_t key: alive_cells) {
+		auto [row, column] = get_cell(key);
+		checksum += get_alive_cell_hash(row, column);
+	}
+	return checksum;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "profiling.hpp"
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+#include <boost/unordered/unordered_flat_set.hpp>
+
+
+//--------------------------------------------------------------------------------
+// A deliberately simple scalar implementation of the game of life on a sparse set of alive cells. It shares no code
+// with the chunk kernels, so the verification harness can use it as the ground truth for Grid.
+class Reference_Grid {
+public:
+	Reference_Grid();
+
+	void set_cell_alive(int row, int column);
+
+	void next_iteration();
+
+	// returns the (row, column) coordinates of all alive cells, sorted, ie in the same format as Grid::get_alive_cells().
+	std::vector<std::pair<int, int>> get_alive_cells() const;
+
+	// same order independent hash as Grid::compute_checksum().
+	std::uint64_t compute_checksum() const;
+
+	static std::uint64_t get_key(int row, int column);
+
+	static std::pair<int, int> get_cell(std::uint64_t key);
+	//--------------------------------------------------------------------------------
+	// data
+	std::size_t iteration;
+
+	boost::unordered_flat_set<std::uint64_t> alive_cells;
+};
@@ -5,16 +5,24 @@ Renderer::Renderer() :
 	m_window(nullptr),
 grid_cubes_VAO(0),
 grid_cubes_VBO(0),
-cubes_instances_VBO(0),
+chunk_instance_slots(nullptr),
+border_instance_buffer(nullptr),
+chunk_bitmap_buffer(nullptr),
+chunk_bitmap_texture_unit(0),
 texture_catalog(nullptr),
-m_shader_program(nullptr)
+m_shader_program(nullptr),
+level_of_detail_quads_VAO(0),
+level_of_detail_quads_VBO(0),
+number_of_level_of_detail_quads(0),
+level_of_detail_quads_version(0),
+m_level_of_detail_shader_program(nullptr)
 {
 
 }
 
 //--------------------------------------------------------------------------------
 void Renderer::initialise(GLFWwindow* window) {
-	ZoneScoped;
+	ZoneScopedFrame;
 	m_window = window;
 	
 	int window_width, window_height;
@@ -25,7 +33,12 @@ void Renderer::initialise(GLFWwindow* window) {
 
 	glGenVertexArrays(1, &grid_cubes_VAO);
 	glGenBuffers(1, &grid_cubes_VBO);
-	glGenBuffers(1, &cubes_instances_VBO);
+	chunk_instance_slots = std::make_unique < Chunk_Instance_Slots > ();
+	chunk_instance_slots->initialise(36);
+	border_instance_buffer = std::make_unique < Instance_Stream_Buffer > ();
+	border_instance_buffer->initialise();
+	chunk_bitmap_buffer = std::make_unique < Chunk_Bitmap_Buffer > ();
+	chunk_bitmap_buffer->initialise();
 
 	m_shader_program = std::make_unique < Shader_Program > (m_vertex_shader_path, m_fragment_shader_path);
 	m_shader_program->link_and_cleanup();
@@ -40,21 +53,29 @@ void Renderer::initialise(GLFWwindow* window) {
 
 	m_shader_program->load_texture_catalog(*texture_catalog);
 
+	// the texture unit after the ones of the catalog.
+	chunk_bitmap_texture_unit = static_cast<GLuint>(texture_catalog->textures.size());
+	m_shader_program->use();
+	m_shader_program->set_uniform_int("chunk_bitmaps", static_cast<int>(chunk_bitmap_texture_unit));
+	m_shader_program->set_uniform_int("should_expand_chunk_bitmaps", 0);
+
 
 	initialise_cube_rendering();
+
+	initialise_level_of_detail_rendering();
 }
 
 	
 //--------------------------------------------------------------------------------
 void Renderer::update_shader_program(glm::mat4 model, glm::mat4 view, glm::mat4 projection) {
-	ZoneScoped;
+	ZoneScopedFrame;
 	m_shader_program->set_uniform_mat4("model", model);
 	m_shader_program->set_uniform_mat4("view", view);
 	m_shader_program->set_uniform_mat4("projection", projection);
 }
 
 void Renderer::render_frame(std::shared_ptr<World> world, std::shared_ptr<Cube_System> cube_system) {
-	ZoneScoped;
+	ZoneScopedFrame;
 
 	// world
 	render_world(world, cube_system);
@@ -66,13 +87,13 @@ void Renderer::render_frame(std::shared_ptr<World> world, std::shared_ptr<Cube_S
 }
 
 void Renderer::swap_backbuffer() {
-	ZoneScoped; 
+	ZoneScopedFrame; 
 
 	glfwSwapBuffers(m_window);
 }
 
 void Renderer::render_ui() {
-	ZoneScoped;
+	ZoneScopedFrame;
 	// Render imgui frame
 	// The imgui frame gets started in the ui_state->update() call. This call HAS to happen before this!
 	
@@ -82,7 +103,7 @@ void Renderer::render_ui() {
 
 //--------------------------------------------------------------------------------
 void Renderer::initialise_cube_rendering() {
-	ZoneScoped;
+	ZoneScopedFrame;
 	const float vertices[] = {
 		-0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
 		0.5f, -0.5f, -0.5f,  1.0f, 0.0f,
@@ -139,10 +160,9 @@ void Renderer::initialise_cube_rendering() {
 	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE,  5 * sizeof(float), (void*)(3 * sizeof(float)));
 	glEnableVertexAttribArray(1);
 
-	// define buffer which holds the 4x4 mvp matrices of each rendered grid cube. Have to send each individual matrix row as a vec4 of floats.
-	glBindBuffer(GL_ARRAY_BUFFER, cubes_instances_VBO);
+	// the translation of each rendered grid cube, every draw points the attribute at its own instance buffer.
 	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *) 0);
+	border_instance_buffer->set_instance_attribute_pointer(2);
 
 	glVertexAttribDivisor(2, 1);
 
@@ -153,41 +173,101 @@ void Renderer::initialise_cube_rendering() {
 
 
 
+void Renderer::initialise_level_of_detail_rendering() {
+	ZoneScopedFrame;
+
+	m_level_of_detail_shader_program = std::make_unique < Shader_Program > (m_level_of_detail_vertex_shader_path, m_level_of_detail_fragment_shader_path);
+	m_level_of_detail_shader_program->link_and_cleanup();
+
+	glGenVertexArrays(1, &level_of_detail_quads_VAO);
+	glGenBuffers(1, &level_of_detail_quads_VBO);
+
+	// one quad per instance, its corners come from gl_VertexID.
+	glBindVertexArray(level_of_detail_quads_VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, level_of_detail_quads_VBO);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribDivisor(0, 1);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+void Renderer::render_level_of_detail_quads(std::shared_ptr<Cube_System> cube_system) {
+	ZoneScopedFrame;
+
+	if (cube_system->level_of_detail_quads_version != level_of_detail_quads_version) {
+		// there is one quad per node and not per cell, so even re-uploading all of them is cheap.
+		const std::vector<glm::vec4>& quads = cube_system->level_of_detail_quads;
+		glBindBuffer(GL_ARRAY_BUFFER, level_of_detail_quads_VBO);
+		glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(quads.size() * sizeof(glm::vec4)), quads.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		number_of_level_of_detail_quads = quads.size();
+		level_of_detail_quads_version = cube_system->level_of_detail_quads_version;
+	}
+	if (number_of_level_of_detail_quads == 0) {
+		return;
+	}
+
+	glBindVertexArray(level_of_detail_quads_VAO);
+	m_level_of_detail_shader_program->use();
+	glDrawArraysInstanced(GL_TRIANGLES, 0, 6, static_cast<GLsizei>(number_of_level_of_detail_quads));
+	glBindVertexArray(0);
+}
+
 void Renderer::render_grid(std::shared_ptr<Cube_System> cube_system) {
-	ZoneScoped;
+	ZoneScopedFrame;
 
 	glBindVertexArray(grid_cubes_VAO);
 	m_shader_program->use();
 
-	// send the mvp matrices to the corresponding buffer
-	std::size_t number_of_cubes = cube_system->number_of_translation_data;
-	std::size_t data_size = sizeof(glm::vec3) * number_of_cubes;
-	const void * data = reinterpret_cast<const void *>(cube_system->cubes_translation_data.data());
-	glBindBuffer(GL_ARRAY_BUFFER, cubes_instances_VBO);
-	glBufferData(GL_ARRAY_BUFFER, data_size, data, GL_STREAM_DRAW);
-
-	// draw all cubes.
-	glDrawArraysInstanced(GL_TRIANGLES, 0, 36, static_cast<GLsizei>(number_of_cubes));
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	// the Cube_System already brought the chunk slots (or bitmaps) and the chunk borders up to date.
+	if (cube_system->is_expanding_cells_on_gpu) {
+		// the vertex shader takes the translations out of the bitmaps, so the instance attribute must not be read.
+		std::size_t number_of_potential_cells = chunk_bitmap_buffer->get_number_of_chunks() * Chunk_Bitmap_Buffer::CELLS_PER_CHUNK;
+		chunk_bitmap_buffer->bind(chunk_bitmap_texture_unit);
+		glDisableVertexAttribArray(2);
+		m_shader_program->set_uniform_int("should_expand_chunk_bitmaps", 1);
+		glDrawArraysInstanced(GL_TRIANGLES, 0, 36, static_cast<GLsizei>(number_of_potential_cells));
+		m_shader_program->set_uniform_int("should_expand_chunk_bitmaps", 0);
+		glEnableVertexAttribArray(2);
+	}
+	else {
+		chunk_instance_slots->draw(2);
+	}
+
+	std::size_t number_of_border_cubes = border_instance_buffer->get_number_of_instances();
+	if (number_of_border_cubes > 0) {
+		border_instance_buffer->set_instance_attribute_pointer(2);
+		glDrawArraysInstanced(GL_TRIANGLES, 0, 36, static_cast<GLsizei>(number_of_border_cubes));
+		border_instance_buffer->fence_draws();
+	}
 	
 	glBindVertexArray(0);
 }
 
-void Renderer::set_projection_view_matrix_in_shader(std::shared_ptr<World> world) {
+glm::mat4 Renderer::get_projection_view_matrix(std::shared_ptr<World> world) {
 	int window_width, window_height;
 	glfwGetWindowSize(world->m_window, &window_width, &window_height);
 	glm::mat4 view_matrix = world->m_camera->get_view_matrix();
 	glm::mat4 projection_matrix = world->m_camera->get_projection_matrix(window_width, window_height);
-	glm::mat4 projection_view_matrix = projection_matrix * view_matrix;
+	return projection_matrix * view_matrix;
+}
+
+void Renderer::set_projection_view_matrix_in_shader(std::shared_ptr<World> world) {
+	glm::mat4 projection_view_matrix = get_projection_view_matrix(world);
 	
 	m_shader_program->use();
 	unsigned int projection_view_matrix_location = glGetUniformLocation(m_shader_program->id, "projection_view");
 	glUniformMatrix4fv(projection_view_matrix_location, 1, GL_FALSE, glm::value_ptr(projection_view_matrix));
+
+	m_level_of_detail_shader_program->use();
+	m_level_of_detail_shader_program->set_uniform_mat4("projection_view", projection_view_matrix);
 }
 
 //--------------------------------------------------------------------------------
 void Renderer::render_world(std::shared_ptr<World> world, std::shared_ptr<Cube_System> cube_system) {
-	ZoneScoped;
+	ZoneScopedFrame;
 
 	glClearColor(0.0f, 25.0f / 255.0f, 51.0f / 255.0f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -195,4 +275,6 @@ void Renderer::render_world(std::shared_ptr<World> world, std::shared_ptr<Cube_S
 	set_projection_view_matrix_in_shader(world);
 
 	render_grid(cube_system);
+
+	render_level_of_detail_quads(cube_system);
 }
\ No newline at end of file
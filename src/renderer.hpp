@@ -1,7 +1,7 @@
 #pragma once
 
 //--------------------------------------------------------------------------------
-#include <tracy/Tracy.hpp>
+#include "profiling.hpp"
 #include "opengl.hpp"
 
 #include <vector>
@@ -23,10 +23,17 @@ public:
 
 	void render_grid(std::shared_ptr<Cube_System> cube_system);
 
+	// draws the density quads of the zoomed out chunks, uploads them first if they changed.
+	void render_level_of_detail_quads(std::shared_ptr<Cube_System> cube_system);
+
 	void initialise(GLFWwindow* window);
 
 	void initialise_cube_rendering();
 
+	void initialise_level_of_detail_rendering();
+
+	glm::mat4 get_projection_view_matrix(std::shared_ptr<World> world);
+
 	void set_projection_view_matrix_in_shader(std::shared_ptr<World> world);
 
 	std::vector<glm::mat4> compute_cube_mvp_data(std::shared_ptr<Cube_System> cube_system, glm::mat4 projection_view_matrix);
@@ -45,11 +52,25 @@ public:
 	GLuint grid_cubes_VAO;
 	GLuint grid_cubes_VBO;
 
-	GLuint cubes_instances_VBO;
+	// the alive cells stay in their chunk slots until the chunk changes, the chunk borders get streamed.
+	std::unique_ptr<Chunk_Instance_Slots> chunk_instance_slots;
+	std::unique_ptr<Instance_Stream_Buffer> border_instance_buffer;
+	// the packed chunks, when the vertex shader expands the cells.
+	std::unique_ptr<Chunk_Bitmap_Buffer> chunk_bitmap_buffer;
+	GLuint chunk_bitmap_texture_unit;
 
 	std::unique_ptr<Texture_Catalog> texture_catalog;
 
 	std::unique_ptr<Shader_Program> m_shader_program;
 	const std::string m_vertex_shader_path = "shaders/shader.vertex_shader";
 	const std::string m_fragment_shader_path = "shaders/shader.fragment_shader";
+
+	GLuint level_of_detail_quads_VAO;
+	GLuint level_of_detail_quads_VBO;
+	std::size_t number_of_level_of_detail_quads;
+	// of the quads in level_of_detail_quads_VBO, see Cube_System::level_of_detail_quads_version.
+	std::uint64_t level_of_detail_quads_version;
+	std::unique_ptr<Shader_Program> m_level_of_detail_shader_program;
+	const std::string m_level_of_detail_vertex_shader_path = "shaders/level_of_detail.vertex_shader";
+	const std::string m_level_of_detail_fragment_shader_path = "shaders/level_of_detail.fragment_shader";
 };
\ No newline at end of file
@@ -2,7 +2,7 @@
 
 //--------------------------------------------------------------------------------
 Shader::Shader(const std::string& shader_source_code_path, GLenum shader_type) {
-	ZoneScoped;
+	ZoneScopedFrame;
 	shader_source_code = read_from_file_into_std_string(shader_source_code_path);
 	//shader_source_code = &file_contents;
 	const char* shader_code = shader_source_code.c_str();
@@ -26,7 +26,7 @@ Shader::Shader(const std::string& shader_source_code_path, GLenum shader_type) {
 
 //--------------------------------------------------------------------------------
 Shader_Program::Shader_Program(const std::string& vertex_shader_path, const std::string& fragment_shader_path) {
-	ZoneScoped;
+	ZoneScopedFrame;
 	id = glCreateProgram();
 	vertex_shader = std::make_unique<Shader>(vertex_shader_path, GL_VERTEX_SHADER);
 	fragment_shader = std::make_unique<Shader>(fragment_shader_path, GL_FRAGMENT_SHADER);
@@ -39,7 +39,7 @@ Shader_Program::~Shader_Program() {
 
 //--------------------------------------------------------------------------------
 void Shader_Program::link_and_cleanup() {
-	ZoneScoped;
+	ZoneScopedFrame;
 	glAttachShader(id, vertex_shader->id);
 	glAttachShader(id, fragment_shader->id);
 	glLinkProgram(id);
@@ -62,27 +62,27 @@ void Shader_Program::link_and_cleanup() {
 
 //--------------------------------------------------------------------------------
 void Shader_Program::use() {
-	ZoneScoped;
+	ZoneScopedFrame;
 	glUseProgram(id);
 }
 
 //--------------------------------------------------------------------------------
 void Shader_Program::set_uniform_int(const std::string& name, int value) {
-	ZoneScoped;
+	ZoneScopedFrame;
 	int location = glGetUniformLocation(id, name.c_str());
 	glUniform1i(static_cast<GLint>(location), static_cast<GLint>(value));
 }
 
 //--------------------------------------------------------------------------------
 void Shader_Program::set_uniform_mat4(const std::string& name, glm::mat4 value) {
-	ZoneScoped;
+	ZoneScopedFrame;
 	unsigned int location = glGetUniformLocation(id, name.c_str());
 	glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
 }
 
 //--------------------------------------------------------------------------------
 void Shader_Program::load_texture_catalog(Texture_Catalog& catalog) {
-	ZoneScoped;
+	ZoneScopedFrame;
 	for (int i = 0; i < catalog.textures.size(); i++) {
 		set_uniform_int(catalog.textures[i].name, i);
 	}
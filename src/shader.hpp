@@ -1,6 +1,6 @@
 #pragma once
 //--------------------------------------------------------------------------------
-#include <tracy/Tracy.hpp>
+#include "profiling.hpp"
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
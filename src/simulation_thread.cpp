@@ -0,0 +1,139 @@
+#include "simulation_thread.hpp"
+
+
+//--------------------------------------------------------------------------------
+void Grid_Command_Queue::push(const Grid_UI_Controls_Info& ui_info) {
+	ZoneScopedFrame;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queued_commands.push_back(ui_info);
+	}
+	command_available_condition.notify_one();
+}
+
+void Grid_Command_Queue::pop_all(std::vector<Grid_UI_Controls_Info>& commands, std::chrono::microseconds timeout) {
+	ZoneScopedFrame;
+
+	commands.clear();
+	std::unique_lock<std::mutex> lock(mutex);
+	if (queued_commands.empty() && timeout.count() > 0) {
+		command_available_condition.wait_for(lock, timeout);
+	}
+	std::swap(commands, queued_commands);
+}
+
+void Grid_Command_Queue::notify() {
+	command_available_condition.notify_one();
+}
+
+//--------------------------------------------------------------------------------
+Grid_Simulation_Thread::Grid_Simulation_Thread() :
+	grid_manager(nullptr),
+should_stop(false),
+generations_per_second(0.0),
+measurement_start_iteration(0),
+measurement_start_time(std::chrono::steady_clock::now())
+{
+	ZoneScopedFrame;
+}
+
+Grid_Simulation_Thread::~Grid_Simulation_Thread() {
+	ZoneScopedFrame;
+
+	stop();
+}
+
+void Grid_Simulation_Thread::start() {
+	ZoneScopedFrame;
+
+	stop();
+	grid_manager = std::make_unique < Grid_Manager > ();
+	should_stop.store(false);
+	simulation_thread = std::thread(&Grid_Simulation_Thread::run, this);
+}
+
+void Grid_Simulation_Thread::stop() {
+	ZoneScopedFrame;
+
+	if (!simulation_thread.joinable()) {
+		return;
+	}
+	should_stop.store(true);
+	command_queue.notify();
+	simulation_thread.join();
+}
+
+void Grid_Simulation_Thread::push_command(const Grid_UI_Controls_Info& ui_info) {
+	command_queue.push(ui_info);
+}
+
+bool Grid_Simulation_Thread::update_render_snapshot() {
+	ZoneScopedFrame;
+
+	return render_snapshots.update_read_buffer();
+}
+
+const Render_Snapshot& Grid_Simulation_Thread::get_render_snapshot() const {
+	return render_snapshots.get_read_buffer();
+}
+
+//--------------------------------------------------------------------------------
+void Grid_Simulation_Thread::run() {
+	std::vector<Grid_UI_Controls_Info> commands;
+	bool has_unpublished_changes = true;
+	bool has_computed_generations = false;
+	auto last_update_time = std::chrono::steady_clock::now();
+	while (!should_stop.load()) {
+		ZoneScopedFrame;
+
+		// sleep until the next command if nothing is going on, the speed limited mode polls every millisecond.
+		auto timeout = has_computed_generations ? std::chrono::microseconds(0) : std::chrono::microseconds(1000);
+		command_queue.pop_all(commands, timeout);
+		for (const Grid_UI_Controls_Info& command: commands) {
+			grid_manager->update_grid_execution_state(command);
+		}
+
+		auto now = std::chrono::steady_clock::now();
+		double dt = std::chrono::duration<double>(now - last_update_time).count();
+		last_update_time = now;
+		has_computed_generations = grid_manager->update(dt);
+		has_unpublished_changes = has_unpublished_changes || has_computed_generations || !commands.empty();
+
+		// the iteration drops on reset and seek, the measurement starts over then.
+		double measurement_seconds = std::chrono::duration<double>(now - measurement_start_time).count();
+		std::size_t iteration = grid_manager->grid->iteration;
+		if (iteration < measurement_start_iteration || measurement_seconds >= 0.5) {
+			generations_per_second = iteration >= measurement_start_iteration ? (iteration - measurement_start_iteration) / measurement_seconds : 0.0;
+			measurement_start_iteration = iteration;
+			measurement_start_time = now;
+		}
+
+		if (has_unpublished_changes && render_snapshots.was_last_value_read()) {
+			publish_render_snapshot();
+			has_unpublished_changes = false;
+		}
+	}
+}
+
+void Grid_Simulation_Thread::publish_render_snapshot() {
+	ZoneScopedFrame;
+
+	grid_manager->update_grid_info();
+	Grid& grid = *grid_manager->grid;
+
+	Render_Snapshot& snapshot = render_snapshots.get_write_buffer();
+	snapshot.chunk_bits.resize(grid.chunks.size());
+	snapshot.chunk_origins.resize(grid.chunks.size());
+	grid.run_for_all_chunks_in_parallel([&grid, &snapshot](std::size_t task_index, std::pair<std::size_t, std::size_t> start_end_index_pair) {
+		for (std::size_t idx = start_end_index_pair.first; idx <= start_end_index_pair.second; idx++) {
+			const Chunk& chunk = grid.chunks[idx];
+			snapshot.chunk_bits[idx] = chunk.get_row_bits();
+			snapshot.chunk_origins[idx] = std::make_pair(chunk.chunk_origin_row, chunk.chunk_origin_column);
+		}
+	});
+	snapshot.grid_info = *grid_manager->grid_info;
+	snapshot.grid_info.simulation_generations_per_second = generations_per_second;
+	snapshot.show_chunk_borders = grid_manager->grid_execution_state.show_chunk_borders;
+	render_snapshots.publish();
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "profiling.hpp"
+#include "grid.hpp"
+#include "triple_buffer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+//--------------------------------------------------------------------------------
+// What the render loop needs of a generation, copied out by the simulation thread and never changed afterwards.
+struct Render_Snapshot {
+	// bit c of row r of chunk_bits[i] is the cell at row chunk_origins[i].first + r and column chunk_origins[i].second + c.
+	std::vector<Chunk::Row_Bits> chunk_bits;
+	std::vector<std::pair<int, int>> chunk_origins;
+	Grid_Info grid_info;
+	bool show_chunk_borders = false;
+};
+
+// The controls of the user interface on their way to the simulation thread, in the order they got pushed.
+class Grid_Command_Queue {
+public:
+	void push(const Grid_UI_Controls_Info& ui_info);
+
+	// moves all queued commands into commands, waits up to timeout if there are none.
+	void pop_all(std::vector<Grid_UI_Controls_Info>& commands, std::chrono::microseconds timeout);
+
+	// wakes up a pop_all() which is waiting.
+	void notify();
+
+private:
+	//--------------------------------------------------------------------------------
+	// data
+	std::mutex mutex;
+	std::condition_variable command_available_condition;
+	std::vector<Grid_UI_Controls_Info> queued_commands;
+};
+
+//--------------------------------------------------------------------------------
+// Runs the Grid_Manager on its own thread, so that a slow generation never drops frames and vsync never limits the
+// simulation. The render loop pushes its controls into the command queue and picks up the latest Render_Snapshot from
+// a triple buffer, neither side ever waits for the other. A snapshot only gets built once the render loop took the
+// previous one, so at full speed the simulation pays for about one snapshot per frame and not per generation.
+class Grid_Simulation_Thread {
+public:
+	Grid_Simulation_Thread();
+
+	// stops and joins the simulation thread.
+	~Grid_Simulation_Thread();
+
+	Grid_Simulation_Thread(const Grid_Simulation_Thread&) = delete;
+
+	Grid_Simulation_Thread& operator = (const Grid_Simulation_Thread&) = delete;
+
+	// creates the Grid_Manager with the default grid and starts the thread.
+	void start();
+
+	void stop();
+
+	// render loop side.
+	void push_command(const Grid_UI_Controls_Info& ui_info);
+
+	// takes the latest snapshot if there is one. Returns true if get_render_snapshot() changed.
+	bool update_render_snapshot();
+
+	const Render_Snapshot& get_render_snapshot() const;
+
+private:
+	void run();
+
+	void publish_render_snapshot();
+	//--------------------------------------------------------------------------------
+	// data
+	std::unique_ptr<Grid_Manager> grid_manager;
+
+	Grid_Command_Queue command_queue;
+	Triple_Buffer<Render_Snapshot> render_snapshots;
+
+	std::thread simulation_thread;
+	std::atomic<bool> should_stop;
+
+	// generations per second, measured over the last half second.
+	double generations_per_second;
+	std::size_t measurement_start_iteration;
+	std::chrono::steady_clock::time_point measurement_start_time;
+};
@@ -0,0 +1,390 @@
+#include "snapshot.hpp"
+
+#include "grid.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+//--------------------------------------------------------------------------------
+constexpr static std::array<char, 8> SNAPSHOT_MAGIC = { 'G', 'O', 'L', 'S', 'N', 'A', 'P', '\0' };
+constexpr static std::array<char, 16> SNAPSHOT_RULE = { 'B', '3', '/', 'S', '2', '3' };
+constexpr static std::size_t SNAPSHOT_WRITE_BUFFER_SIZE = 4 << 20;
+static_assert(SNAPSHOT_BITMAP_SIZE == Chunk::rows * Chunk::columns && sizeof(Snapshot_Bitmap) == SNAPSHOT_BITMAP_SIZE);
+static_assert(SNAPSHOT_BITMAP_SIZE % 32 == 0 && SNAPSHOT_BITMAPS_ALIGNMENT % 32 == 0);
+
+//--------------------------------------------------------------------------------
+// Read only mapping of a whole file, mmap on POSIX systems and CreateFileMapping on Windows.
+class Snapshot_File_Mapping {
+public:
+	explicit Snapshot_File_Mapping(const std::string& path);
+
+	~Snapshot_File_Mapping();
+
+	Snapshot_File_Mapping(const Snapshot_File_Mapping&) = delete;
+
+	Snapshot_File_Mapping& operator = (const Snapshot_File_Mapping&) = delete;
+
+	bool is_mapped() const;
+
+	const unsigned char* get_data() const;
+
+	std::size_t get_size() const;
+
+private:
+	//--------------------------------------------------------------------------------
+	// data
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE mapping;
+#else
+	int file_descriptor;
+#endif
+	const unsigned char* data;
+	std::size_t size;
+};
+
+#ifdef _WIN32
+Snapshot_File_Mapping::Snapshot_File_Mapping(const std::string& path) :
+	file(INVALID_HANDLE_VALUE),
+mapping(nullptr),
+data(nullptr),
+size(0)
+{
+	ZoneScopedPhase;
+
+	file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return;
+	}
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+		return;
+	}
+	mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping) {
+		return;
+	}
+	data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	size = data ? static_cast<std::size_t>(file_size.QuadPart) : 0;
+}
+
+Snapshot_File_Mapping::~Snapshot_File_Mapping() {
+	ZoneScopedPhase;
+
+	if (data) {
+		UnmapViewOfFile(data);
+	}
+	if (mapping) {
+		CloseHandle(mapping);
+	}
+	if (file != INVALID_HANDLE_VALUE) {
+		CloseHandle(file);
+	}
+}
+#else
+Snapshot_File_Mapping::Snapshot_File_Mapping(const std::string& path) :
+	file_descriptor(-1),
+data(nullptr),
+size(0)
+{
+	ZoneScopedPhase;
+
+	file_descriptor = open(path.c_str(), O_RDONLY);
+	if (file_descriptor < 0) {
+		return;
+	}
+	struct stat file_status;
+	if (fstat(file_descriptor, &file_status) != 0 || file_status.st_size == 0) {
+		return;
+	}
+	void* address = mmap(nullptr, static_cast<std::size_t>(file_status.st_size), PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+	if (address == MAP_FAILED) {
+		return;
+	}
+	data = static_cast<const unsigned char*>(address);
+	size = static_cast<std::size_t>(file_status.st_size);
+	// the bitmaps get read front to back exactly once, let the kernel read ahead aggressively.
+	madvise(address, size, MADV_SEQUENTIAL);
+	madvise(address, size, MADV_WILLNEED);
+}
+
+Snapshot_File_Mapping::~Snapshot_File_Mapping() {
+	ZoneScopedPhase;
+
+	if (data) {
+		munmap(const_cast<unsigned char*>(data), size);
+	}
+	if (file_descriptor >= 0) {
+		close(file_descriptor);
+	}
+}
+#endif
+
+bool Snapshot_File_Mapping::is_mapped() const {
+	return data != nullptr;
+}
+
+const unsigned char* Snapshot_File_Mapping::get_data() const {
+	return data;
+}
+
+std::size_t Snapshot_File_Mapping::get_size() const {
+	return size;
+}
+
+//--------------------------------------------------------------------------------
+bool is_grid_snapshot_file(const std::string& path) {
+	ZoneScopedPhase;
+
+	std::FILE* file = std::fopen(path.c_str(), "rb");
+	if (!file) {
+		return false;
+	}
+	std::array<char, 8> magic = {};
+	bool is_snapshot = std::fread(magic.data(), 1, magic.size(), file) == magic.size() && magic == SNAPSHOT_MAGIC;
+	std::fclose(file);
+	return is_snapshot;
+}
+
+void resize_grid_snapshot_capture(Grid_Snapshot_Capture& capture, std::size_t number_of_chunks) {
+	ZoneScopedPhase;
+
+	capture.directory.resize(number_of_chunks);
+	if (number_of_chunks > capture.bitmap_capacity) {
+		// a little headroom, so that a growing grid does not reallocate for every capture.
+		capture.bitmap_capacity = number_of_chunks + number_of_chunks / 8;
+		capture.bitmaps.reset(new Snapshot_Bitmap[capture.bitmap_capacity]);
+	}
+}
+
+std::size_t get_grid_snapshot_capture_memory(const Grid_Snapshot_Capture& capture) {
+	return capture.directory.capacity() * sizeof(Snapshot_Chunk_Entry) + capture.bitmap_capacity * sizeof(Snapshot_Bitmap);
+}
+
+void capture_grid_snapshot(const Grid& grid, Grid_Snapshot_Capture& capture) {
+	ZoneScopedPhase;
+
+	capture.iteration = grid.iteration;
+	capture.is_complete = true;
+	resize_grid_snapshot_capture(capture, grid.chunks.size());
+	auto copy_bitmaps = [&](std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; i++) {
+			const Chunk& chunk = grid.chunks[i];
+			capture.directory[i] = Snapshot_Chunk_Entry{ chunk.grid_coordinate_row, chunk.grid_coordinate_column };
+			std::memcpy(capture.bitmaps[i].cells.data(), chunk.cells_data.data(), SNAPSHOT_BITMAP_SIZE);
+		}
+	};
+
+	// the copy is bound by memory bandwidth, which one core does not saturate.
+	std::size_t number_of_tasks = grid.thread_pool ? grid.thread_pool->get_number_of_threads() : 1;
+	if (number_of_tasks <= 1 || grid.chunks.size() < grid.minimum_number_of_chunks_per_task) {
+		copy_bitmaps(0, grid.chunks.size());
+		return;
+	}
+	std::size_t number_of_chunks_per_task = (grid.chunks.size() + number_of_tasks - 1) / number_of_tasks;
+	grid.thread_pool->run_tasks(number_of_tasks, [&](std::size_t task_index) {
+		std::size_t begin = std::min(task_index * number_of_chunks_per_task, grid.chunks.size());
+		std::size_t end = std::min(begin + number_of_chunks_per_task, grid.chunks.size());
+		copy_bitmaps(begin, end);
+	});
+}
+
+// flushes the buffered and the cached data of file to the disk.
+static bool sync_file(std::FILE* file) {
+	if (std::fflush(file) != 0) {
+		return false;
+	}
+#ifdef _WIN32
+	return _commit(_fileno(file)) == 0;
+#else
+	return fsync(fileno(file)) == 0;
+#endif
+}
+
+bool write_grid_snapshot(const std::string& path, const Grid_Snapshot_Capture& capture, bool should_sync, std::string& error_message) {
+	ZoneScopedPhase;
+
+	// the captures follow the order of the chunks, which are only sorted once enough of them changed.
+	std::vector<std::pair<std::uint64_t, std::size_t>> morton_key_index_pairs;
+	morton_key_index_pairs.reserve(capture.directory.size());
+	for (std::size_t idx = 0; idx < capture.directory.size(); idx++) {
+		const Snapshot_Chunk_Entry& entry = capture.directory[idx];
+		morton_key_index_pairs.push_back(std::make_pair(Coordinate(entry.row, entry.column).morton_key(), idx));
+	}
+	std::sort(morton_key_index_pairs.begin(), morton_key_index_pairs.end());
+	std::vector<Snapshot_Chunk_Entry> sorted_directory;
+	sorted_directory.reserve(morton_key_index_pairs.size());
+	for (const std::pair<std::uint64_t, std::size_t>& morton_key_index_pair: morton_key_index_pairs) {
+		sorted_directory.push_back(capture.directory[morton_key_index_pair.second]);
+	}
+
+	std::uint64_t directory_end = sizeof(Snapshot_Header) + sorted_directory.size() * sizeof(Snapshot_Chunk_Entry);
+	Snapshot_Header header;
+	header.magic = SNAPSHOT_MAGIC;
+	header.version = SNAPSHOT_VERSION;
+	header.header_size = sizeof(Snapshot_Header);
+	header.iteration = capture.iteration;
+	header.rule = SNAPSHOT_RULE;
+	header.chunk_rows = Chunk::rows;
+	header.chunk_columns = Chunk::columns;
+	header.number_of_chunks = sorted_directory.size();
+	header.bitmaps_offset = (directory_end + SNAPSHOT_BITMAPS_ALIGNMENT - 1) / SNAPSHOT_BITMAPS_ALIGNMENT * SNAPSHOT_BITMAPS_ALIGNMENT;
+
+	std::string temporary_path = path + ".tmp";
+	std::FILE* file = std::fopen(temporary_path.c_str(), "wb");
+	if (!file) {
+		error_message = "Could not open " + temporary_path + " for writing";
+		return false;
+	}
+	std::vector<char> write_buffer(SNAPSHOT_WRITE_BUFFER_SIZE);
+	std::setvbuf(file, write_buffer.data(), _IOFBF, write_buffer.size());
+
+	std::vector<char> padding(header.bitmaps_offset - directory_end, 0);
+	bool is_written = std::fwrite(&header, sizeof(header), 1, file) == 1;
+	is_written = is_written && std::fwrite(sorted_directory.data(), sizeof(Snapshot_Chunk_Entry), sorted_directory.size(), file) == sorted_directory.size();
+	is_written = is_written && std::fwrite(padding.data(), 1, padding.size(), file) == padding.size();
+	// the bitmaps get gathered in the write buffer, which turns them into large writes again.
+	for (std::size_t i = 0; is_written && i < morton_key_index_pairs.size(); i++) {
+		is_written = std::fwrite(&capture.bitmaps[morton_key_index_pairs[i].second], sizeof(Snapshot_Bitmap), 1, file) == 1;
+	}
+	if (should_sync) {
+		is_written = is_written && sync_file(file);
+	}
+	is_written = std::fclose(file) == 0 && is_written;
+	if (!is_written) {
+		std::remove(temporary_path.c_str());
+		error_message = "Could not write " + temporary_path;
+		return false;
+	}
+
+	std::error_code error_code;
+	std::filesystem::rename(temporary_path, path, error_code);
+	if (error_code) {
+		error_message = "Could not rename " + temporary_path + " to " + path + ": " + error_code.message();
+		return false;
+	}
+#ifndef _WIN32
+	if (should_sync) {
+		// the rename itself only becomes durable with the directory entry.
+		std::filesystem::path directory_path = std::filesystem::absolute(std::filesystem::path(path)).parent_path();
+		int directory_descriptor = open(directory_path.c_str(), O_RDONLY);
+		if (directory_descriptor >= 0) {
+			fsync(directory_descriptor);
+			close(directory_descriptor);
+		}
+	}
+#endif
+	return true;
+}
+
+bool save_grid_snapshot(const std::string& path, const Grid& grid, std::string& error_message) {
+	ZoneScopedPhase;
+
+	Grid_Snapshot_Capture capture;
+	capture_grid_snapshot(grid, capture);
+	return write_grid_snapshot(path, capture, false, error_message);
+}
+
+bool load_grid_snapshot(const std::string& path, Grid& grid, std::string& error_message) {
+	ZoneScopedPhase;
+
+	Snapshot_File_Mapping mapping(path);
+	if (!mapping.is_mapped()) {
+		error_message = "Could not map snapshot file " + path;
+		return false;
+	}
+
+	Snapshot_Header header;
+	if (mapping.get_size() < sizeof(Snapshot_Header)) {
+		error_message = "truncated snapshot header";
+		return false;
+	}
+	std::memcpy(&header, mapping.get_data(), sizeof(Snapshot_Header));
+	if (header.magic != SNAPSHOT_MAGIC) {
+		error_message = "not a grid snapshot";
+		return false;
+	}
+	if (header.version != SNAPSHOT_VERSION || header.header_size != sizeof(Snapshot_Header)) {
+		error_message = "unsupported snapshot version " + std::to_string(header.version);
+		return false;
+	}
+	if (header.rule != SNAPSHOT_RULE) {
+		error_message = "unsupported rule " + std::string(header.rule.data(), strnlen(header.rule.data(), header.rule.size())) + ", only B3/S23 is supported";
+		return false;
+	}
+	if (header.chunk_rows != Chunk::rows || header.chunk_columns != Chunk::columns) {
+		error_message = "snapshot has " + std::to_string(header.chunk_rows) + "x" + std::to_string(header.chunk_columns) + " chunks";
+		return false;
+	}
+	std::uint64_t maximum_number_of_chunks = mapping.get_size() / SNAPSHOT_BITMAP_SIZE;
+	if (header.number_of_chunks > maximum_number_of_chunks
+		|| header.bitmaps_offset > mapping.get_size()
+		|| header.bitmaps_offset % 32 != 0
+		|| header.bitmaps_offset < sizeof(Snapshot_Header) + header.number_of_chunks * sizeof(Snapshot_Chunk_Entry)
+		|| header.bitmaps_offset + header.number_of_chunks * SNAPSHOT_BITMAP_SIZE > mapping.get_size()) {
+		error_message = "truncated or corrupt snapshot";
+		return false;
+	}
+
+	const unsigned char* directory = mapping.get_data() + sizeof(Snapshot_Header);
+	const unsigned char* bitmaps = mapping.get_data() + header.bitmaps_offset;
+	grid.chunks.reserve(grid.chunks.size() + header.number_of_chunks);
+	for (std::uint64_t i = 0; i < header.number_of_chunks; i++) {
+		Snapshot_Chunk_Entry entry;
+		std::memcpy(&entry, directory + i * sizeof(Snapshot_Chunk_Entry), sizeof(Snapshot_Chunk_Entry));
+		Coordinate chunk_coordinate = Coordinate(entry.row, entry.column);
+		// same limits as the pattern importers, far away chunks would overflow the cell coordinates of their neighbours.
+		if (entry.row < INT32_MIN / 2 / Chunk::rows || entry.row > INT32_MAX / 2 / Chunk::rows
+			|| entry.column < INT32_MIN / 2 / Chunk::columns || entry.column > INT32_MAX / 2 / Chunk::columns) {
+			error_message = "chunk (" + std::to_string(entry.row) + ", " + std::to_string(entry.column) + ") out of range";
+			return false;
+		}
+		if (grid.chunk_map.find(chunk_coordinate) != Chunk_Directory::INVALID_CHUNK_INDEX) {
+			error_message = "duplicate chunk (" + std::to_string(entry.row) + ", " + std::to_string(entry.column) + ") in snapshot";
+			return false;
+		}
+
+		// the kernels rely on every cell being 0x00 or 0xFF, any other byte would be counted as a fraction of a neighbour.
+		// The bitmaps are 32 byte aligned, see the bitmaps_offset check above.
+		const unsigned char* bitmap = bitmaps + i * SNAPSHOT_BITMAP_SIZE;
+		const __m256i dead_cells = _mm256_setzero_si256();
+		const __m256i alive_cells = _mm256_cmpeq_epi8(dead_cells, dead_cells);
+		__m256i any_alive_cells = _mm256_setzero_si256();
+		__m256i valid_cells = alive_cells;
+		for (int r = 0; r < Chunk::rows; r++) {
+			__m256i cells = _mm256_load_si256(reinterpret_cast<const __m256i*>(bitmap + r * Chunk::columns));
+			any_alive_cells = _mm256_or_si256(any_alive_cells, cells);
+			valid_cells = _mm256_and_si256(valid_cells, _mm256_or_si256(_mm256_cmpeq_epi8(cells, dead_cells), _mm256_cmpeq_epi8(cells, alive_cells)));
+		}
+		if (_mm256_movemask_epi8(valid_cells) != -1) {
+			error_message = "corrupt snapshot, chunk (" + std::to_string(entry.row) + ", " + std::to_string(entry.column) + ") has cells that are neither 0x00 nor 0xFF";
+			return false;
+		}
+
+		// the chunks store their cells inline, so the bitmap can not be adopted as is, but it is laid out exactly like
+		// cells_data and a plain copy is all the decoding there is.
+		grid.create_new_chunk(chunk_coordinate);
+		Chunk& chunk = grid.chunks.back();
+		std::memcpy(chunk.cells_data.data(), bitmap, SNAPSHOT_BITMAP_SIZE);
+		chunk.has_alive_cells = !_mm256_is_zero(any_alive_cells);
+	}
+	grid.number_of_chunks = grid.chunks.size();
+	grid.iteration = header.iteration;
+	return true;
+}
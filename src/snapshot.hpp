@@ -0,0 +1,88 @@
+#pragma once
+
+#include "profiling.hpp"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Grid;
+
+
+//--------------------------------------------------------------------------------
+// Binary checkpoint of a grid, so that long runs can be restarted. The layout is
+// - Snapshot_Header
+// - number_of_chunks Snapshot_Chunk_Entry, sorted by the Morton key of the chunk coordinate
+// - zero padding up to bitmaps_offset, which is page aligned
+// - number_of_chunks bitmaps in the order of the directory, each exactly Chunk::cells_data (rows * columns bytes, 0xFF
+//   for alive cells), so every bitmap stays 32 byte aligned and can be copied into a chunk without any decoding.
+// All values are stored little endian.
+constexpr static std::uint32_t SNAPSHOT_VERSION = 1;
+constexpr static std::uint64_t SNAPSHOT_BITMAPS_ALIGNMENT = 4096;
+// Chunk::rows * Chunk::columns, checked in snapshot.cpp.
+constexpr static std::size_t SNAPSHOT_BITMAP_SIZE = 32 * 32;
+
+struct Snapshot_Header {
+	std::array<char, 8> magic;
+	std::uint32_t version;
+	std::uint32_t header_size;
+	std::uint64_t iteration;
+	std::array<char, 16> rule;
+	std::uint32_t chunk_rows;
+	std::uint32_t chunk_columns;
+	std::uint64_t number_of_chunks;
+	std::uint64_t bitmaps_offset;
+};
+static_assert(sizeof(Snapshot_Header) == 64);
+
+struct Snapshot_Chunk_Entry {
+	std::int32_t row;
+	std::int32_t column;
+};
+static_assert(sizeof(Snapshot_Chunk_Entry) == 8);
+
+struct alignas(32) Snapshot_Bitmap {
+	std::array<unsigned char, SNAPSHOT_BITMAP_SIZE> cells;
+};
+
+// The cells of all chunks of a grid at one iteration, bitmap i belongs to directory entry i. Both are in the order of
+// the chunks of the grid, write_grid_snapshot() brings them into the order of the file on the writing thread. Capturing
+// copies only the bitmaps, a small part of every chunk, and the slow part, writing the file, can happen on another
+// thread while the simulation goes on.
+struct Grid_Snapshot_Capture {
+	std::uint64_t iteration = 0;
+	std::vector<Snapshot_Chunk_Entry> directory;
+	// not value initialised, so that growing a capture does not clear the bitmaps right before they get copied into.
+	std::unique_ptr<Snapshot_Bitmap[]> bitmaps;
+	std::size_t bitmap_capacity = 0;
+	// false while the grid still has to copy chunks into the bitmaps, see Grid::begin_snapshot_capture().
+	bool is_complete = false;
+};
+
+//--------------------------------------------------------------------------------
+// true if the file starts with the snapshot magic.
+bool is_grid_snapshot_file(const std::string& path);
+
+// sizes the directory and the bitmaps of capture for number_of_chunks chunks. Both keep their capacity, so capturing
+// into the same instance again does not allocate.
+void resize_grid_snapshot_capture(Grid_Snapshot_Capture& capture, std::size_t number_of_chunks);
+
+// the memory capture holds on to, including the capacity which is not in use.
+std::size_t get_grid_snapshot_capture_memory(const Grid_Snapshot_Capture& capture);
+
+// Copies the chunk bitmaps of grid into capture right away, using the thread pool of the grid.
+void capture_grid_snapshot(const Grid& grid, Grid_Snapshot_Capture& capture);
+
+// Sorts the directory of capture by the Morton key and writes it and the bitmaps in that order with large sequential
+// writes into a temporary file, which then replaces path. A crash while saving never destroys the previous snapshot. If
+// should_sync is set, the data and the rename are flushed to the disk before returning.
+bool write_grid_snapshot(const std::string& path, const Grid_Snapshot_Capture& capture, bool should_sync, std::string& error_message);
+
+// capture_grid_snapshot() followed by write_grid_snapshot().
+bool save_grid_snapshot(const std::string& path, const Grid& grid, std::string& error_message);
+
+// Maps the snapshot into memory and copies the bitmaps straight into new chunks of grid, which should be empty. Like
+// the pattern loaders it does not sort the chunks, call Grid::finish_pattern_creation() afterwards.
+bool load_grid_snapshot(const std::string& path, Grid& grid, std::string& error_message);
@@ -11,7 +11,7 @@ Timer::Timer() :
 
 //--------------------------------------------------------------------------------
 void Timer::update() {
-	ZoneScoped;
+	ZoneScopedFrame;
 	float m_current_frame_time = (float) glfwGetTime();
 	dt = m_current_frame_time - m_last_frame_time;
 	m_last_frame_time = m_current_frame_time;
@@ -19,9 +19,10 @@ void Timer::update() {
 
 //--------------------------------------------------------------------------------
 State::State() : window(nullptr), timer(nullptr), ui_state(nullptr), renderer(nullptr),
-world(nullptr)
+world(nullptr),
+simulation_thread(nullptr)
 {
-	ZoneScoped;
+	ZoneScopedFrame;
 	timer = std::make_unique < Timer > ();
 
 	ui_state = std::make_unique < UI_State > ();
@@ -31,11 +32,13 @@ world(nullptr)
 	world = std::make_shared < World > ();
 
 	cube_system = std::make_shared < Cube_System > ();
+
+	simulation_thread = std::make_unique < Grid_Simulation_Thread > ();
 }
 
 //--------------------------------------------------------------------------------
 void State::update() {
-	ZoneScoped;
+	ZoneScopedFrame;
 
 	glfwPollEvents();
 
@@ -43,43 +46,59 @@ void State::update() {
 
 	double dt = timer->dt;
 
-	world->update(dt, ui_state->ui_info);
-
-	cube_system->update();
+	// the controls of the last frame, the grid itself runs on the simulation thread.
+	simulation_thread->push_command(ui_state->ui_info);
+
+	world->update(dt);
+
+	// switching the cell expansion needs the other buffers filled and a camera move brings other chunks into view or
+	// changes their level of detail, even while the grid is paused.
+	Cube_Render_Settings render_settings;
+	render_settings.projection_view_matrix = renderer->get_projection_view_matrix(world);
+	int window_width, window_height;
+	glfwGetWindowSize(window, &window_width, &window_height);
+	render_settings.viewport_size = glm::vec2(static_cast<float>(window_width), static_cast<float>(window_height));
+	render_settings.should_expand_cells_on_gpu = ui_state->ui_info.should_expand_cells_on_gpu;
+	render_settings.should_use_level_of_detail = ui_state->ui_info.should_use_level_of_detail;
+	render_settings.level_of_detail_pixels_per_cell = ui_state->ui_info.level_of_detail_pixels_per_cell;
+	bool has_new_snapshot = simulation_thread->update_render_snapshot();
+	if (has_new_snapshot || render_settings != cube_system->settings) {
+		cube_system->update(simulation_thread->get_render_snapshot(), render_settings, *renderer->chunk_instance_slots, *renderer->chunk_bitmap_buffer, *renderer->border_instance_buffer);
+	}
 
 	// this sets up a new IMGUI-Frame! But we call the imgui render function only in our renderer! We always have to call ui_state->update() before the imgui render function,otherwise imgui didnt start a new frame!
 
-	ui_state->update(*world->grid_manager->grid_info);
+	ui_state->update(simulation_thread->get_render_snapshot().grid_info, cube_system->render_info);
 
 	renderer->render_frame(world, cube_system);
 }
 
 //--------------------------------------------------------------------------------
 void State::initialise(GLFWwindow* w) {
-	ZoneScoped;
+	ZoneScopedFrame;
 	window = w;
 
 	renderer->initialise(window);
 	world->initialise(window);
 	ui_state->initialise(window);
-	cube_system->initialise(world->grid_manager);
+	simulation_thread->start();
 }
 
 //--------------------------------------------------------------------------------
 void State::framebuffer_size_callback(int width, int height) {
-	ZoneScoped;
+	ZoneScopedFrame;
 	glViewport(0, 0, width, height);
 }
 
 void State::scroll_callback(double xoffset, double yoffset) {
-	ZoneScoped;
+	ZoneScopedFrame;
 
 	world->m_camera->add_offset_and_clip_fov(static_cast<float>(-yoffset));
 }
 
 
 bool State::should_quit() {
-	ZoneScoped;
+	ZoneScopedFrame;
 	//assert(window);
 	return glfwWindowShouldClose(window);
 }
\ No newline at end of file
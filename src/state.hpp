@@ -1,6 +1,6 @@
 #pragma once
 
-#include <tracy/Tracy.hpp>
+#include "profiling.hpp"
 //--------------------------------------------------------------------------------
 
 #include <vector>
@@ -14,6 +14,7 @@
 #include "texture.hpp"
 #include "cube.hpp"
 #include "grid.hpp"
+#include "simulation_thread.hpp"
 
 #include "renderer.hpp"
 
@@ -54,4 +55,5 @@ public:
 	std::unique_ptr<Renderer> renderer;
 	std::shared_ptr<World> world;
 	std::shared_ptr<Cube_System> cube_system;
+	std::unique_ptr<Grid_Simulation_Thread> simulation_thread;
 };
\ No newline at end of file
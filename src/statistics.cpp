@@ -0,0 +1,222 @@
+#include "statistics.hpp"
+
+#include "grid.hpp"
+
+#include <chrono>
+#include <cstring>
+
+
+//--------------------------------------------------------------------------------
+constexpr static std::array<char, 8> STATISTICS_LOG_MAGIC = { 'G', 'O', 'L', 'S', 'T', 'A', 'T', '\0' };
+
+//--------------------------------------------------------------------------------
+Grid_Statistics_Log::Grid_Statistics_Log() :
+	ring_buffer({}),
+write_index(0),
+read_index(0),
+should_stop(false),
+number_of_full_buffer_waits(0),
+file(nullptr),
+status({})
+{
+	ZoneScopedFrame;
+}
+
+Grid_Statistics_Log::~Grid_Statistics_Log() {
+	ZoneScopedFrame;
+
+	std::string error_message;
+	close(error_message);
+}
+
+bool Grid_Statistics_Log::open(const std::string& path, std::string& error_message) {
+	ZoneScopedFrame;
+
+	if (!close(error_message)) {
+		return false;
+	}
+	file = std::fopen(path.c_str(), "wb");
+	if (!file) {
+		error_message = "Could not open " + path + " for writing";
+		return false;
+	}
+	// the writer hands over whole batches, the stdio buffer only has to round them up to large writes.
+	std::setvbuf(file, nullptr, _IOFBF, WRITE_BATCH_SIZE * sizeof(Generation_Statistics_Record));
+
+	Statistics_Log_Header header;
+	header.magic = STATISTICS_LOG_MAGIC;
+	header.version = STATISTICS_LOG_VERSION;
+	header.record_size = sizeof(Generation_Statistics_Record);
+	if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+		std::fclose(file);
+		file = nullptr;
+		error_message = "Could not write " + path;
+		return false;
+	}
+
+	ring_buffer.resize(RING_BUFFER_SIZE);
+	write_index.store(0);
+	read_index.store(0);
+	should_stop.store(false);
+	number_of_full_buffer_waits.store(0);
+	{
+		std::lock_guard<std::mutex> lock(status_mutex);
+		status = {};
+	}
+	writer_thread = std::thread(&Grid_Statistics_Log::run_writer, this);
+	return true;
+}
+
+bool Grid_Statistics_Log::close(std::string& error_message) {
+	ZoneScopedFrame;
+
+	if (!file) {
+		return true;
+	}
+	should_stop.store(true, std::memory_order_release);
+	writer_thread.join();
+
+	bool is_closed = std::fclose(file) == 0;
+	file = nullptr;
+
+	std::lock_guard<std::mutex> lock(status_mutex);
+	if (!is_closed && status.error_message.empty()) {
+		status.error_message = "Could not write the statistics log";
+	}
+	error_message = status.error_message;
+	return status.error_message.empty();
+}
+
+bool Grid_Statistics_Log::is_open() const {
+	return file != nullptr;
+}
+
+void Grid_Statistics_Log::record(const Grid& grid) {
+	ZoneScopedPhase;
+
+	if (!file) {
+		return;
+	}
+	std::uint64_t index = write_index.load(std::memory_order_relaxed);
+	if (index - read_index.load(std::memory_order_acquire) >= RING_BUFFER_SIZE) {
+		number_of_full_buffer_waits.fetch_add(1, std::memory_order_relaxed);
+		while (index - read_index.load(std::memory_order_acquire) >= RING_BUFFER_SIZE) {
+			std::this_thread::yield();
+		}
+	}
+
+	const Grid_Generation_Statistics& statistics = grid.generation_statistics;
+	Generation_Statistics_Record& record = ring_buffer[index % RING_BUFFER_SIZE];
+	record.iteration = grid.iteration;
+	record.population = statistics.population;
+	record.number_of_births = statistics.number_of_births;
+	record.number_of_deaths = statistics.number_of_deaths;
+	record.number_of_chunks = grid.chunks.size();
+	record.bounding_box_min_row = statistics.bounding_box.min_row;
+	record.bounding_box_min_column = statistics.bounding_box.min_column;
+	record.bounding_box_max_row = statistics.bounding_box.max_row;
+	record.bounding_box_max_column = statistics.bounding_box.max_column;
+	record.seconds = grid.phase_timings.total();
+	write_index.store(index + 1, std::memory_order_release);
+}
+
+Statistics_Log_Status Grid_Statistics_Log::get_status() const {
+	std::lock_guard<std::mutex> lock(status_mutex);
+	Statistics_Log_Status current_status = status;
+	current_status.number_of_records = write_index.load(std::memory_order_relaxed);
+	current_status.number_of_full_buffer_waits = number_of_full_buffer_waits.load(std::memory_order_relaxed);
+	return current_status;
+}
+
+void Grid_Statistics_Log::run_writer() {
+	bool has_failed = false;
+	while (true) {
+		// read should_stop before write_index, so the records of the last generations are never missed.
+		bool is_stopping = should_stop.load(std::memory_order_acquire);
+		std::uint64_t index = read_index.load(std::memory_order_relaxed);
+		std::uint64_t end_index = write_index.load(std::memory_order_acquire);
+		if (index == end_index) {
+			if (is_stopping) {
+				break;
+			}
+			// a generation takes at least microseconds, polling every millisecond keeps the buffer far from full.
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+
+		// the records up to the end of the buffer or of the batch, the rest follows in the next round.
+		std::size_t start = static_cast<std::size_t>(index % RING_BUFFER_SIZE);
+		std::size_t number_of_records = static_cast<std::size_t>(std::min<std::uint64_t>(end_index - index, RING_BUFFER_SIZE - start));
+		number_of_records = std::min(number_of_records, WRITE_BATCH_SIZE);
+		if (!has_failed && std::fwrite(&ring_buffer[start], sizeof(Generation_Statistics_Record), number_of_records, file) != number_of_records) {
+			// keep draining the buffer, so record() never waits for a writer which gave up.
+			has_failed = true;
+			std::lock_guard<std::mutex> lock(status_mutex);
+			status.error_message = "Could not write the statistics log";
+		}
+		read_index.store(index + number_of_records, std::memory_order_release);
+	}
+	if (!has_failed && std::fflush(file) != 0) {
+		std::lock_guard<std::mutex> lock(status_mutex);
+		status.error_message = "Could not write the statistics log";
+	}
+}
+
+//--------------------------------------------------------------------------------
+bool convert_statistics_log_to_csv(const std::string& log_path, const std::string& csv_path, std::string& error_message) {
+	ZoneScopedFrame;
+
+	std::FILE* log_file = std::fopen(log_path.c_str(), "rb");
+	if (!log_file) {
+		error_message = "Could not open " + log_path;
+		return false;
+	}
+	Statistics_Log_Header header;
+	if (std::fread(&header, sizeof(header), 1, log_file) != 1 || header.magic != STATISTICS_LOG_MAGIC) {
+		std::fclose(log_file);
+		error_message = log_path + " is not a statistics log";
+		return false;
+	}
+	if (header.version != STATISTICS_LOG_VERSION || header.record_size != sizeof(Generation_Statistics_Record)) {
+		std::fclose(log_file);
+		error_message = "unsupported statistics log version " + std::to_string(header.version);
+		return false;
+	}
+
+	std::FILE* csv_file = std::fopen(csv_path.c_str(), "w");
+	if (!csv_file) {
+		std::fclose(log_file);
+		error_message = "Could not open " + csv_path + " for writing";
+		return false;
+	}
+	bool is_written = std::fputs("iteration,population,births,deaths,chunks,min_row,min_column,max_row,max_column,seconds\n", csv_file) >= 0;
+
+	std::vector<Generation_Statistics_Record> records(4096);
+	std::size_t number_of_records = 0;
+	while (is_written && (number_of_records = std::fread(records.data(), sizeof(Generation_Statistics_Record), records.size(), log_file)) > 0) {
+		for (std::size_t i = 0; i < number_of_records && is_written; i++) {
+			const Generation_Statistics_Record& record = records[i];
+			is_written = std::fprintf(csv_file, "%llu,%llu,%llu,%llu,%llu,%d,%d,%d,%d,%.9g\n",
+				static_cast<unsigned long long>(record.iteration),
+				static_cast<unsigned long long>(record.population),
+				static_cast<unsigned long long>(record.number_of_births),
+				static_cast<unsigned long long>(record.number_of_deaths),
+				static_cast<unsigned long long>(record.number_of_chunks),
+				record.bounding_box_min_row, record.bounding_box_min_column,
+				record.bounding_box_max_row, record.bounding_box_max_column,
+				record.seconds) > 0;
+		}
+	}
+	bool is_read = !std::ferror(log_file);
+	std::fclose(log_file);
+	is_written = std::fclose(csv_file) == 0 && is_written;
+	if (!is_read) {
+		error_message = "Could not read " + log_path;
+		return false;
+	}
+	if (!is_written) {
+		error_message = "Could not write " + csv_path;
+		return false;
+	}
+	return true;
+}
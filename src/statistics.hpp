@@ -0,0 +1,108 @@
+#pragma once
+
+#include "profiling.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Grid;
+
+
+//--------------------------------------------------------------------------------
+// Binary log of per generation metrics, for population curves and soup census. The layout is
+// - Statistics_Log_Header
+// - one Generation_Statistics_Record per logged generation
+// All values are stored little endian. convert_statistics_log_to_csv() turns a log into a CSV file.
+constexpr static std::uint32_t STATISTICS_LOG_VERSION = 1;
+
+struct Statistics_Log_Header {
+	std::array<char, 8> magic;
+	std::uint32_t version;
+	std::uint32_t record_size;
+};
+static_assert(sizeof(Statistics_Log_Header) == 16);
+
+struct Generation_Statistics_Record {
+	std::uint64_t iteration;
+	std::uint64_t population;
+	std::uint64_t number_of_births;
+	std::uint64_t number_of_deaths;
+	std::uint64_t number_of_chunks;
+	// the inclusive bounding box of the alive cells, see Grid_Bounding_Box. All 0 if the population is 0.
+	std::int32_t bounding_box_min_row;
+	std::int32_t bounding_box_min_column;
+	std::int32_t bounding_box_max_row;
+	std::int32_t bounding_box_max_column;
+	// wall clock seconds of the generation, see Grid_Phase_Timings.
+	double seconds;
+};
+static_assert(sizeof(Generation_Statistics_Record) == 64);
+
+struct Statistics_Log_Status {
+	std::uint64_t number_of_records = 0;
+	// how often record() found the ring buffer full and had to wait for the writer.
+	std::uint64_t number_of_full_buffer_waits = 0;
+	// error of the writer, the log stops at the first one.
+	std::string error_message;
+};
+
+//--------------------------------------------------------------------------------
+// Logs a record per generation without doing any I/O on the simulation thread. record() copies the statistics of the
+// grid into a single producer single consumer ring buffer, which only costs two atomic operations. A background thread
+// drains the buffer in batches into a buffered file. If the writer falls behind by a whole buffer, record() waits
+// instead of dropping generations.
+class Grid_Statistics_Log {
+public:
+	Grid_Statistics_Log();
+
+	// flushes and closes the log.
+	~Grid_Statistics_Log();
+
+	Grid_Statistics_Log(const Grid_Statistics_Log&) = delete;
+
+	Grid_Statistics_Log& operator = (const Grid_Statistics_Log&) = delete;
+
+	// creates path and starts the writer thread.
+	bool open(const std::string& path, std::string& error_message);
+
+	// writes everything recorded so far and closes the file. Returns false if the writer failed.
+	bool close(std::string& error_message);
+
+	bool is_open() const;
+
+	// call after every generation, from a single thread. With Grid::temporal_block_size K > 1 it gets called once per
+	// K generations, the records then step K iterations and their births and deaths count over the whole block.
+	void record(const Grid& grid);
+
+	Statistics_Log_Status get_status() const;
+
+private:
+	void run_writer();
+	//--------------------------------------------------------------------------------
+	// data
+	constexpr static std::size_t RING_BUFFER_SIZE = 1 << 16;
+	constexpr static std::size_t WRITE_BATCH_SIZE = 1 << 12;
+
+	std::vector<Generation_Statistics_Record> ring_buffer;
+	// only written by record() and by the writer thread respectively, on their own cache lines.
+	alignas(64) std::atomic<std::uint64_t> write_index;
+	alignas(64) std::atomic<std::uint64_t> read_index;
+	alignas(64) std::atomic<bool> should_stop;
+	std::atomic<std::uint64_t> number_of_full_buffer_waits;
+
+	std::FILE* file;
+	std::thread writer_thread;
+
+	mutable std::mutex status_mutex;
+	Statistics_Log_Status status;
+};
+
+//--------------------------------------------------------------------------------
+// writes the records of the binary log at log_path as CSV with a header line to csv_path.
+bool convert_statistics_log_to_csv(const std::string& log_path, const std::string& csv_path, std::string& error_message);
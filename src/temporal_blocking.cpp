@@ -0,0 +1,96 @@
+#include "temporal_blocking.hpp"
+
+
+//--------------------------------------------------------------------------------
+static_assert(Chunk::rows == 32 && Chunk::columns == 32);
+
+// a zero row above the tile, up to 32 + 2 * 16 tile rows and enough rows below, so that the groups of four rows at
+// the end of the tile never read or write past the buffer.
+constexpr static int TILE_BUFFER_ROWS = 1 + Chunk::rows + 2 * MAXIMUM_TEMPORAL_BLOCK_SIZE + 8;
+
+// bit j of a tile row is the cell in column j - K of the chunk, bit 0 is the leftmost cell of the halo. Every 64 bit
+// lane holds a row, so one __m256i advances four rows at once.
+static __m256i get_next_generation(__m256i up, __m256i middle, __m256i down) {
+	// the number of alive cells among each cell and its left and right neighbour (0 to 3), as two bit planes.
+	auto add_horizontally = [](__m256i row, __m256i& ones, __m256i& twos) {
+		__m256i left = _mm256_slli_epi64(row, 1);
+		__m256i right = _mm256_srli_epi64(row, 1);
+		__m256i left_xor_row = _mm256_xor_si256(left, row);
+		ones = _mm256_xor_si256(left_xor_row, right);
+		twos = _mm256_or_si256(_mm256_and_si256(left, row), _mm256_and_si256(right, left_xor_row));
+	};
+	__m256i up_ones, up_twos, middle_ones, middle_twos, down_ones, down_twos;
+	add_horizontally(up, up_ones, up_twos);
+	add_horizontally(middle, middle_ones, middle_twos);
+	add_horizontally(down, down_ones, down_twos);
+
+	// adds the three 2 bit numbers to the 3x3 sum (0 to 9, the cell itself included) with the bit planes 1, 2, 4 and 8.
+	__m256i up_xor_middle_ones = _mm256_xor_si256(up_ones, middle_ones);
+	__m256i sum_1 = _mm256_xor_si256(up_xor_middle_ones, down_ones);
+	__m256i carry_1 = _mm256_or_si256(_mm256_and_si256(up_ones, middle_ones), _mm256_and_si256(down_ones, up_xor_middle_ones));
+
+	__m256i up_xor_middle_twos = _mm256_xor_si256(up_twos, middle_twos);
+	__m256i twos = _mm256_xor_si256(up_xor_middle_twos, down_twos);
+	__m256i fours = _mm256_or_si256(_mm256_and_si256(up_twos, middle_twos), _mm256_and_si256(down_twos, up_xor_middle_twos));
+
+	__m256i sum_2 = _mm256_xor_si256(twos, carry_1);
+	__m256i carry_2 = _mm256_and_si256(twos, carry_1);
+	__m256i sum_4 = _mm256_xor_si256(fours, carry_2);
+	__m256i sum_8 = _mm256_and_si256(fours, carry_2);
+
+	// a cell lives if the sum is 3 (born or two neighbours) or if it is 4 and the cell is alive (three neighbours).
+	__m256i sum_is_3 = _mm256_andnot_si256(sum_4, _mm256_and_si256(sum_1, sum_2));
+	__m256i sum_is_4 = _mm256_andnot_si256(_mm256_or_si256(sum_1, sum_2), sum_4);
+	__m256i is_alive = _mm256_or_si256(sum_is_3, _mm256_and_si256(sum_is_4, middle));
+	return _mm256_andnot_si256(sum_8, is_alive);
+}
+
+Chunk::Row_Bits advance_temporal_block(const Temporal_Block_Neighbourhood& neighbourhood, int number_of_generations) {
+	ZoneScopedChunk;
+
+	const int K = number_of_generations;
+	const int number_of_tile_rows = Chunk::rows + 2 * K;
+	const std::uint64_t halo_mask = (std::uint64_t(1) << K) - 1;
+
+	alignas(32) std::array<std::uint64_t, TILE_BUFFER_ROWS> tile_buffers[2] = {};
+	std::uint64_t* tile = tile_buffers[0].data() + 1;
+	for (int t = 0; t < number_of_tile_rows; t++) {
+		int chunk_row = t - K;
+		int block_row = 1;
+		if (chunk_row < 0) {
+			block_row = 0;
+			chunk_row += Chunk::rows;
+		} else if (chunk_row >= Chunk::rows) {
+			block_row = 2;
+			chunk_row -= Chunk::rows;
+		}
+		const Chunk::Row_Bits* left = neighbourhood[block_row * 3];
+		const Chunk::Row_Bits* center = neighbourhood[block_row * 3 + 1];
+		const Chunk::Row_Bits* right = neighbourhood[block_row * 3 + 2];
+		std::uint64_t left_row = left ? (*left)[chunk_row] : 0;
+		std::uint64_t center_row = center ? (*center)[chunk_row] : 0;
+		std::uint64_t right_row = right ? (*right)[chunk_row] : 0;
+		tile[t] = (left_row >> (Chunk::columns - K)) | (center_row << K) | ((right_row & halo_mask) << (Chunk::columns + K));
+	}
+
+	// after generation g only the rows [g, number_of_tile_rows - 1 - g] are still exact, so we only compute those. The
+	// columns shrink the same way, their wrong values just never reach the center.
+	for (int generation = 1; generation <= K; generation++) {
+		const std::uint64_t* previous_tile = tile_buffers[(generation - 1) & 1].data() + 1;
+		std::uint64_t* next_tile = tile_buffers[generation & 1].data() + 1;
+		int last_row = number_of_tile_rows - 1 - generation;
+		for (int t = generation; t <= last_row; t += 4) {
+			__m256i up = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&previous_tile[t - 1]));
+			__m256i middle = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&previous_tile[t]));
+			__m256i down = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&previous_tile[t + 1]));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(&next_tile[t]), get_next_generation(up, middle, down));
+		}
+	}
+
+	const std::uint64_t* result_tile = tile_buffers[K & 1].data() + 1;
+	Chunk::Row_Bits row_bits;
+	for (int r = 0; r < Chunk::rows; r++) {
+		row_bits[r] = static_cast<std::uint32_t>(result_tile[K + r] >> K);
+	}
+	return row_bits;
+}
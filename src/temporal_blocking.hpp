@@ -0,0 +1,23 @@
+#pragma once
+
+#include "profiling.hpp"
+#include "chunk.hpp"
+
+#include <array>
+#include <cstdint>
+
+
+//--------------------------------------------------------------------------------
+// Temporal blocking: instead of exchanging the chunk borders every generation, a chunk gets advanced K generations at
+// once on a tile which includes a halo of K cells from its 8 neighbours. Cells can only influence cells at most one
+// cell away per generation, so after K generations the inner 32x32 cells of the tile are still exact, while the wrong
+// values from outside the tile have crept K cells inwards. With K <= 16 every tile row fits into 64 bits.
+constexpr static int MAXIMUM_TEMPORAL_BLOCK_SIZE = 16;
+
+// The row bits of a chunk and of its 8 neighbours, in row major order with the chunk itself at index 4. Missing
+// neighbours are nullptr and count as empty.
+using Temporal_Block_Neighbourhood = std::array<const Chunk::Row_Bits*, 9>;
+
+// returns the row bits of the chunk in the center of neighbourhood after number_of_generations generations, which has
+// to be in [1, MAXIMUM_TEMPORAL_BLOCK_SIZE].
+Chunk::Row_Bits advance_temporal_block(const Temporal_Block_Neighbourhood& neighbourhood, int number_of_generations);
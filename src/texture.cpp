@@ -13,7 +13,7 @@ Texture::Texture(std::string texture_name, GLenum identifier, std::string textur
 }
 
 void Texture::bind() {
-	ZoneScoped;
+	ZoneScopedFrame;
 	glGenTextures(1, &id);
 	glBindTexture(GL_TEXTURE_2D, id);
 
@@ -37,7 +37,7 @@ void Texture::bind() {
 
 
 void Texture::load_data_from_file() {	
-	ZoneScoped;
+	ZoneScopedFrame;
 
 	unsigned char* image_data = load_image_from_file(data_path, &texture_data.width, &texture_data.height, &texture_data.number_of_channels);
 		
@@ -51,7 +51,7 @@ void Texture::load_data_from_file() {
 
 //--------------------------------------------------------------------------------
 void Texture_Catalog::load_and_bind_all_textures(std::vector<std::string>& texture_file_paths) {
-	ZoneScoped;
+	ZoneScopedFrame;
 
 	textures.clear();
 	textures.reserve(texture_file_paths.size());
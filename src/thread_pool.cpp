@@ -0,0 +1,94 @@
+#include "thread_pool.hpp"
+
+//--------------------------------------------------------------------------------
+Thread_Pool::Thread_Pool(unsigned int number_of_threads) :
+	current_task(nullptr),
+number_of_tasks(0),
+next_task_index(0),
+batch_id(0),
+number_of_workers_still_running(0),
+should_stop(false)
+{
+	ZoneScopedFrame;
+
+	if (number_of_threads == 0) {
+		number_of_threads = 1;
+	}
+	for (unsigned int i = 1; i < number_of_threads; i++) {
+		workers.emplace_back(&Thread_Pool::worker_loop, this);
+	}
+}
+
+Thread_Pool::~Thread_Pool() {
+	ZoneScopedFrame;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		should_stop = true;
+	}
+	work_available_condition.notify_all();
+	for (std::thread& worker: workers) {
+		worker.join();
+	}
+}
+
+unsigned int Thread_Pool::get_number_of_threads() const {
+	return static_cast<unsigned int>(workers.size()) + 1;
+}
+
+void Thread_Pool::run_available_tasks() {
+	std::size_t task_index = next_task_index.fetch_add(1);
+	while (task_index < number_of_tasks) {
+		(*current_task)(task_index);
+		task_index = next_task_index.fetch_add(1);
+	}
+}
+
+void Thread_Pool::run_tasks(std::size_t a_number_of_tasks, const std::function<void(std::size_t)>& task) {
+	ZoneScopedPhase;
+
+	if (workers.empty() || a_number_of_tasks <= 1) {
+		for (std::size_t task_index = 0; task_index < a_number_of_tasks; task_index++) {
+			task(task_index);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		current_task = &task;
+		number_of_tasks = a_number_of_tasks;
+		next_task_index = 0;
+		number_of_workers_still_running = static_cast<unsigned int>(workers.size());
+		batch_id++;
+	}
+	work_available_condition.notify_all();
+
+	run_available_tasks();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	work_done_condition.wait(lock, [this] { return number_of_workers_still_running == 0; });
+	current_task = nullptr;
+}
+
+void Thread_Pool::worker_loop() {
+	std::uint64_t last_batch_id = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			work_available_condition.wait(lock, [this, last_batch_id] { return should_stop || batch_id != last_batch_id; });
+			if (should_stop) {
+				return;
+			}
+			last_batch_id = batch_id;
+		}
+
+		run_available_tasks();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			number_of_workers_still_running--;
+		}
+		work_done_condition.notify_one();
+	}
+}
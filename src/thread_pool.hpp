@@ -0,0 +1,55 @@
+#pragma once
+
+#include "profiling.hpp"
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+
+
+//--------------------------------------------------------------------------------
+// A minimal fork-join thread pool. The worker threads are created once and sleep between calls of run_tasks(), so
+// that we do not pay for thread creation in every phase of every grid iteration.
+class Thread_Pool {
+public:
+	// number_of_threads includes the calling thread, so a pool with a single thread runs everything inline.
+	explicit Thread_Pool(unsigned int number_of_threads);
+
+	~Thread_Pool();
+
+	Thread_Pool(const Thread_Pool&) = delete;
+
+	Thread_Pool& operator = (const Thread_Pool&) = delete;
+
+	// runs task(i) for every i in [0, number_of_tasks) on the workers and the calling thread. Returns once all tasks
+	// are finished.
+	void run_tasks(std::size_t number_of_tasks, const std::function<void(std::size_t)>& task);
+
+	unsigned int get_number_of_threads() const;
+
+private:
+	void worker_loop();
+
+	void run_available_tasks();
+	//--------------------------------------------------------------------------------
+	// data
+	std::vector<std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable work_available_condition;
+	std::condition_variable work_done_condition;
+
+	const std::function<void(std::size_t)>* current_task;
+	std::size_t number_of_tasks;
+	std::atomic<std::size_t> next_task_index;
+
+	// gets incremented for every call of run_tasks(), the workers use it to tell a new batch of tasks apart from a
+	// spurious wakeup.
+	std::uint64_t batch_id;
+	unsigned int number_of_workers_still_running;
+	bool should_stop;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "profiling.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+
+//--------------------------------------------------------------------------------
+// Hands the latest value from a single writer thread to a single reader thread without locks and without either of
+// them ever waiting. The writer fills its buffer and swaps it with the middle one, the reader swaps the middle buffer
+// with its own when a new one got published. Values which the reader misses are simply overwritten. The buffers get
+// reused, so a T holding vectors stops allocating once they reached their size.
+template <typename T>
+class Triple_Buffer {
+public:
+	Triple_Buffer() :
+		buffers({}),
+	write_index(0),
+	middle_index(1),
+	read_index(2)
+	{
+
+	}
+
+	Triple_Buffer(const Triple_Buffer&) = delete;
+
+	Triple_Buffer& operator = (const Triple_Buffer&) = delete;
+
+	// writer side, the buffer stays untouched by the reader until the next publish().
+	T& get_write_buffer() {
+		return buffers[write_index];
+	}
+
+	void publish() {
+		std::uint8_t previous_middle_index = middle_index.exchange(write_index | HAS_NEW_VALUE_BIT, std::memory_order_acq_rel);
+		write_index = previous_middle_index & INDEX_MASK;
+	}
+
+	// writer side, false while the last published value still waits for the reader.
+	bool was_last_value_read() const {
+		return (middle_index.load(std::memory_order_acquire) & HAS_NEW_VALUE_BIT) == 0;
+	}
+
+	// reader side, takes the latest published value if there is one. Returns true if get_read_buffer() changed.
+	bool update_read_buffer() {
+		if ((middle_index.load(std::memory_order_relaxed) & HAS_NEW_VALUE_BIT) == 0) {
+			return false;
+		}
+		std::uint8_t previous_middle_index = middle_index.exchange(read_index, std::memory_order_acq_rel);
+		read_index = previous_middle_index & INDEX_MASK;
+		return true;
+	}
+
+	const T& get_read_buffer() const {
+		return buffers[read_index];
+	}
+
+private:
+	constexpr static std::uint8_t INDEX_MASK = 3;
+	constexpr static std::uint8_t HAS_NEW_VALUE_BIT = 4;
+	//--------------------------------------------------------------------------------
+	// data
+	std::array<T, 3> buffers;
+	std::uint8_t write_index;
+	// the index of the buffer in between, with HAS_NEW_VALUE_BIT set from publish() until the reader takes it.
+	alignas(64) std::atomic<std::uint8_t> middle_index;
+	alignas(64) std::uint8_t read_index;
+};
@@ -12,7 +12,7 @@ UI_State::UI_State() :
 
 //--------------------------------------------------------------------------------
 UI_State::~UI_State() {
-	ZoneScoped;
+	ZoneScopedFrame;
 	
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplGlfw_Shutdown();
@@ -21,7 +21,7 @@ UI_State::~UI_State() {
 
 //--------------------------------------------------------------------------------
 void UI_State::initialise(GLFWwindow* window) {
-	ZoneScoped;
+	ZoneScopedFrame;
 
 	m_window = window;
 	
@@ -35,15 +35,15 @@ void UI_State::initialise(GLFWwindow* window) {
 
 //--------------------------------------------------------------------------------
 bool UI_State::wants_to_capture_io() {
-	ZoneScoped;
+	ZoneScopedFrame;
 	
 	ImGuiIO& io = ImGui::GetIO(); (void) io;
 	return io.WantTextInput || io.WantSetMousePos || io.WantCaptureMouse || io.WantCaptureKeyboard || io.WantSaveIniSettings || io.WantCaptureMouseUnlessPopupClose;
 }
 
 //--------------------------------------------------------------------------------
-void UI_State::setup_ui_for_current_frame(const Grid_Info& grid_info) {
-	ZoneScoped;
+void UI_State::setup_ui_for_current_frame(const Grid_Info& grid_info, const Render_Info& render_info) {
+	ZoneScopedFrame;
 
 	const ImGuiViewport* viewport = ImGui::GetMainViewport();
 	const ImVec2 base_pos = viewport->Pos;
@@ -106,7 +106,63 @@ void UI_State::setup_ui_for_current_frame(const Grid_Info& grid_info) {
 		ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
 
 		ImGui::Text("Grid iteration: %d", grid_info.iteration);
+		ImGui::Text("Simulation: %.1f generations/s", grid_info.simulation_generations_per_second);
 		ImGui::Text("Number of chunks: %d", grid_info.number_of_chunks);
+		ImGui::Text("Visible: %lld of %lld chunks (%lld culled), %lld cells drawn as cubes", render_info.number_of_visible_chunks, render_info.number_of_chunks, render_info.number_of_chunks - render_info.number_of_visible_chunks, render_info.number_of_cube_cells);
+		ImGui::Text("Level of detail: %lld chunks zoomed out, drawn as %lld quads", render_info.number_of_level_of_detail_chunks, render_info.number_of_level_of_detail_quads);
+		if (render_info.is_expanding_cells_on_gpu) {
+			ImGui::Text("Uploaded: %lld chunks in the last update (as bitmaps)", render_info.number_of_uploaded_chunks);
+		} else {
+			ImGui::Text("Uploaded: %lld chunks in %lld uploads in the last update", render_info.number_of_uploaded_chunks, render_info.number_of_uploads);
+		}
+		ImGui::Text("Population: %lld", grid_info.population);
+		ImGui::Text("Births: %lld, deaths: %lld in the last iteration", grid_info.number_of_births, grid_info.number_of_deaths);
+		if (grid_info.has_bounding_box) {
+			ImGui::Text("Bounding box: rows %d to %d, columns %d to %d (%d x %d cells)",
+				grid_info.bounding_box_min_row, grid_info.bounding_box_max_row, grid_info.bounding_box_min_column, grid_info.bounding_box_max_column,
+				grid_info.bounding_box_max_row - grid_info.bounding_box_min_row + 1, grid_info.bounding_box_max_column - grid_info.bounding_box_min_column + 1);
+		} else {
+			ImGui::Text("Bounding box: empty");
+		}
+
+		ImGui::InputText("Pattern file (used by Reset)", ui_info.pattern_path.data(), ui_info.pattern_path.size());
+		if (!grid_info.pattern_load_error.empty()) {
+			ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", grid_info.pattern_load_error.c_str());
+		}
+
+		ImGui::Checkbox("Write checkpoints", &ui_info.should_write_checkpoints);
+		if (ui_info.should_write_checkpoints) {
+			ImGui::InputInt("Checkpoint every N iterations", &ui_info.checkpoint_interval);
+			ImGui::InputInt("Checkpoints to keep", &ui_info.checkpoint_retention);
+			ImGui::InputInt("Checkpoint memory in MB (0: no bound)", &ui_info.checkpoint_memory_mb);
+			ImGui::InputText("Checkpoint directory", ui_info.checkpoint_directory.data(), ui_info.checkpoint_directory.size());
+			ImGui::Text("Checkpoints: every %d iterations, keeping %d, %d written", grid_info.checkpoint_interval, grid_info.checkpoint_retention, grid_info.number_of_checkpoints);
+			if (grid_info.number_of_checkpoints > 0) {
+				ImGui::Text("Last checkpoint: iteration %d, capture %.2f ms, latency %.1f ms%s", grid_info.last_checkpoint_iteration, grid_info.last_checkpoint_capture_ms, grid_info.last_checkpoint_latency_ms, grid_info.is_checkpoint_being_written ? " (writing)" : "");
+			}
+			if (!grid_info.checkpoint_error.empty()) {
+				ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", grid_info.checkpoint_error.c_str());
+			}
+		}
+
+		ImGui::Checkbox("Record history", &ui_info.should_record_history);
+		if (ui_info.should_record_history) {
+			ImGui::InputInt("Keyframe every N iterations", &ui_info.history_keyframe_interval);
+			ImGui::InputInt("History memory budget (MB)", &ui_info.history_memory_budget_mb);
+			ImGui::Text("History: iterations %d to %d, %d keyframes, %.1f MB (%.1fx compressed)", grid_info.history_first_iteration, grid_info.history_last_iteration, grid_info.history_number_of_keyframes, grid_info.history_memory_mb, grid_info.history_compression_ratio);
+			if (ImGui::Button("Step back")) {
+				ui_info.button_type = GRID_STEP_BACK_BUTTON_PRESSED;
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("Seek")) {
+				ui_info.button_type = GRID_SEEK_BUTTON_PRESSED;
+			}
+			ImGui::SameLine();
+			ImGui::InputInt("Seek to iteration", &ui_info.history_seek_iteration);
+			if (!grid_info.history_error.empty()) {
+				ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", grid_info.history_error.c_str());
+			}
+		}
 
 		ImGuiSliderFlags slider_flags = ImGuiSliderFlags_AlwaysClamp;
 		slider_flags |= ImGuiSliderFlags_NoInput;
@@ -117,12 +173,32 @@ void UI_State::setup_ui_for_current_frame(const Grid_Info& grid_info) {
 
 		bool show_chunk_borders_checkbox_changed = ImGui::Checkbox("Show chunk borders", &ui_info.show_chunk_borders); 
 
+		ImGui::Checkbox("Expand cells on the GPU", &ui_info.should_expand_cells_on_gpu);
+
+		ImGui::Checkbox("Draw zoomed out chunks as density quads", &ui_info.should_use_level_of_detail);
+		if (ui_info.should_use_level_of_detail) {
+			ImGui::SliderFloat("Cubes down to", &ui_info.level_of_detail_pixels_per_cell, ui_info.min_level_of_detail_pixels_per_cell, ui_info.max_level_of_detail_pixels_per_cell, "%.2f pixels per cell", slider_flags);
+		}
+
 		bool run_grid_at_max_possible_speed_checkbox_changed = ImGui::Checkbox("Run simulation at maximal speed", &ui_info.run_grid_at_max_possible_speed);
 
 		bool number_of_grid_iterations_per_single_frame_slider_changed = ImGui::SliderInt(
 			"Update screen every %d iterations", 
 			&ui_info.number_of_grid_iterations_per_single_frame, ui_info.min_number_of_grid_iterations_per_single_frame, ui_info.max_number_of_grid_iterations_per_single_frame, "%d Iterations per frame", slider_flags);
 
+		ImGui::SliderInt("Temporal blocking", &ui_info.temporal_block_size, ui_info.min_temporal_block_size, ui_info.max_temporal_block_size, "%d generations per iteration", slider_flags);
+		if (ui_info.temporal_block_size > 1) {
+			ImGui::Text("History, checkpoints and statistics only see every %d-th generation", ui_info.temporal_block_size);
+		}
+
+		bool use_time_budget_checkbox_changed = ImGui::Checkbox("Fit iterations into a time budget", &ui_info.should_use_time_budget);
+		if (ui_info.should_use_time_budget) {
+			ImGui::SliderFloat("Time budget per update", &ui_info.time_budget_ms, ui_info.min_time_budget_ms, ui_info.max_time_budget_ms, "%.1f ms", slider_flags);
+			if (grid_info.is_using_time_budget) {
+				ImGui::Text("%d iterations per update, %.3f ms per iteration", grid_info.iterations_per_time_budget, grid_info.estimated_ms_per_iteration);
+			}
+		}
+
 		if (ui_info.m_show_demo_window) {
 			ImGui::ShowDemoWindow(&ui_info.m_show_demo_window);
 		}
@@ -138,14 +214,21 @@ void UI_State::setup_ui_for_current_frame(const Grid_Info& grid_info) {
 			if (ui_info.grid_speed_slider_value < ui_info.max_grid_speed_slider_value) {
 				ui_info.run_grid_at_max_possible_speed = false;
 				ui_info.number_of_grid_iterations_per_single_frame = ui_info.min_number_of_grid_iterations_per_single_frame;
+				ui_info.should_use_time_budget = false;
 			}
 		}
 		if (run_grid_at_max_possible_speed_checkbox_changed) {
 			if (ui_info.run_grid_at_max_possible_speed) {
 				// set slider to max if the user ticks the max speed checkbox to true
 				ui_info.grid_speed_slider_value = ui_info.max_grid_speed_slider_value;
+			} else {
+				ui_info.should_use_time_budget = false;
 			}
 		}
+		if (use_time_budget_checkbox_changed && ui_info.should_use_time_budget) {
+			// the time budget replaces the fixed number of iterations per frame, which only exists at max speed.
+			ui_info.run_grid_at_max_possible_speed = true;
+		}
 		if (number_of_grid_iterations_per_single_frame_slider_changed) {
 			if (ui_info.number_of_grid_iterations_per_single_frame > ui_info.min_number_of_grid_iterations_per_single_frame) {
 				// set simulation to max speed when we want to run more than a single iteration per frame, we only allow it like this.
@@ -170,12 +253,12 @@ void UI_State::setup_ui_for_current_frame(const Grid_Info& grid_info) {
 	}
 }
 
-void UI_State::update(const Grid_Info& grid_info) {
-	ZoneScoped;
+void UI_State::update(const Grid_Info& grid_info, const Render_Info& render_info) {
+	ZoneScopedFrame;
 	
 	ImGui_ImplOpenGL3_NewFrame();
 	ImGui_ImplGlfw_NewFrame();
 	ImGui::NewFrame();
 	
-	setup_ui_for_current_frame(grid_info);
+	setup_ui_for_current_frame(grid_info, render_info);
 }
\ No newline at end of file
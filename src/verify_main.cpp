@@ -0,0 +1,1279 @@
+#include "profiling.hpp"
+
+//--------------------------------------------------------------------------------
+// Differential verification of the optimised engine against the scalar Reference_Grid. We run random soups and fuzz
+// cases which concentrate cells around chunk borders and corners through Grid in every engine mode and through the
+// reference in lockstep, compare the alive cells after every generation and report the first divergence. The chunk
+// kernels additionally get checked one by one against scalar neighbour counting on random chunks, and a small corpus of
+// well known patterns gets checked against known populations and checksums. Grid_History gets checked by seeking to
+// recorded generations and comparing their checksums with the ones of the original run. The pattern file loaders get
+// checked by running a pattern loaded from every format against the same pattern created directly, and by feeding them
+// malformed files. The copy-on-write checkpoints of Grid_Checkpointer get loaded and compared with the generations they
+// got captured at. Grid_Simulation_Thread gets driven through its command queue and its published snapshots get
+// checked against a synchronous run.
+#include <iostream>
+#include <string>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <cstdlib>
+#include <limits>
+#include <deque>
+#include <fstream>
+#include <filesystem>
+#include <iterator>
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+#include <thread>
+
+#include "grid.hpp"
+#include "reference_grid.hpp"
+#include "patterns.hpp"
+#include "history.hpp"
+#include "pattern_io.hpp"
+#include "macrocell.hpp"
+#include "snapshot.hpp"
+#include "checkpoint.hpp"
+#include "simulation_thread.hpp"
+#include "checksum.hpp"
+
+int main(int argc, char** argv);
+
+//--------------------------------------------------------------------------------
+struct Verify_Options {
+	std::uint32_t seed = 1;
+	int number_of_soups = 8;
+	std::size_t soup_generations = 2000;
+	int number_of_fuzz_cases = 200;
+	std::size_t fuzz_generations = 200;
+	int number_of_kernel_cases = 2000;
+	std::size_t history_generations = 600;
+	// only validate the known pattern corpus, skip the kernel checks and the random cases.
+	bool should_only_verify_corpus = false;
+	// print population and checksum of every corpus entry as computed by the reference, to add new entries.
+	bool should_print_corpus = false;
+};
+
+// one way of configuring Grid, every case runs through all of them.
+struct Engine_Mode {
+	std::string name;
+	unsigned int number_of_threads;
+	std::size_t minimum_number_of_chunks_per_task;
+	bool should_update_coordinates;
+	int temporal_block_size;
+};
+
+// a well known pattern and its state after a number of generations. Where the literature has a number we use it (eg the
+// R-pentomino stabilises at generation 1103 with 116 cells, the diehard dies at generation 130), everything else got
+// recorded from the reference with --print-corpus. The checksums are Grid::compute_checksum().
+struct Corpus_Entry {
+	std::string pattern;
+	std::size_t generation;
+	std::size_t population;
+	std::uint64_t checksum;
+};
+
+struct Verify_Case {
+	std::string description;
+	std::vector<std::pair<int, int>> alive_cells;
+	std::size_t number_of_generations;
+};
+
+void print_usage();
+bool parse_options(int argc, char** argv, Verify_Options& options);
+std::vector<Engine_Mode> get_engine_modes();
+Verify_Case create_soup_case(int case_index, std::mt19937& random_engine, std::size_t number_of_generations);
+Verify_Case create_chunk_border_fuzz_case(int case_index, std::mt19937& random_engine, std::size_t number_of_generations);
+std::vector<std::pair<int, int>> get_cells_from_render_coordinates(const Grid& grid);
+void print_difference(const std::vector<std::pair<int, int>>& cells, const std::vector<std::pair<int, int>>& expected_cells);
+bool verify_generation_statistics(const Grid_Generation_Statistics& statistics, const std::vector<std::pair<int, int>>& previous_cells, const std::vector<std::pair<int, int>>& cells);
+bool verify_case(const Verify_Case& verify_case, const std::vector<Engine_Mode>& engine_modes);
+bool verify_chunk_kernels(const Verify_Options& options);
+std::vector<Corpus_Entry> get_corpus();
+bool verify_corpus(const std::vector<Engine_Mode>& engine_modes, bool should_print_corpus);
+bool verify_history(const Verify_Options& options);
+bool write_text_file(const std::filesystem::path& path, const std::string& text);
+bool verify_pattern_files(const std::filesystem::path& directory);
+bool verify_macrocell_files(const std::filesystem::path& directory, std::uint32_t seed);
+bool verify_snapshot_files(const std::filesystem::path& directory, std::uint32_t seed);
+bool verify_checkpoints(const std::filesystem::path& directory, std::uint32_t seed);
+std::uint64_t compute_render_snapshot_checksum(const Render_Snapshot& snapshot);
+bool verify_simulation_thread(const std::filesystem::path& directory, std::uint32_t seed);
+
+//--------------------------------------------------------------------------------
+void print_usage() {
+	std::cout << "Usage: grid_of_life_verify [options]\n"
+		<< "  --seed N               seed of the random cases (default 1)\n"
+		<< "  --soups N              number of random soups (default 8)\n"
+		<< "  --soup-generations N   generations per soup (default 2000)\n"
+		<< "  --fuzz N               number of chunk border fuzz cases (default 200)\n"
+		<< "  --fuzz-generations N   generations per fuzz case (default 200)\n"
+		<< "  --kernel-cases N       number of random chunks for the kernel checks (default 2000)\n"
+		<< "  --history-generations N  generations of the history check (default 600)\n"
+		<< "  --corpus-only          only validate the corpus of known patterns\n"
+		<< "  --print-corpus         print population and checksum of the corpus entries as computed by the reference\n";
+}
+
+bool parse_options(int argc, char** argv, Verify_Options& options) {
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		if (argument == "--help" || argument == "-h") {
+			return false;
+		}
+		if (argument == "--corpus-only") {
+			options.should_only_verify_corpus = true;
+			continue;
+		}
+		if (argument == "--print-corpus") {
+			options.should_print_corpus = true;
+			continue;
+		}
+		if (i + 1 >= argc) {
+			std::cout << "Missing value for option " << argument << std::endl;
+			return false;
+		}
+		std::string value = argv[++i];
+		if (argument == "--seed") {
+			options.seed = static_cast<std::uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+		} else if (argument == "--soups") {
+			options.number_of_soups = std::atoi(value.c_str());
+		} else if (argument == "--soup-generations") {
+			options.soup_generations = std::strtoull(value.c_str(), nullptr, 10);
+		} else if (argument == "--fuzz") {
+			options.number_of_fuzz_cases = std::atoi(value.c_str());
+		} else if (argument == "--fuzz-generations") {
+			options.fuzz_generations = std::strtoull(value.c_str(), nullptr, 10);
+		} else if (argument == "--kernel-cases") {
+			options.number_of_kernel_cases = std::atoi(value.c_str());
+		} else if (argument == "--history-generations") {
+			options.history_generations = std::strtoull(value.c_str(), nullptr, 10);
+		} else {
+			std::cout << "Unknown option " << argument << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+//--------------------------------------------------------------------------------
+std::vector<Engine_Mode> get_engine_modes() {
+	// the threaded modes allow tasks of a single chunk, so that even small cases get split over several tasks. The
+	// blocked modes only get compared every temporal_block_size generations, an odd block size leaves the last group
+	// of tile rows incomplete.
+	return {
+		{ "serial", 1, 500, false, 1 },
+		{ "serial-coordinates", 1, 500, true, 1 },
+		{ "threads-2", 2, 1, false, 1 },
+		{ "threads-3", 3, 1, false, 1 },
+		{ "threads-8-coordinates", 8, 1, true, 1 },
+		{ "blocked-4", 1, 500, false, 4 },
+		{ "blocked-7-threads-2-coordinates", 2, 1, true, 7 },
+		{ "blocked-16-threads-3", 3, 1, false, 16 }
+	};
+}
+
+Verify_Case create_soup_case(int case_index, std::mt19937& random_engine, std::size_t number_of_generations) {
+	std::uniform_int_distribution<int> size_distribution(8, 100);
+	std::uniform_int_distribution<int> origin_distribution(-150, 100);
+	std::uniform_real_distribution<float> density_distribution(0.15f, 0.6f);
+
+	int height = size_distribution(random_engine);
+	int width = size_distribution(random_engine);
+	int origin_row = origin_distribution(random_engine);
+	int origin_column = origin_distribution(random_engine);
+	float density = density_distribution(random_engine);
+
+	Verify_Case soup_case;
+	std::bernoulli_distribution is_alive_distribution(density);
+	for (int r = 0; r < height; r++) {
+		for (int c = 0; c < width; c++) {
+			if (is_alive_distribution(random_engine)) {
+				soup_case.alive_cells.push_back(std::make_pair(origin_row + r, origin_column + c));
+			}
+		}
+	}
+	std::stringstream description;
+	description << "soup " << case_index << " (" << height << "x" << width << " at (" << origin_row << ", " << origin_column << "), density " << density << ")";
+	soup_case.description = description.str();
+	soup_case.number_of_generations = number_of_generations;
+	return soup_case;
+}
+
+// places a few small clusters of cells right next to chunk borders and chunk corners, which is where the side and
+// corner updates and the lane crossing shifts of the kernels matter.
+Verify_Case create_chunk_border_fuzz_case(int case_index, std::mt19937& random_engine, std::size_t number_of_generations) {
+	std::uniform_int_distribution<int> chunk_distribution(-3, 2);
+	std::uniform_int_distribution<int> number_of_clusters_distribution(1, 4);
+	std::uniform_int_distribution<int> cluster_type_distribution(0, 2);
+	std::uniform_int_distribution<int> number_of_cells_distribution(3, 30);
+	std::uniform_int_distribution<int> near_border_distribution(-3, 2);
+	std::uniform_int_distribution<int> along_border_distribution(-40, 40);
+
+	Verify_Case fuzz_case;
+	int number_of_clusters = number_of_clusters_distribution(random_engine);
+	for (int cluster = 0; cluster < number_of_clusters; cluster++) {
+		int border_row = chunk_distribution(random_engine) * Chunk::rows;
+		int border_column = chunk_distribution(random_engine) * Chunk::columns;
+		// 0: along a horizontal border, 1: along a vertical border, 2: around a corner.
+		int cluster_type = cluster_type_distribution(random_engine);
+		int number_of_cells = number_of_cells_distribution(random_engine);
+		int along_offset = along_border_distribution(random_engine);
+		for (int i = 0; i < number_of_cells; i++) {
+			int row = border_row + near_border_distribution(random_engine);
+			int column = border_column + near_border_distribution(random_engine);
+			if (cluster_type == 0) {
+				column = border_column + along_offset + near_border_distribution(random_engine) * 2;
+			} else if (cluster_type == 1) {
+				row = border_row + along_offset + near_border_distribution(random_engine) * 2;
+			}
+			fuzz_case.alive_cells.push_back(std::make_pair(row, column));
+		}
+	}
+	std::sort(fuzz_case.alive_cells.begin(), fuzz_case.alive_cells.end());
+	fuzz_case.alive_cells.erase(std::unique(fuzz_case.alive_cells.begin(), fuzz_case.alive_cells.end()), fuzz_case.alive_cells.end());
+
+	std::stringstream description;
+	description << "chunk border fuzz " << case_index << " (" << fuzz_case.alive_cells.size() << " cells in " << number_of_clusters << " clusters)";
+	fuzz_case.description = description.str();
+	fuzz_case.number_of_generations = number_of_generations;
+	return fuzz_case;
+}
+
+//--------------------------------------------------------------------------------
+// the render coordinates store (column, -row) per alive cell, see Chunk::update_coordinates_of_alive_cells().
+std::vector<std::pair<int, int>> get_cells_from_render_coordinates(const Grid& grid) {
+	std::vector<std::pair<int, int>> cells;
+	for (const Chunk& chunk: grid.chunks) {
+		for (unsigned int i = 0; i < chunk.number_of_alive_cells; i++) {
+			auto [x, y] = chunk.coordinates_of_alive_cells[i];
+			cells.push_back(std::make_pair(-y, x));
+		}
+	}
+	std::sort(cells.begin(), cells.end());
+	return cells;
+}
+
+void print_difference(const std::vector<std::pair<int, int>>& cells, const std::vector<std::pair<int, int>>& expected_cells) {
+	constexpr static std::size_t MAXIMUM_NUMBER_OF_PRINTED_CELLS = 10;
+
+	std::vector<std::pair<int, int>> unexpected_cells;
+	std::set_difference(cells.begin(), cells.end(), expected_cells.begin(), expected_cells.end(), std::back_inserter(unexpected_cells));
+	std::vector<std::pair<int, int>> missing_cells;
+	std::set_difference(expected_cells.begin(), expected_cells.end(), cells.begin(), cells.end(), std::back_inserter(missing_cells));
+
+	std::cout << "  population " << cells.size() << ", expected " << expected_cells.size() << std::endl;
+	auto print_cells = [](const std::string& title, const std::vector<std::pair<int, int>>& cells_to_print) {
+		std::cout << "  " << cells_to_print.size() << " " << title << ":";
+		for (std::size_t i = 0; i < cells_to_print.size() && i < MAXIMUM_NUMBER_OF_PRINTED_CELLS; i++) {
+			std::cout << " (" << cells_to_print[i].first << ", " << cells_to_print[i].second << ")";
+		}
+		std::cout << (cells_to_print.size() > MAXIMUM_NUMBER_OF_PRINTED_CELLS ? " ..." : "") << std::endl;
+	};
+	print_cells("cells alive only in Grid", unexpected_cells);
+	print_cells("cells alive only in the reference", missing_cells);
+}
+
+// the cells are sorted, births are the cells alive only now, deaths the cells alive only before. The bounding box has to
+// be the tight box around the cells.
+bool verify_generation_statistics(const Grid_Generation_Statistics& statistics, const std::vector<std::pair<int, int>>& previous_cells, const std::vector<std::pair<int, int>>& cells) {
+	std::vector<std::pair<int, int>> born_cells;
+	std::set_difference(cells.begin(), cells.end(), previous_cells.begin(), previous_cells.end(), std::back_inserter(born_cells));
+	std::vector<std::pair<int, int>> dead_cells;
+	std::set_difference(previous_cells.begin(), previous_cells.end(), cells.begin(), cells.end(), std::back_inserter(dead_cells));
+
+	Grid_Generation_Statistics expected_statistics;
+	expected_statistics.population = cells.size();
+	expected_statistics.number_of_births = born_cells.size();
+	expected_statistics.number_of_deaths = dead_cells.size();
+	Grid_Bounding_Box& expected_box = expected_statistics.bounding_box;
+	if (!cells.empty()) {
+		expected_box.is_empty = false;
+		expected_box.min_row = std::numeric_limits<int>::max();
+		expected_box.min_column = std::numeric_limits<int>::max();
+		expected_box.max_row = std::numeric_limits<int>::min();
+		expected_box.max_column = std::numeric_limits<int>::min();
+	}
+	for (auto [row, column]: cells) {
+		expected_box.min_row = std::min(expected_box.min_row, row);
+		expected_box.min_column = std::min(expected_box.min_column, column);
+		expected_box.max_row = std::max(expected_box.max_row, row);
+		expected_box.max_column = std::max(expected_box.max_column, column);
+	}
+
+	const Grid_Bounding_Box& box = statistics.bounding_box;
+	bool is_equal = statistics.population == expected_statistics.population
+		&& statistics.number_of_births == expected_statistics.number_of_births
+		&& statistics.number_of_deaths == expected_statistics.number_of_deaths
+		&& box.is_empty == expected_box.is_empty
+		&& (box.is_empty || (box.min_row == expected_box.min_row && box.min_column == expected_box.min_column
+			&& box.max_row == expected_box.max_row && box.max_column == expected_box.max_column));
+	if (!is_equal) {
+		std::cout << "  population " << statistics.population << ", expected " << expected_statistics.population
+			<< " | births " << statistics.number_of_births << ", expected " << expected_statistics.number_of_births
+			<< " | deaths " << statistics.number_of_deaths << ", expected " << expected_statistics.number_of_deaths << std::endl;
+		std::cout << "  bounding box (" << box.min_row << ", " << box.min_column << ") to (" << box.max_row << ", " << box.max_column << "), expected ("
+			<< expected_box.min_row << ", " << expected_box.min_column << ") to (" << expected_box.max_row << ", " << expected_box.max_column << ")" << std::endl;
+	}
+	return is_equal;
+}
+
+// runs the case through the reference and through one Grid per engine mode in lockstep. Returns false and prints the
+// first divergence if any Grid disagrees with the reference.
+bool verify_case(const Verify_Case& verify_case, const std::vector<Engine_Mode>& engine_modes) {
+	ZoneScopedFrame;
+
+	std::shared_ptr<OpenCLContext> opencl_context = std::make_shared < OpenCLContext > ();
+
+	Reference_Grid reference_grid;
+	std::vector<std::unique_ptr<Grid>> grids;
+	for (const Engine_Mode& engine_mode: engine_modes) {
+		std::unique_ptr<Grid> grid = std::make_unique < Grid > (opencl_context, false);
+		grid->set_number_of_threads(engine_mode.number_of_threads);
+		grid->minimum_number_of_chunks_per_task = engine_mode.minimum_number_of_chunks_per_task;
+		grid->should_update_coordinates_of_alive_cells = engine_mode.should_update_coordinates;
+		grid->temporal_block_size = engine_mode.temporal_block_size;
+		grids.push_back(std::move(grid));
+	}
+	for (auto [row, column]: verify_case.alive_cells) {
+		reference_grid.set_cell_alive(row, column);
+		for (std::unique_ptr<Grid>& grid: grids) {
+			grid->set_cell_alive(row, column);
+		}
+	}
+
+	// the expected cells of the last generations, a blocked Grid counts its births and deaths against the cells at the
+	// start of its block.
+	std::deque<std::vector<std::pair<int, int>>> previous_expected_cells;
+	for (std::size_t generation = 0; generation <= verify_case.number_of_generations; generation++) {
+		if (generation > 0) {
+			reference_grid.next_iteration();
+			for (std::unique_ptr<Grid>& grid: grids) {
+				if (grid->iteration < generation) {
+					grid->next_iteration();
+				}
+			}
+		}
+
+		std::vector<std::pair<int, int>> expected_cells = reference_grid.get_alive_cells();
+		for (std::size_t i = 0; i < grids.size(); i++) {
+			const Engine_Mode& engine_mode = engine_modes[i];
+			if (grids[i]->iteration != generation) {
+				continue;
+			}
+			std::vector<std::pair<int, int>> cells = grids[i]->get_alive_cells();
+			if (cells != expected_cells) {
+				std::cout << "FAILED " << verify_case.description << ", mode " << engine_mode.name << ": first divergence at generation " << generation << std::endl;
+				print_difference(cells, expected_cells);
+				return false;
+			}
+			// the render coordinates only get extracted by next_iteration(), so there is nothing to check before.
+			if (engine_mode.should_update_coordinates && generation > 0) {
+				std::vector<std::pair<int, int>> render_cells = get_cells_from_render_coordinates(*grids[i]);
+				if (render_cells != expected_cells) {
+					std::cout << "FAILED " << verify_case.description << ", mode " << engine_mode.name << ": render coordinates diverge at generation " << generation << std::endl;
+					print_difference(render_cells, expected_cells);
+					return false;
+				}
+			}
+			// the statistics get reduced from the kernel counters by next_iteration(), from the cells at the start of its block.
+			std::size_t temporal_block_size = static_cast<std::size_t>(engine_mode.temporal_block_size);
+			if (generation > 0 && previous_expected_cells.size() >= temporal_block_size) {
+				const std::vector<std::pair<int, int>>& block_start_cells = previous_expected_cells[previous_expected_cells.size() - temporal_block_size];
+				if (!verify_generation_statistics(grids[i]->generation_statistics, block_start_cells, expected_cells)) {
+					std::cout << "FAILED " << verify_case.description << ", mode " << engine_mode.name << ": wrong generation statistics at generation " << generation << std::endl;
+					return false;
+				}
+			}
+		}
+		bool is_dead = expected_cells.empty();
+		previous_expected_cells.push_back(std::move(expected_cells));
+		if (previous_expected_cells.size() > MAXIMUM_TEMPORAL_BLOCK_SIZE) {
+			previous_expected_cells.pop_front();
+		}
+		if (is_dead) {
+			// everything died out in the reference and in every Grid.
+			break;
+		}
+	}
+	return true;
+}
+
+//--------------------------------------------------------------------------------
+// checks every chunk kernel against scalar neighbour counting on random chunks and random neighbour borders.
+bool verify_chunk_kernels(const Verify_Options& options) {
+	ZoneScopedFrame;
+
+	std::mt19937 random_engine(options.seed);
+	std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+	const std::array<float, 5> densities = { 0.0f, 0.02f, 0.3f, 0.5f, 1.0f };
+
+	auto fail = [](int case_index, const std::string& kernel, int r, int c, int value, int expected_value) {
+		std::cout << "FAILED kernel " << kernel << " on random chunk " << case_index << ": cell (" << r << ", " << c << ") is " << value << ", expected " << expected_value << std::endl;
+		return false;
+	};
+
+	constexpr int N = Chunk::rows;
+	for (int case_index = 0; case_index < options.number_of_kernel_cases; case_index++) {
+		float density = densities[case_index % densities.size()];
+		if (case_index % (densities.size() + 1) == densities.size()) {
+			density = distribution(random_engine);
+		}
+
+		Chunk chunk(Coordinate(0, 0), Coordinate(case_index * N, -case_index * N), {});
+		std::array<unsigned char, N*N> cells = {};
+		for (int i = 0; i < N*N; i++) {
+			cells[i] = distribution(random_engine) < density ? 0xFF : 0;
+		}
+		chunk.cells_data = cells;
+
+		// the inside neighbour counts.
+		std::array<int, N*N> expected_counts = {};
+		for (int r = 0; r < N; r++) {
+			for (int c = 0; c < N; c++) {
+				for (int dr = -1; dr <= 1; dr++) {
+					for (int dc = -1; dc <= 1; dc++) {
+						int nr = r + dr;
+						int nc = c + dc;
+						if ((dr != 0 || dc != 0) && nr >= 0 && nr < N && nc >= 0 && nc < N && cells[nr*N + nc]) {
+							expected_counts[r*N + c]++;
+						}
+					}
+				}
+			}
+		}
+		chunk.update_neighbour_count_inside();
+		for (int i = 0; i < N*N; i++) {
+			if (chunk.neighbour_count_data[i] != expected_counts[i]) {
+				return fail(case_index, "update_neighbour_count_inside", i / N, i % N, chunk.neighbour_count_data[i], expected_counts[i]);
+			}
+		}
+
+		// the borders of the 8 neighbour chunks.
+		std::array<std::array<unsigned char, N>, 4> sides;
+		for (std::array<unsigned char, N>& side: sides) {
+			for (int i = 0; i < N; i++) {
+				side[i] = distribution(random_engine) < density ? 0xFF : 0;
+			}
+		}
+		std::array<bool, 4> corners;
+		for (bool& corner: corners) {
+			corner = distribution(random_engine) < density;
+		}
+		for (int i = 0; i < N; i++) {
+			for (int d = -1; d <= 1; d++) {
+				int j = i + d;
+				if (j < 0 || j >= N) {
+					continue;
+				}
+				expected_counts[j*N + 0] += sides[0][i] ? 1 : 0;
+				expected_counts[j*N + N - 1] += sides[1][i] ? 1 : 0;
+				expected_counts[0*N + j] += sides[2][i] ? 1 : 0;
+				expected_counts[(N - 1)*N + j] += sides[3][i] ? 1 : 0;
+			}
+		}
+		expected_counts[0] += corners[0] ? 1 : 0;
+		expected_counts[N - 1] += corners[1] ? 1 : 0;
+		expected_counts[(N - 1)*N] += corners[2] ? 1 : 0;
+		expected_counts[(N - 1)*N + N - 1] += corners[3] ? 1 : 0;
+
+		chunk.update_neighbour_count_left_side(sides[0]);
+		chunk.update_neighbour_count_right_side(sides[1]);
+		chunk.update_neighbour_count_top_side(sides[2]);
+		chunk.update_neighbour_count_bottom_side(sides[3]);
+		if (corners[0]) chunk.update_neighbour_count_top_left_corner();
+		if (corners[1]) chunk.update_neighbour_count_top_right_corner();
+		if (corners[2]) chunk.update_neighbour_count_bottom_left_corner();
+		if (corners[3]) chunk.update_neighbour_count_bottom_right_corner();
+		for (int i = 0; i < N*N; i++) {
+			if (chunk.neighbour_count_data[i] != expected_counts[i]) {
+				return fail(case_index, "side and corner updates", i / N, i % N, chunk.neighbour_count_data[i], expected_counts[i]);
+			}
+		}
+
+		// the rules.
+		std::array<unsigned char, N*N> expected_cells = {};
+		bool expected_has_alive_cells = false;
+		unsigned int expected_population = 0;
+		unsigned int expected_number_of_births = 0;
+		unsigned int expected_number_of_deaths = 0;
+		std::uint32_t expected_row_occupancy_mask = 0;
+		std::uint32_t expected_column_occupancy_mask = 0;
+		for (int i = 0; i < N*N; i++) {
+			bool is_alive = expected_counts[i] == 3 || (cells[i] && expected_counts[i] == 2);
+			expected_cells[i] = is_alive ? 0xFF : 0;
+			expected_has_alive_cells |= is_alive;
+			expected_population += is_alive ? 1 : 0;
+			expected_number_of_births += is_alive && !cells[i] ? 1 : 0;
+			expected_number_of_deaths += !is_alive && cells[i] ? 1 : 0;
+			expected_row_occupancy_mask |= (is_alive ? 1u : 0u) << (i / N);
+			expected_column_occupancy_mask |= (is_alive ? 1u : 0u) << (i % N);
+		}
+		chunk.update_cells();
+		for (int i = 0; i < N*N; i++) {
+			if (chunk.cells_data[i] != expected_cells[i]) {
+				return fail(case_index, "update_cells", i / N, i % N, chunk.cells_data[i], expected_cells[i]);
+			}
+		}
+		if (chunk.has_alive_cells != expected_has_alive_cells) {
+			std::cout << "FAILED kernel update_cells on random chunk " << case_index << ": has_alive_cells is " << chunk.has_alive_cells << std::endl;
+			return false;
+		}
+		if (chunk.population != expected_population || chunk.number_of_births != expected_number_of_births || chunk.number_of_deaths != expected_number_of_deaths) {
+			std::cout << "FAILED kernel update_cells on random chunk " << case_index << ": population " << chunk.population << ", births " << chunk.number_of_births << ", deaths " << chunk.number_of_deaths
+				<< ", expected " << expected_population << ", " << expected_number_of_births << ", " << expected_number_of_deaths << std::endl;
+			return false;
+		}
+		if (chunk.row_occupancy_mask != expected_row_occupancy_mask || chunk.column_occupancy_mask != expected_column_occupancy_mask) {
+			std::cout << "FAILED kernel update_cells on random chunk " << case_index << ": occupancy masks " << std::hex << chunk.row_occupancy_mask << ", " << chunk.column_occupancy_mask
+				<< ", expected " << expected_row_occupancy_mask << ", " << expected_column_occupancy_mask << std::dec << std::endl;
+			return false;
+		}
+
+		// the render coordinates, in row major order.
+		chunk.update_coordinates_of_alive_cells();
+		unsigned int number_of_alive_cells = 0;
+		for (int i = 0; i < N*N; i++) {
+			if (!expected_cells[i]) {
+				continue;
+			}
+			std::pair<int, int> expected_coordinate = std::make_pair(i % N + chunk.chunk_origin_column, -(i / N + chunk.chunk_origin_row));
+			if (number_of_alive_cells >= chunk.number_of_alive_cells || chunk.coordinates_of_alive_cells[number_of_alive_cells] != expected_coordinate) {
+				std::cout << "FAILED kernel update_coordinates_of_alive_cells on random chunk " << case_index << ": wrong coordinate for cell (" << i / N << ", " << i % N << ")" << std::endl;
+				return false;
+			}
+			number_of_alive_cells++;
+		}
+		if (number_of_alive_cells != chunk.number_of_alive_cells) {
+			std::cout << "FAILED kernel update_coordinates_of_alive_cells on random chunk " << case_index << ": " << chunk.number_of_alive_cells << " coordinates, expected " << number_of_alive_cells << std::endl;
+			return false;
+		}
+	}
+	std::cout << "chunk kernels: " << options.number_of_kernel_cases << " random chunks ok" << std::endl;
+	return true;
+}
+
+//--------------------------------------------------------------------------------
+std::vector<Corpus_Entry> get_corpus() {
+	// sorted by pattern and generation, each pattern gets simulated once up to its last entry.
+	return {
+		{ "r-pentomino", 0, 5, 0xd157d2952c09e67full },
+		{ "r-pentomino", 1103, 116, 0xcc9bb97e88efd1dull },
+		{ "r-pentomino", 2000, 116, 0x6791e5599829444eull },
+		{ "acorn", 5206, 633, 0xc219227301a0c572ull },
+		{ "diehard", 129, 2, 0x085393f24f3dca13ull },
+		{ "diehard", 130, 0, 0x0ull },
+		// the glider moves one cell down and right every 4 generations.
+		{ "glider", 4, 5, 0x52d79229ffc4eba0ull },
+		{ "glider", 1000, 5, 0x121cc3f7bed7b7b6ull },
+		{ "gosper-gun", 0, 36, 0x9393de30ec00113bull },
+		{ "gosper-gun", 30, 41, 0x6bd3c0715add5218ull },
+		{ "gosper-gun", 600, 136, 0x8d949c41e33844bcull }
+	};
+}
+
+bool verify_corpus(const std::vector<Engine_Mode>& engine_modes, bool should_print_corpus) {
+	ZoneScopedFrame;
+
+	std::shared_ptr<OpenCLContext> opencl_context = std::make_shared < OpenCLContext > ();
+	std::vector<Corpus_Entry> corpus = get_corpus();
+
+	bool is_valid = true;
+	std::size_t entry_index = 0;
+	while (entry_index < corpus.size()) {
+		const std::string& pattern = corpus[entry_index].pattern;
+
+		Reference_Grid reference_grid;
+		std::vector<std::unique_ptr<Grid>> grids;
+		for (const Engine_Mode& engine_mode: engine_modes) {
+			std::unique_ptr<Grid> grid = std::make_unique < Grid > (opencl_context, false);
+			grid->set_number_of_threads(engine_mode.number_of_threads);
+			grid->minimum_number_of_chunks_per_task = engine_mode.minimum_number_of_chunks_per_task;
+			grid->should_update_coordinates_of_alive_cells = engine_mode.should_update_coordinates;
+			grid->temporal_block_size = engine_mode.temporal_block_size;
+			grids.push_back(std::move(grid));
+		}
+		for (auto [row, column]: get_pattern_cells(pattern)) {
+			reference_grid.set_cell_alive(row, column);
+			for (std::unique_ptr<Grid>& grid: grids) {
+				grid->set_cell_alive(row, column);
+			}
+		}
+
+		std::size_t generation = 0;
+		for (; entry_index < corpus.size() && corpus[entry_index].pattern == pattern; entry_index++) {
+			const Corpus_Entry& entry = corpus[entry_index];
+			for (; generation < entry.generation; generation++) {
+				reference_grid.next_iteration();
+			}
+			// the blocked modes shrink their last block to land on the generation of the entry.
+			for (std::size_t i = 0; i < grids.size(); i++) {
+				while (grids[i]->iteration < entry.generation) {
+					grids[i]->temporal_block_size = static_cast<int>(std::min<std::size_t>(engine_modes[i].temporal_block_size, entry.generation - grids[i]->iteration));
+					grids[i]->next_iteration();
+				}
+			}
+
+			std::size_t reference_population = reference_grid.alive_cells.size();
+			std::uint64_t reference_checksum = reference_grid.compute_checksum();
+			if (should_print_corpus) {
+				std::cout << "{ \"" << entry.pattern << "\", " << entry.generation << ", " << reference_population
+					<< ", 0x" << std::hex << reference_checksum << std::dec << "ull }" << std::endl;
+			}
+
+			auto check = [&entry, &is_valid](const std::string& engine, std::size_t population, std::uint64_t checksum) {
+				if (population != entry.population || checksum != entry.checksum) {
+					std::cout << "FAILED corpus " << entry.pattern << " at generation " << entry.generation << ", " << engine
+						<< ": population " << population << ", checksum " << std::hex << checksum
+						<< ", expected population " << std::dec << entry.population << ", checksum " << std::hex << entry.checksum << std::dec << std::endl;
+					is_valid = false;
+				}
+			};
+			check("reference", reference_population, reference_checksum);
+			for (std::size_t i = 0; i < grids.size(); i++) {
+				check("mode " + engine_modes[i].name, grids[i]->count_alive_cells(), grids[i]->compute_checksum());
+			}
+		}
+	}
+	if (is_valid) {
+		std::cout << "corpus: " << corpus.size() << " known states ok" << std::endl;
+	}
+	return is_valid;
+}
+
+//--------------------------------------------------------------------------------
+// records a soup, seeks to random generations and compares their checksums with the original run. Then seeks back,
+// continues from there and checks that the rerecorded future matches as well. A small budget makes the history drop
+// its oldest keyframe groups along the way.
+bool verify_history(const Verify_Options& options) {
+	ZoneScopedFrame;
+
+	constexpr std::size_t KEYFRAME_INTERVAL = 50;
+	constexpr std::size_t MEMORY_BUDGET_BYTES = 1 << 20;
+
+	std::shared_ptr<OpenCLContext> opencl_context = std::make_shared < OpenCLContext > ();
+	Grid grid(opencl_context, false);
+	grid.should_update_coordinates_of_alive_cells = false;
+	grid.create_random_soup(256, 0.4f, options.seed);
+
+	Grid_History history(KEYFRAME_INTERVAL, MEMORY_BUDGET_BYTES);
+	std::vector<std::uint64_t> checksums;
+	for (std::size_t generation = 0; generation <= options.history_generations; generation++) {
+		if (generation > 0) {
+			grid.next_iteration();
+		}
+		history.record(grid);
+		checksums.push_back(grid.compute_checksum());
+	}
+
+	History_Statistics statistics = history.get_statistics();
+	if (statistics.last_iteration != options.history_generations || statistics.memory_bytes > MEMORY_BUDGET_BYTES + (1 << 18)) {
+		std::cout << "history: unexpected statistics, iterations " << statistics.first_iteration << ".." << statistics.last_iteration << ", " << statistics.memory_bytes << " bytes" << std::endl;
+		return false;
+	}
+
+	// checks the restored generation against the original run.
+	auto verify_seek = [&](std::size_t generation) {
+		Grid restored_grid(opencl_context, false);
+		std::string error_message;
+		if (!history.restore(generation, restored_grid, error_message)) {
+			std::cout << "history: seek to generation " << generation << " failed: " << error_message << std::endl;
+			return false;
+		}
+		restored_grid.finish_pattern_creation();
+		if (restored_grid.iteration != generation || restored_grid.compute_checksum() != checksums[generation]) {
+			std::cout << "history: seek to generation " << generation << " restored generation " << restored_grid.iteration << " with checksum "
+				<< std::hex << restored_grid.compute_checksum() << ", expected " << checksums[generation] << std::dec << std::endl;
+			return false;
+		}
+		return true;
+	};
+
+	std::mt19937 random_engine(options.seed);
+	std::uniform_int_distribution<std::size_t> generation_distribution(statistics.first_iteration, statistics.last_iteration);
+	for (int i = 0; i < 50; i++) {
+		if (!verify_seek(generation_distribution(random_engine))) {
+			return false;
+		}
+	}
+	std::string error_message;
+	if (statistics.first_iteration > 0 && history.restore(statistics.first_iteration - 1, grid, error_message)) {
+		std::cout << "history: seek to dropped generation " << statistics.first_iteration - 1 << " succeeded" << std::endl;
+		return false;
+	}
+
+	// go back in time and record the future again, it has to be the same.
+	std::size_t seek_generation = generation_distribution(random_engine);
+	Grid continued_grid(opencl_context, false);
+	continued_grid.should_update_coordinates_of_alive_cells = false;
+	if (!history.restore(seek_generation, continued_grid, error_message)) {
+		std::cout << "history: seek back to generation " << seek_generation << " failed: " << error_message << std::endl;
+		return false;
+	}
+	continued_grid.finish_pattern_creation();
+	history.record(continued_grid);
+	while (continued_grid.iteration < options.history_generations) {
+		continued_grid.next_iteration();
+		history.record(continued_grid);
+	}
+	for (std::size_t generation = std::max(seek_generation, history.get_statistics().first_iteration); generation <= options.history_generations; generation++) {
+		if (!verify_seek(generation)) {
+			std::cout << "history: after seeking back to generation " << seek_generation << std::endl;
+			return false;
+		}
+	}
+
+	std::cout << "history: " << statistics.number_of_frames << " generations (" << statistics.number_of_keyframes << " keyframes) in "
+		<< statistics.memory_bytes / 1024 << " KB instead of " << static_cast<std::size_t>(statistics.uncompressed_bytes / 1024) << " KB, seeks ok" << std::endl;
+	return true;
+}
+
+//--------------------------------------------------------------------------------
+bool write_text_file(const std::filesystem::path& path, const std::string& text) {
+	std::ofstream file(path, std::ios::binary);
+	file << text;
+	return static_cast<bool>(file);
+}
+
+// writes the Gosper gun as RLE, plaintext and Life 1.06, loads each file and compares it after a few hundred generations
+// with the built in pattern. Then checks that malformed files get rejected instead of loaded.
+bool verify_pattern_files(const std::filesystem::path& directory) {
+	ZoneScopedFrame;
+
+	constexpr std::size_t NUMBER_OF_GENERATIONS = 300;
+
+	std::shared_ptr<OpenCLContext> opencl_context = std::make_shared < OpenCLContext > ();
+	std::vector<std::pair<int, int>> cells = get_pattern_cells("gosper-gun");
+	Grid expected_grid(opencl_context, false);
+	expected_grid.should_update_coordinates_of_alive_cells = false;
+	for (auto [row, column]: cells) {
+		expected_grid.set_cell_alive(row, column);
+	}
+	expected_grid.finish_pattern_creation();
+	while (expected_grid.iteration < NUMBER_OF_GENERATIONS) {
+		expected_grid.next_iteration();
+	}
+
+	// the pattern has its top left corner at (0, 0), which is where the RLE and plaintext loaders put it.
+	int number_of_rows = 0;
+	int number_of_columns = 0;
+	for (auto [row, column]: cells) {
+		number_of_rows = std::max(number_of_rows, row + 1);
+		number_of_columns = std::max(number_of_columns, column + 1);
+	}
+	std::vector<std::string> rows(number_of_rows, std::string(number_of_columns, '.'));
+	for (auto [row, column]: cells) {
+		rows[row][column] = 'O';
+	}
+
+	std::string plaintext = "!Name: Gosper glider gun\n";
+	for (const std::string& row: rows) {
+		plaintext += row + "\n";
+	}
+
+	// runs of dead and alive cells, trailing dead cells left out, wrapped like Golly does after 70 characters.
+	std::string rle = "#C Gosper glider gun\nx = " + std::to_string(number_of_columns) + ", y = " + std::to_string(number_of_rows) + ", rule = B3/S23\n";
+	std::string runs;
+	for (std::size_t r = 0; r < rows.size(); r++) {
+		std::string row = rows[r].substr(0, rows[r].find_last_of('O') + 1);
+		for (std::size_t c = 0; c < row.size();) {
+			std::size_t run_end = row.find_first_not_of(row[c], c);
+			std::size_t length = (run_end == std::string::npos ? row.size() : run_end) - c;
+			runs += (length > 1 ? std::to_string(length) : "") + (row[c] == 'O' ? "o" : "b");
+			c += length;
+		}
+		runs += r + 1 < rows.size() ? "$" : "!";
+	}
+	for (std::size_t i = 0; i < runs.size(); i += 70) {
+		rle += runs.substr(i, 70) + "\n";
+	}
+
+	std::string life_106 = "#Life 1.06\n";
+	for (auto [row, column]: cells) {
+		life_106 += std::to_string(column) + " " + std::to_string(row) + "\n";
+	}
+
+	struct Pattern_File {
+		std::string name;
+		std::string text;
+		// false if loading has to fail.
+		bool is_valid;
+	};
+	std::vector<Pattern_File> pattern_files = {
+		{ "gosper-gun.rle", rle, true },
+		{ "gosper-gun.cells", plaintext, true },
+		{ "gosper-gun.lif", life_106, true },
+		{ "empty.rle", "", false },
+		{ "bad-rule.rle", "x = 3, y = 1, rule = B36/S23\n3o!\n", false },
+		{ "bad-header.rle", "#C no header\n3o!\n", false },
+		{ "far-away-column.rle", "x = 1, y = 1\n1073741824bo!\n", false },
+		{ "far-away-row.rle", "x = 1, y = 1\n1073741824$o!\n", false },
+		{ "far-away.lif", "#Life 1.06\n0 0\n0 -1073741825\n", false },
+		{ "not-a-cell.cells", ".O.\n.X.\n", false }
+	};
+	for (const Pattern_File& pattern_file: pattern_files) {
+		std::filesystem::path path = directory / pattern_file.name;
+		if (!write_text_file(path, pattern_file.text)) {
+			std::cout << "pattern files: could not write " << path.string() << std::endl;
+			return false;
+		}
+		Grid grid(opencl_context, false);
+		grid.should_update_coordinates_of_alive_cells = false;
+		std::string error_message;
+		bool is_loaded = load_pattern_file(path.string(), grid, error_message);
+		if (!pattern_file.is_valid) {
+			if (is_loaded) {
+				std::cout << "pattern files: malformed " << pattern_file.name << " got loaded" << std::endl;
+				return false;
+			}
+			continue;
+		}
+		if (!is_loaded) {
+			std::cout << "pattern files: " << error_message << std::endl;
+			return false;
+		}
+		while (grid.iteration < NUMBER_OF_GENERATIONS) {
+			grid.next_iteration();
+		}
+		if (grid.count_alive_cells() != expected_grid.count_alive_cells() || grid.compute_checksum() != expected_grid.compute_checksum()) {
+			std::cout << "pattern files: " << pattern_file.name << " at generation " << NUMBER_OF_GENERATIONS << " has population " << grid.count_alive_cells()
+				<< " and checksum " << std::hex << grid.compute_checksum() << ", expected " << std::dec << expected_grid.count_alive_cells()
+				<< " and " << std::hex << expected_grid.compute_checksum() << std::dec << std::endl;
+			return false;
+		}
+	}
+	std::cout << "pattern files: " << pattern_files.size() << " files ok" << std::endl;
+	return true;
+}
+
+// saves a soup as macrocell file, loads it again and compares it after a few hundred generations with the soup itself.
+// Nodes that refer to missing nodes or to nodes of the wrong level have to be rejected.
+bool verify_macrocell_files(const std::filesystem::path& directory, std::uint32_t seed) {
+	ZoneScopedFrame;
+
+	constexpr std::size_t NUMBER_OF_GENERATIONS = 300;
+
+	std::shared_ptr<OpenCLContext> opencl_context = std::make_shared < OpenCLContext > ();
+	Grid grid(opencl_context, false);
+	grid.should_update_coordinates_of_alive_cells = false;
+	grid.create_random_soup(200, 0.4f, seed);
+	std::string path = (directory / "soup.mc").string();
+	std::string error_message;
+	if (!save_macrocell_file(path, grid, error_message)) {
+		std::cout << "macrocell files: " << error_message << std::endl;
+		return false;
+	}
+	Grid loaded_grid(opencl_context, false);
+	loaded_grid.should_update_coordinates_of_alive_cells = false;
+	if (!load_pattern_file(path, loaded_grid, error_message)) {
+		std::cout << "macrocell files: " << error_message << std::endl;
+		return false;
+	}
+	while (grid.iteration < NUMBER_OF_GENERATIONS) {
+		grid.next_iteration();
+	}
+	while (loaded_grid.iteration < NUMBER_OF_GENERATIONS) {
+		loaded_grid.next_iteration();
+	}
+	if (loaded_grid.count_alive_cells() != grid.count_alive_cells() || loaded_grid.compute_checksum() != grid.compute_checksum()) {
+		std::cout << "macrocell files: reloaded soup at generation " << NUMBER_OF_GENERATIONS << " has population " << loaded_grid.count_alive_cells()
+			<< " and checksum " << std::hex << loaded_grid.compute_checksum() << ", expected " << std::dec << grid.count_alive_cells()
+			<< " and " << std::hex << grid.compute_checksum() << std::dec << std::endl;
+		return false;
+	}
+
+	std::vector<std::pair<std::string, std::string>> malformed_files = {
+		{ "forward-reference.mc", "[M2]\n.*$\n4 1 2 0 0\n" },
+		{ "wrong-level.mc", "[M2]\n.*$\n5 1 0 0 0\n" }
+	};
+	for (const auto& [name, text]: malformed_files) {
+		std::filesystem::path malformed_path = directory / name;
+		if (!write_text_file(malformed_path, text)) {
+			std::cout << "macrocell files: could not write " << malformed_path.string() << std::endl;
+			return false;
+		}
+		Grid malformed_grid(opencl_context, false);
+		if (load_pattern_file(malformed_path.string(), malformed_grid, error_message)) {
+			std::cout << "macrocell files: malformed " << name << " got loaded" << std::endl;
+			return false;
+		}
+	}
+	std::cout << "macrocell files: round trip and " << malformed_files.size() << " malformed files ok" << std::endl;
+	return true;
+}
+
+// saves a soup in the middle of its run as snapshot, loads it again and checks that it continues exactly like the soup.
+// Then damages the file in every way the loader checks for, each of them has to be rejected.
+bool verify_snapshot_files(const std::filesystem::path& directory, std::uint32_t seed) {
+	ZoneScopedFrame;
+
+	constexpr std::size_t SAVED_GENERATION = 100;
+	constexpr std::size_t NUMBER_OF_GENERATIONS = 300;
+
+	std::shared_ptr<OpenCLContext> opencl_context = std::make_shared < OpenCLContext > ();
+	Grid grid(opencl_context, false);
+	grid.should_update_coordinates_of_alive_cells = false;
+	grid.create_random_soup(200, 0.4f, seed);
+	while (grid.iteration < SAVED_GENERATION) {
+		grid.next_iteration();
+	}
+	std::string path = (directory / "soup.snap").string();
+	std::string error_message;
+	if (!save_grid_snapshot(path, grid, error_message)) {
+		std::cout << "snapshot files: " << error_message << std::endl;
+		return false;
+	}
+	Grid loaded_grid(opencl_context, false);
+	loaded_grid.should_update_coordinates_of_alive_cells = false;
+	if (!load_grid_snapshot(path, loaded_grid, error_message)) {
+		std::cout << "snapshot files: " << error_message << std::endl;
+		return false;
+	}
+	loaded_grid.finish_pattern_creation();
+	for (std::size_t generation = SAVED_GENERATION; generation <= NUMBER_OF_GENERATIONS; generation += NUMBER_OF_GENERATIONS - SAVED_GENERATION) {
+		while (grid.iteration < generation) {
+			grid.next_iteration();
+		}
+		while (loaded_grid.iteration < generation) {
+			loaded_grid.next_iteration();
+		}
+		if (loaded_grid.iteration != grid.iteration || loaded_grid.compute_checksum() != grid.compute_checksum()) {
+			std::cout << "snapshot files: reloaded soup at generation " << loaded_grid.iteration << " has checksum " << std::hex << loaded_grid.compute_checksum()
+				<< ", expected generation " << std::dec << grid.iteration << " with checksum " << std::hex << grid.compute_checksum() << std::dec << std::endl;
+			return false;
+		}
+	}
+
+	std::ifstream file(path, std::ios::binary);
+	std::string snapshot((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	Snapshot_Header header;
+	std::memcpy(&header, snapshot.data(), sizeof(Snapshot_Header));
+	if (header.number_of_chunks == 0) {
+		std::cout << "snapshot files: the soup died out before it got saved" << std::endl;
+		return false;
+	}
+	auto set_header_field = [](std::string& data, std::size_t offset, std::uint32_t value) {
+		std::memcpy(&data[offset], &value, sizeof(value));
+	};
+	std::vector<std::pair<std::string, std::string>> damaged_files(6, std::make_pair(std::string(), snapshot));
+	damaged_files[0].first = "bad-magic.snap";
+	damaged_files[0].second[0] = 'X';
+	damaged_files[1].first = "bad-version.snap";
+	set_header_field(damaged_files[1].second, offsetof(Snapshot_Header, version), SNAPSHOT_VERSION + 1);
+	damaged_files[2].first = "truncated-header.snap";
+	damaged_files[2].second.resize(sizeof(Snapshot_Header) / 2);
+	damaged_files[3].first = "truncated-bitmaps.snap";
+	damaged_files[3].second.resize(snapshot.size() - 1);
+	damaged_files[4].first = "invalid-cell.snap";
+	damaged_files[4].second[header.bitmaps_offset + SNAPSHOT_BITMAP_SIZE * (header.number_of_chunks - 1) + 37] = 0x01;
+	damaged_files[5].first = "bad-chunk-size.snap";
+	set_header_field(damaged_files[5].second, offsetof(Snapshot_Header, chunk_rows), 64);
+	for (const auto& [name, data]: damaged_files) {
+		std::filesystem::path damaged_path = directory / name;
+		if (!write_text_file(damaged_path, data)) {
+			std::cout << "snapshot files: could not write " << damaged_path.string() << std::endl;
+			return false;
+		}
+		Grid damaged_grid(opencl_context, false);
+		if (load_grid_snapshot(damaged_path.string(), damaged_grid, error_message)) {
+			std::cout << "snapshot files: damaged " << name << " got loaded" << std::endl;
+			return false;
+		}
+	}
+	std::cout << "snapshot files: round trip and " << damaged_files.size() << " damaged files ok" << std::endl;
+	return true;
+}
+
+//--------------------------------------------------------------------------------
+bool verify_checkpoints(const std::filesystem::path& directory, std::uint32_t seed) {
+	ZoneScopedFrame;
+
+	constexpr std::size_t NUMBER_OF_GENERATIONS = 240;
+	constexpr std::size_t CHECKPOINT_INTERVAL = 20;
+	// the captures of these generations get completed by a change of the pattern instead of the next generation.
+	constexpr std::size_t PATTERN_CHANGE_INTERVAL = 100;
+
+	std::shared_ptr<OpenCLContext> opencl_context = std::make_shared < OpenCLContext > ();
+	for (int temporal_block_size: { 1, 4 }) {
+		std::filesystem::path checkpoint_directory = directory / ("checkpoints-" + std::to_string(temporal_block_size));
+		Grid_Checkpoint_Settings settings;
+		settings.interval = CHECKPOINT_INTERVAL;
+		settings.retention = NUMBER_OF_GENERATIONS / CHECKPOINT_INTERVAL;
+		settings.directory = checkpoint_directory.string();
+
+		// the checksum of every generation a capture started at.
+		std::vector<std::pair<std::size_t, std::uint64_t>> expected_checksums;
+		{
+			Grid_Checkpointer checkpointer;
+			Grid grid(opencl_context, false);
+			grid.should_update_coordinates_of_alive_cells = false;
+			// small tasks, so that the copies happen in the parallel update tasks.
+			grid.minimum_number_of_chunks_per_task = 4;
+			grid.set_number_of_threads(4);
+			grid.temporal_block_size = temporal_block_size;
+			grid.create_random_soup(256, 0.4f, seed);
+			checkpointer.update(grid, settings);
+			while (grid.iteration < NUMBER_OF_GENERATIONS) {
+				grid.next_iteration();
+				if (checkpointer.update(grid, settings)) {
+					expected_checksums.push_back(std::make_pair(grid.iteration, grid.compute_checksum()));
+					if (grid.iteration % PATTERN_CHANGE_INTERVAL < static_cast<std::size_t>(temporal_block_size)) {
+						grid.set_cell_alive(static_cast<int>(grid.iteration), -1000);
+					}
+				}
+			}
+			// the last capture gets completed by the end of the run.
+			checkpointer.finish_capture(grid);
+			checkpointer.wait_until_idle();
+			Grid_Checkpoint_Status status = checkpointer.get_status();
+			if (!status.error_message.empty() || status.number_of_checkpoints != expected_checksums.size()) {
+				std::cout << "checkpoints: " << status.number_of_checkpoints << " of " << expected_checksums.size() << " written with temporal block size "
+					<< temporal_block_size << " " << status.error_message << std::endl;
+				return false;
+			}
+		}
+
+		for (const auto& [iteration, expected_checksum]: expected_checksums) {
+			char file_name[64];
+			std::snprintf(file_name, sizeof(file_name), "checkpoint_%012llu.snap", static_cast<unsigned long long>(iteration));
+			std::string path = (checkpoint_directory / file_name).string();
+			std::string error_message;
+			Grid loaded_grid(opencl_context, false);
+			loaded_grid.should_update_coordinates_of_alive_cells = false;
+			if (!load_grid_snapshot(path, loaded_grid, error_message)) {
+				std::cout << "checkpoints: " << error_message << std::endl;
+				return false;
+			}
+			loaded_grid.finish_pattern_creation();
+			if (loaded_grid.iteration != iteration || loaded_grid.compute_checksum() != expected_checksum) {
+				std::cout << "checkpoints: " << path << " holds generation " << loaded_grid.iteration << " with checksum " << std::hex << loaded_grid.compute_checksum()
+					<< ", expected generation " << std::dec << iteration << " with checksum " << std::hex << expected_checksum << std::dec << std::endl;
+				return false;
+			}
+		}
+		std::cout << "checkpoints: " << expected_checksums.size() << " copy-on-write checkpoints with temporal block size " << temporal_block_size << " ok" << std::endl;
+	}
+	return true;
+}
+
+// same as Grid::compute_checksum(), from the chunk bitmaps of the snapshot.
+std::uint64_t compute_render_snapshot_checksum(const Render_Snapshot& snapshot) {
+	std::uint64_t checksum = 0;
+	for (std::size_t i = 0; i < snapshot.chunk_bits.size(); i++) {
+		auto [origin_row, origin_column] = snapshot.chunk_origins[i];
+		for (int r = 0; r < Chunk::rows; r++) {
+			for (int c = 0; c < Chunk::columns; c++) {
+				if ((snapshot.chunk_bits[i][r] >> c) & 1) {
+					checksum += get_alive_cell_hash(origin_row + r, origin_column + c);
+				}
+			}
+		}
+	}
+	return checksum;
+}
+
+// drives Grid_Simulation_Thread through its command queue like the render loop does: loads a snapshot, steps it,
+// runs it and pauses it. Every Render_Snapshot taken from the triple buffer on the way has to match a grid which
+// runs the same generations synchronously.
+bool verify_simulation_thread(const std::filesystem::path& directory, std::uint32_t seed) {
+	ZoneScopedFrame;
+
+	constexpr std::size_t LOADED_GENERATION = 50;
+	constexpr int NUMBER_OF_STEPS = 10;
+	constexpr std::size_t MINIMUM_NUMBER_OF_RUN_GENERATIONS = 200;
+	constexpr auto TIMEOUT = std::chrono::seconds(30);
+	// the simulation thread publishes within a few milliseconds of the previous snapshot being taken while it runs, so
+	// no new snapshot for this long means it is paused.
+	constexpr auto PAUSED_TIME = std::chrono::milliseconds(250);
+
+	std::shared_ptr<OpenCLContext> opencl_context = std::make_shared < OpenCLContext > ();
+	std::unique_ptr<Grid> grid = std::make_unique < Grid > (opencl_context, false);
+	grid->should_update_coordinates_of_alive_cells = false;
+	grid->create_random_soup(128, 0.4f, seed);
+	while (grid->iteration < LOADED_GENERATION) {
+		grid->next_iteration();
+	}
+	std::string path = (directory / "simulation-thread.snap").string();
+	std::string error_message;
+	if (!save_grid_snapshot(path, *grid, error_message)) {
+		std::cout << "simulation thread: " << error_message << std::endl;
+		return false;
+	}
+
+	Grid_Simulation_Thread simulation_thread;
+	simulation_thread.start();
+	Grid_UI_Controls_Info ui_info;
+	ui_info.run_grid_at_max_possible_speed = true;
+	ui_info.number_of_grid_iterations_per_single_frame = 1;
+	std::copy(path.begin(), path.end(), ui_info.pattern_path.begin());
+	auto push_command = [&simulation_thread, &ui_info](Grid_UI_Control_Button_Events button_type) {
+		ui_info.button_type = button_type;
+		simulation_thread.push_command(ui_info);
+		ui_info.button_type = GRID_NO_BUTTON_PRESSED;
+	};
+
+	// takes every published snapshot, checks it against the synchronous grid and returns once the latest snapshot
+	// satisfies is_done. The generations of the snapshots only grow from the load on, so the synchronous grid just
+	// catches up.
+	bool is_valid = true;
+	auto check_snapshots_until = [&](auto is_done) {
+		auto start_time = std::chrono::steady_clock::now();
+		while (std::chrono::steady_clock::now() - start_time < TIMEOUT) {
+			bool has_new_snapshot = simulation_thread.update_render_snapshot();
+			const Render_Snapshot& snapshot = simulation_thread.get_render_snapshot();
+			if (!has_new_snapshot) {
+				if (is_done(snapshot)) {
+					return true;
+				}
+				std::this_thread::sleep_for(std::chrono::microseconds(200));
+				continue;
+			}
+			std::size_t iteration = static_cast<std::size_t>(snapshot.grid_info.iteration);
+			if (iteration >= LOADED_GENERATION && iteration >= grid->iteration) {
+				while (grid->iteration < iteration) {
+					grid->next_iteration();
+				}
+				if (iteration == grid->iteration && compute_render_snapshot_checksum(snapshot) != grid->compute_checksum()) {
+					std::cout << "simulation thread: snapshot of generation " << iteration << " has checksum " << std::hex << compute_render_snapshot_checksum(snapshot)
+						<< ", expected " << grid->compute_checksum() << std::dec << std::endl;
+					is_valid = false;
+					return false;
+				}
+			}
+			if (is_done(snapshot)) {
+				return true;
+			}
+		}
+		std::cout << "simulation thread: timed out waiting for a snapshot" << std::endl;
+		is_valid = false;
+		return false;
+	};
+
+	// load: the reset replaces the default grid with the snapshot of generation 50. The synchronous grid starts over
+	// at the same point.
+	std::unique_ptr<Grid> loaded_grid = std::make_unique < Grid > (opencl_context, false);
+	if (!load_grid_snapshot(path, *loaded_grid, error_message)) {
+		std::cout << "simulation thread: " << error_message << std::endl;
+		return false;
+	}
+	grid = std::move(loaded_grid);
+	grid->should_update_coordinates_of_alive_cells = false;
+	grid->finish_pattern_creation();
+	push_command(GRID_RESET_BUTTON_PRESSED);
+	bool is_loaded = check_snapshots_until([](const Render_Snapshot& snapshot) {
+		return snapshot.grid_info.iteration == static_cast<int>(LOADED_GENERATION);
+	});
+
+	// step: one generation per command, each waits for its snapshot so that the commands do not get merged.
+	for (int i = 0; is_loaded && is_valid && i < NUMBER_OF_STEPS; i++) {
+		int next_iteration = static_cast<int>(LOADED_GENERATION) + i + 1;
+		push_command(GRID_NEXT_ITERATION_BUTTON_PRESSED);
+		check_snapshots_until([next_iteration](const Render_Snapshot& snapshot) {
+			return snapshot.grid_info.iteration == next_iteration;
+		});
+	}
+
+	// run and pause: the generation the pause lands on depends on the timing, the last snapshot has to match it anyway.
+	std::size_t paused_iteration = 0;
+	if (is_loaded && is_valid) {
+		push_command(GRID_START_STOP_BUTTON_PRESSED);
+		check_snapshots_until([](const Render_Snapshot& snapshot) {
+			return snapshot.grid_info.iteration >= static_cast<int>(LOADED_GENERATION + NUMBER_OF_STEPS + MINIMUM_NUMBER_OF_RUN_GENERATIONS);
+		});
+	}
+	if (is_loaded && is_valid) {
+		push_command(GRID_START_STOP_BUTTON_PRESSED);
+		auto last_snapshot_time = std::chrono::steady_clock::now();
+		std::size_t last_iteration = 0;
+		check_snapshots_until([&](const Render_Snapshot& snapshot) {
+			auto now = std::chrono::steady_clock::now();
+			if (static_cast<std::size_t>(snapshot.grid_info.iteration) != last_iteration) {
+				last_iteration = static_cast<std::size_t>(snapshot.grid_info.iteration);
+				last_snapshot_time = now;
+			}
+			if (now - last_snapshot_time > PAUSED_TIME) {
+				paused_iteration = last_iteration;
+				return true;
+			}
+			return false;
+		});
+	}
+	// a step after the pause only gets through if the grid really stopped, a running grid ignores it.
+	if (paused_iteration > 0 && is_valid) {
+		push_command(GRID_NEXT_ITERATION_BUTTON_PRESSED);
+		check_snapshots_until([paused_iteration](const Render_Snapshot& snapshot) {
+			return snapshot.grid_info.iteration == static_cast<int>(paused_iteration + 1);
+		});
+	}
+	simulation_thread.stop();
+	if (!is_loaded || !is_valid) {
+		std::cout << "simulation thread: failed after the grid reached generation " << grid->iteration << std::endl;
+		return false;
+	}
+	std::cout << "simulation thread: load, " << NUMBER_OF_STEPS << " steps, run and pause at generation " << paused_iteration << " ok" << std::endl;
+	return true;
+}
+
+//--------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+	Verify_Options options;
+	if (!parse_options(argc, argv, options)) {
+		print_usage();
+		return -1;
+	}
+
+	std::vector<Engine_Mode> engine_modes = get_engine_modes();
+	std::cout << "engine modes:";
+	for (const Engine_Mode& engine_mode: engine_modes) {
+		std::cout << " " << engine_mode.name;
+	}
+	std::cout << std::endl;
+
+	bool is_corpus_valid = verify_corpus(engine_modes, options.should_print_corpus);
+	if (!is_corpus_valid || options.should_only_verify_corpus) {
+		return is_corpus_valid ? 0 : 1;
+	}
+
+	if (!verify_chunk_kernels(options)) {
+		return 1;
+	}
+
+	if (!verify_history(options)) {
+		return 1;
+	}
+
+	// the files of the loader checks go into a directory of their own, which gets removed again if everything passed.
+	std::filesystem::path directory = std::filesystem::temp_directory_path() / ("grid_of_life_verify_" + std::to_string(options.seed));
+	std::error_code error_code;
+	std::filesystem::create_directories(directory, error_code);
+	if (!verify_pattern_files(directory) || !verify_macrocell_files(directory, options.seed) || !verify_snapshot_files(directory, options.seed)
+		|| !verify_checkpoints(directory, options.seed) || !verify_simulation_thread(directory, options.seed)) {
+		return 1;
+	}
+	std::filesystem::remove_all(directory, error_code);
+
+	std::mt19937 random_engine(options.seed);
+	for (int i = 0; i < options.number_of_soups; i++) {
+		Verify_Case soup_case = create_soup_case(i, random_engine, options.soup_generations);
+		if (!verify_case(soup_case, engine_modes)) {
+			std::cout << "rerun with the same options to reproduce" << std::endl;
+			return 1;
+		}
+	}
+	std::cout << "random soups: " << options.number_of_soups << " cases ok" << std::endl;
+
+	for (int i = 0; i < options.number_of_fuzz_cases; i++) {
+		Verify_Case fuzz_case = create_chunk_border_fuzz_case(i, random_engine, options.fuzz_generations);
+		if (!verify_case(fuzz_case, engine_modes)) {
+			std::cout << "rerun with the same options to reproduce" << std::endl;
+			return 1;
+		}
+	}
+	std::cout << "chunk border fuzz: " << options.number_of_fuzz_cases << " cases ok" << std::endl;
+
+	std::cout << "all checks passed" << std::endl;
+	return 0;
+}
@@ -4,15 +4,14 @@
 World::World() :
 	m_camera(nullptr),
 m_mouse(nullptr),
-m_window(nullptr),
-grid_manager(nullptr)
+m_window(nullptr)
 {
 
 }
 
 //--------------------------------------------------------------------------------
 void World::initialise(GLFWwindow* window) {
-	ZoneScoped;
+	ZoneScopedFrame;
 	m_window = window;
 
 	m_mouse = std::make_unique < Mouse > ();
@@ -22,16 +21,12 @@ void World::initialise(GLFWwindow* window) {
 	m_camera->position = glm::vec3(Chunk::rows / 2, Chunk::columns / 2, 1250.0f);
 
 	m_camera->target_position = glm::vec3(0.0f);
-
-	grid_manager = std::make_shared<Grid_Manager>();
 }
 
 
 //--------------------------------------------------------------------------------
-void World::update(double dt, const Grid_UI_Controls_Info& grid_ui_controls_info) {
-	ZoneScoped;
-
-	grid_manager->update(dt, grid_ui_controls_info);
+void World::update(double dt) {
+	ZoneScopedFrame;
 
 	process_input(dt);
 
@@ -40,7 +35,7 @@ void World::update(double dt, const Grid_UI_Controls_Info& grid_ui_controls_info
 
 //--------------------------------------------------------------------------------
 void World::process_input(double dt) {
-	ZoneScoped;
+	ZoneScopedFrame;
 	
 
 	if (glfwGetKey(m_window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <tracy/Tracy.hpp>
+#include "profiling.hpp"
 
 #include <vector>
 #include <iostream>
@@ -21,7 +21,7 @@ public:
 
 	void initialise(GLFWwindow*);
 
-	void update(double dt, const Grid_UI_Controls_Info& grid_ui_controls_info);
+	void update(double dt);
 
 	void process_input(double dt);
 	
@@ -31,6 +31,4 @@ public:
 	std::unique_ptr<Camera> m_camera;
 	std::unique_ptr<Mouse> m_mouse;
 	GLFWwindow* m_window;
-	
-	std::shared_ptr<Grid_Manager> grid_manager;
 };